@@ -199,7 +199,10 @@ void main()
 
     mat3 TBN = mat3(T,B,N);
 
-    vec3 texNormal = 2.0 * texture(sNormalMap, vInData.TexCoord).xyz - 1.0;
+    //Z is reconstructed, as block-compressed normal maps only store XY:
+    vec2 texNormalXY = 2.0 * texture(sNormalMap, vInData.TexCoord).xy - 1.0;
+    float texNormalZ = sqrt(max(1.0 - dot(texNormalXY, texNormalXY), 0.0));
+    vec3 texNormal = vec3(texNormalXY, texNormalZ);
 
     vec3 normal = normalize(TBN * texNormal);
 
@@ -90,7 +90,7 @@ void Application::Impl::Run()
         }
 
         // Reload the scene if necessary:
-        if (mScene.UpdateRequested())
+        if (mScene.UpdateRequested() || mScene.ObjectsChanged() || mScene.MeshesChanged())
             mRender.LoadScene(mScene);
 
         // Reload shaders if necessary:
@@ -1,34 +1,102 @@
 #include "AssetManager.h"
 #include "Pch.h"
 
+#include "CookedModel.h"
 #include "GltfImporter.h"
 #include "ModelConfig.h"
+#include "SyncQueue.h"
+#include "TextureCompressor.h"
 #include "ThreadPool.h"
 #include "Timer.h"
 #include "VertexLayout.h"
-#include "VertexPacking.h"
 
+#include <algorithm>
 #include <atomic>
+#include <format>
 #include <iostream>
 #include <memory>
 
+// Results of finished tasks, waiting to be committed to the scene
+// on the main thread:
+struct FinishedPrimitive {
+    SceneKey          Mesh;
+    size_t            Prim;
+    ImportedPrimitive Imported;
+};
+
 struct AssetManager::Model {
-    Model(const ModelConfig &config, bool &isReady)
-        : Config(config), IsReady(isReady), TasksLeft(0), StartTime(Timer::Now())
+    Model(ModelJobId id, int32_t priority, const ModelConfig &config,
+          SceneGraphNode &root, bool &isReady,
+          std::vector<PrimitiveDiagnostics> &diagnostics)
+        : Id(id), Priority(priority), Config(config), Root(root), IsReady(isReady),
+          Diagnostics(diagnostics), Stage(ModelStage::Queued), Cancelled(false),
+          TasksLeft(0), StartTime(Timer::Now())
     {
     }
 
-    ModelConfig                    Config;
-    bool                          &IsReady;
-    std::unique_ptr<GltfAsset>     Gltf;
-    std::vector<ImageTaskData>     ImgTasks;
-    std::vector<PrimitiveTaskData> PrimTasks;
-    std::map<size_t, SceneKey>     MeshKeyMap;
-    std::atomic_int64_t            TasksLeft;
-    Timer::TimePoint               StartTime;
+    ModelJobId                         Id;
+    int32_t                            Priority;
+    ModelConfig                        Config;
+    SceneGraphNode                    &Root;
+    bool                              &IsReady;
+    std::vector<PrimitiveDiagnostics> &Diagnostics;
+    std::unique_ptr<GltfAsset>         Gltf;
+    std::vector<ImageTaskData>         ImgTasks;
+    std::vector<PrimitiveTaskData>     PrimTasks;
+    std::map<size_t, SceneKey>         MatKeyMap;
+    std::map<size_t, SceneKey>         MeshKeyMap;
+    std::optional<CookedModel::Key>    CookedKey;
+    bool                               FromCooked = false;
+    SyncQueue<FinishedImage>           FinishedImages;
+    SyncQueue<FinishedPrimitive>       FinishedPrims;
+    std::atomic<ModelStage>            Stage;
+    std::atomic_bool                   Cancelled;
+    std::atomic_int64_t                TasksLeft;
+    OptimizationStats                  OptStats;
+    TangentBenchmark                   TangentBench;
+    EncodeStats                        Encoding;
+    Timer::TimePoint                   StartTime;
 };
 
-AssetManager::AssetManager(Scene &scene) : mScene(scene)
+static ImageData DecodeImage(const ImageTaskData &data, ThreadPool &pool)
+{
+    ImageData img;
+
+    if (!data.Embedded.empty())
+    {
+        if (data.Compress)
+            img = TextureCompressor::Import(data.Embedded, data.Usage, data.Unorm, pool);
+        else
+            img = ImageData::ImportImage(data.Embedded, data.Unorm);
+    }
+    else if (data.Path)
+    {
+        auto pathStr = data.Path->string();
+        auto path    = pathStr.c_str();
+
+        if (data.Compress)
+            img = TextureCompressor::Import(path, data.Usage, data.Unorm, pool);
+        else
+            img = ImageData::ImportImage(path, data.Unorm);
+    }
+    else
+        img = ImageData::SinglePixel(data.BaseColor, data.Unorm);
+
+    // Mips are computed here instead of with blits on the main thread:
+    img.GenerateMips(pool);
+
+    img.Name = data.Name;
+
+    return img;
+}
+
+static size_t CountDecodeTasks(const std::vector<ImageTaskData> &tasks)
+{
+    auto count = std::ranges::count_if(tasks, &ImageTaskData::NeedsDecode);
+    return static_cast<size_t>(count);
+}
+
+AssetManager::AssetManager(Scene &scene) : mScene(scene), mTextures(scene)
 {
     mThreadPool = std::make_unique<ThreadPool>();
 }
@@ -37,129 +105,490 @@ AssetManager::~AssetManager()
 {
 }
 
-void AssetManager::LoadModel(const ModelConfig &config, SceneGraphNode &root,
-                             bool &isReady)
+AssetManager::ModelJobId AssetManager::LoadModel(
+    const ModelConfig &config, SceneGraphNode &root, bool &isReady,
+    std::vector<PrimitiveDiagnostics> &diagnostics, int32_t priority)
+{
+    const auto id = mNextJobId++;
+
+    auto model =
+        std::make_unique<Model>(id, priority, config, root, isReady, diagnostics);
+
+    // Keep jobs sorted by priority, equal priorities stay in submission order:
+    auto it = std::ranges::find_if(
+        mModels, [priority](const auto &other) { return other->Priority < priority; });
+
+    mModels.insert(it, std::move(model));
+
+    return id;
+}
+
+void AssetManager::CancelModel(ModelJobId id)
 {
-    // 0. If already loading do nothing
-    if (mModelStage != ModelStage::Idle)
+    auto it = std::ranges::find_if(mModels,
+                                   [id](const auto &model) { return model->Id == id; });
+
+    if (it == mModels.end())
         return;
 
-    // 1. Update the state
-    mModelStage = ModelStage::Parsing;
-    mModel      = std::make_unique<Model>(config, isReady);
+    auto &model = **it;
 
-    // 2. Launch an async task to parse gltf and emplace new
-    // elements in the scene
-    mThreadPool->Push([this, &root]() {
-        PreprocessGltf(root);
-        mModelStage = ModelStage::Parsed;
-    });
+    // Nothing was emplaced in the scene yet:
+    if (model.Stage == ModelStage::Queued)
+    {
+        mModels.erase(it);
+        return;
+    }
+
+    // Remaining tasks will see the flag and skip their work:
+    model.Cancelled = true;
+}
+
+bool AssetManager::IsModelActive(ModelJobId id) const
+{
+    return std::ranges::any_of(mModels,
+                               [id](const auto &model) { return model->Id == id; });
 }
 
 void AssetManager::OnUpdate()
 {
-    // 3. Detect if there is work to be scheduled
-    if (mModelStage == ModelStage::Parsed)
+    // 1. Start queued jobs in priority order, if there are free slots:
+    auto activeCount = std::ranges::count_if(mModels, [](const auto &model) {
+        return model->Stage != ModelStage::Queued;
+    });
+
+    for (auto &model : mModels)
     {
-        mModelStage = ModelStage::Loading;
+        if (static_cast<size_t>(activeCount) >= MaxActiveModels)
+            break;
 
-        // 3.1. Schedule image loading:
-        for (auto &data : mModel->ImgTasks)
+        if (model->Stage == ModelStage::Queued)
         {
-            mThreadPool->Push([this, &data]() {
-                auto &img = mScene.Images[data.ImageKey];
+            StartModel(*model);
+            activeCount++;
+        }
+    }
 
-                if (data.Path)
-                {
-                    auto pathStr = data.Path->string();
-                    img          = ImageData::ImportImage(pathStr.c_str(), data.Unorm);
-                }
-                else
-                    img = ImageData::SinglePixel(data.BaseColor, data.Unorm);
+    // Commit budget is shared by all the models:
+    size_t budget = CommitBudget;
 
-                img.Name = data.Name;
+    for (auto &model : mModels)
+    {
+        // 2. Detect if there is work to be scheduled
+        if (model->Stage == ModelStage::Parsed)
+            ScheduleModelTasks(*model);
 
-                mModel->TasksLeft--;
-            });
+        if (model->Stage != ModelStage::Loading)
+            continue;
+
+        // 3. In progressive mode move finished results to the scene every frame
+        if (model->Config.Progressive)
+            budget -= std::min(budget, CommitResults(*model, budget));
+
+        // 4. Detect if loading done
+        const bool pending = model->Config.Progressive && HasPendingResults(*model);
+
+        if (model->TasksLeft == 0 && !pending)
+            FinishModel(*model);
+    }
+
+    // 5. Commit images finished on behalf of discarded models:
+    CommitOrphanedImages();
+
+    // 6. Free model and task-related memory:
+    std::erase_if(mModels,
+                  [](const auto &model) { return model->Stage == ModelStage::Done; });
+}
+
+void AssetManager::StartModel(Model &model)
+{
+    model.Stage = ModelStage::Parsing;
+
+    // Launch an async task to parse gltf (or read its cooked version)
+    // and emplace new elements in the scene
+    mThreadPool->Push([this, &model]() {
+        // Nothing is emplaced for files that fail to load, so they
+        // are discarded like jobs cancelled while parsing:
+        if (!LoadCooked(model) && !PreprocessGltf(model))
+            model.Cancelled = true;
+
+        model.Stage = ModelStage::Parsed;
+    });
+}
+
+void AssetManager::ScheduleModelTasks(Model &model)
+{
+    model.Stage = ModelStage::Loading;
+
+    // Cancelled while parsing, no need to schedule anything:
+    if (model.Cancelled)
+    {
+        model.TasksLeft = 0;
+        return;
+    }
+
+    // In progressive mode the hierarchy can be instanced right away. Primitives
+    // show up as they are committed, until then materials use the renderer's
+    // placeholder textures (and cooked geometry is already complete):
+    if (model.Config.Progressive)
+    {
+        model.IsReady = true;
+
+        mScene.RequestUpdate(Scene::UpdateFlag::Meshes);
+        mScene.RequestUpdate(Scene::UpdateFlag::Materials);
+        mScene.RequestUpdate(Scene::UpdateFlag::MeshMaterials);
+        mScene.RequestUpdate(Scene::UpdateFlag::Objects);
+    }
+
+    // Schedule image loading (shared images are decoded by their first user):
+    for (auto &data : model.ImgTasks)
+    {
+        if (!data.NeedsDecode)
+            continue;
+
+        mThreadPool->Push([this, &model, &data]() {
+            if (!model.Cancelled)
+            {
+                auto img = DecodeImage(data, *mThreadPool);
+
+                model.FinishedImages.Push(FinishedImage{
+                    .Key  = data.ImageKey,
+                    .Data = std::move(img),
+                });
+            }
+
+            model.TasksLeft--;
+        });
+    }
+
+    // Schedule mesh parsing:
+    for (auto &data : model.PrimTasks)
+    {
+        mThreadPool->Push([this, &model, &data]() {
+            if (!model.Cancelled)
+            {
+                auto imported =
+                    model.Gltf->LoadGeometry(data, model.Config, *mThreadPool);
+
+                model.FinishedPrims.Push(FinishedPrimitive{
+                    .Mesh     = data.SceneMesh,
+                    .Prim     = data.ScenePrim,
+                    .Imported = std::move(imported),
+                });
+            }
+
+            model.TasksLeft--;
+        });
+    }
+}
+
+size_t AssetManager::CommitResults(Model &model, size_t budget)
+{
+    size_t committed = 0;
+    bool   newImages = false;
+
+    // Alternate between images and primitives, so that neither waits
+    // for the other when the budget is exceeded:
+    while (committed < budget)
+    {
+        auto img  = model.FinishedImages.TryPop();
+        auto prim = model.FinishedPrims.TryPop();
+
+        if (!img && !prim)
+            break;
+
+        // Other models may be emplacing concurrently:
+        auto lock = mScene.Lock();
+
+        // Elements erased in the meantime (e.g. in the editor) drop their results:
+        if (img)
+        {
+            committed += img->Data.Size;
+
+            if (auto *sceneImg = mScene.Images.Find(img->Key))
+            {
+                *sceneImg = std::move(img->Data);
+                newImages = true;
+            }
         }
 
-        // 3.2. Schedule mesh parsing:
-        for (auto &data : mModel->PrimTasks)
+        if (prim)
         {
-            mThreadPool->Push([this, &data]() {
-                auto &mesh = mScene.Meshes[data.SceneMesh];
-                auto &prim = mesh.Primitives[data.ScenePrim];
+            auto &data = prim->Imported.Data;
+            auto *mesh = mScene.Meshes.Find(prim->Mesh);
 
-                auto primDataRaw = mModel->Gltf->LoadPrimitive(data, mModel->Config);
+            committed += data.VertexData.Size + data.IndexData.Size;
 
-                prim.Data =
-                    VertexPacking::Encode(primDataRaw, mModel->Config.VertexLayout);
+            if (prim->Imported.Stats)
+                model.OptStats += *prim->Imported.Stats;
 
-                // For compressed layout store additional normalization data:
-                if (mModel->Config.VertexLayout == Vertex::PullLayout::Compressed)
-                {
-                    prim.BaseOffset = primDataRaw.BBox.Center;
-                    prim.BaseScale  = primDataRaw.BBox.Extent;
+            if (prim->Imported.TangentBench)
+                model.TangentBench += *prim->Imported.TangentBench;
 
-                    prim.TexCoordCenter = primDataRaw.TexBounds.Center;
-                    prim.TexCoordExtent = primDataRaw.TexBounds.Extent;
-                }
+            if (prim->Imported.Encoding)
+                model.Encoding += *prim->Imported.Encoding;
 
-                mModel->TasksLeft--;
-            });
+            if (prim->Imported.Diagnostics)
+                model.Diagnostics.push_back(std::move(*prim->Imported.Diagnostics));
+
+            if (mesh == nullptr)
+                continue;
+
+            auto &scenePrim = mesh->Primitives[prim->Prim];
+
+            // For compressed layout store additional normalization data:
+            if (model.Config.VertexLayout == Vertex::PullLayout::Compressed)
+            {
+                scenePrim.BaseOffset = data.BBox.Center;
+                scenePrim.BaseScale  = data.BBox.Extent;
+
+                scenePrim.TexCoordCenter = prim->Imported.TexBounds.Center;
+                scenePrim.TexCoordExtent = prim->Imported.TexBounds.Extent;
+            }
+
+            scenePrim.Data = std::move(data);
+
+            // Renderers upload only this mesh and update its objects:
+            mScene.MarkMeshModified(prim->Mesh);
         }
     }
 
-    // 4. Detect if loading done
-    if (mModelStage == ModelStage::Loading)
+    // Materials are reloaded to replace placeholders with new textures:
+    if (newImages)
     {
-        if (mModel->TasksLeft == 0)
+        mScene.RequestUpdate(Scene::UpdateFlag::Images);
+        mScene.RequestUpdate(Scene::UpdateFlag::Materials);
+    }
+
+    return committed;
+}
+
+void AssetManager::CommitOrphanedImages()
+{
+    bool newImages = false;
+
+    while (auto img = mOrphanedImages.TryPop())
+    {
+        auto lock = mScene.Lock();
+
+        if (auto *sceneImg = mScene.Images.Find(img->Key))
         {
-            mModelStage = ModelStage::Idle;
+            *sceneImg = std::move(img->Data);
+            newImages = true;
+        }
+    }
 
-            // Set scene update flags:
-            mScene.RequestUpdate(Scene::UpdateFlag::Images);
-            mScene.RequestUpdate(Scene::UpdateFlag::Meshes);
-            mScene.RequestUpdate(Scene::UpdateFlag::Materials);
-            mScene.RequestUpdate(Scene::UpdateFlag::MeshMaterials);
+    if (newImages)
+    {
+        mScene.RequestUpdate(Scene::UpdateFlag::Images);
+        mScene.RequestUpdate(Scene::UpdateFlag::Materials);
+    }
+}
 
-            // Mark prefab as ready:
-            mModel->IsReady = true;
+bool AssetManager::HasPendingResults(Model &model)
+{
+    return !model.FinishedImages.Empty() || !model.FinishedPrims.Empty();
+}
 
-            // Print message:
-            auto now  = Timer::Now();
-            auto time = Timer::GetDiffSeconds(now, mModel->StartTime);
-            std::cout << "Finished loading model (took " << time << " [s])\n";
+void AssetManager::FinishModel(Model &model)
+{
+    model.Stage = ModelStage::Done;
 
-            // Free model and task-related memory:
-            mModel.reset(nullptr);
+    if (model.Cancelled)
+    {
+        // Progressive models may already be instanced,
+        // so whatever was committed is kept:
+        if (model.IsReady)
+        {
+            std::cout << "Stopped loading model "
+                      << model.Config.Filepath.filename().string() << '\n';
+            return;
         }
+
+        DiscardModel(model);
+        return;
+    }
+
+    CommitResults(model, std::numeric_limits<size_t>::max());
+
+    // Set scene update flags:
+    mScene.RequestUpdate(Scene::UpdateFlag::Images);
+    mScene.RequestUpdate(Scene::UpdateFlag::Meshes);
+    mScene.RequestUpdate(Scene::UpdateFlag::Materials);
+    mScene.RequestUpdate(Scene::UpdateFlag::MeshMaterials);
+
+    // Mark prefab as ready:
+    model.IsReady = true;
+
+    // Print message:
+    auto now  = Timer::Now();
+    auto time = Timer::GetDiffSeconds(now, model.StartTime);
+    std::cout << "Finished loading model " << model.Config.Filepath.filename().string()
+              << " (took " << time << " [s])\n";
+
+    if (model.Config.OptimizeMeshes && !model.FromCooked)
+    {
+        const auto &stats = model.OptStats;
+
+        std::cout << std::format("Mesh optimization: vertices {} -> {}, ACMR {:.3f} -> "
+                                 "{:.3f}, ATVR {:.3f} -> {:.3f}\n",
+                                 stats.VerticesBefore, stats.VerticesAfter,
+                                 stats.AcmrBefore(), stats.AcmrAfter(),
+                                 stats.AtvrBefore(), stats.AtvrAfter());
+    }
+
+    if (model.Encoding.Vertices > 0)
+    {
+        const auto &enc = model.Encoding;
+
+        std::cout << std::format("Vertex encoding: {} vertices in {:.3f} [s] "
+                                 "({:.1f} M/s)\n",
+                                 enc.Vertices, enc.Seconds,
+                                 enc.VerticesPerSecond() / 1e6f);
+    }
+
+    if (model.Config.BenchmarkTangents && model.TangentBench.Vertices > 0)
+    {
+        const auto &bench = model.TangentBench;
+
+        std::cout << std::format("Tangents: fast {:.3f} [s], mikktspace {:.3f} [s], "
+                                 "angle mean {:.4f} max {:.4f} [deg], sign mismatches "
+                                 "{}/{}\n",
+                                 bench.FastSeconds, bench.MikkSeconds, bench.MeanAngle(),
+                                 bench.MaxAngle, bench.SignMismatches, bench.Vertices);
+    }
+
+    // Details were already logged per primitive:
+    if (!model.Diagnostics.empty())
+    {
+        std::cout << std::format("Import issues in {} primitive(s)\n",
+                                 model.Diagnostics.size());
+    }
+
+    // Store the imported data, so that next load can skip parsing:
+    if (model.CookedKey && !model.FromCooked)
+    {
+        CookedModel::Store(*model.CookedKey, mScene, model.Root, model.ImgTasks,
+                           model.MatKeyMap, model.MeshKeyMap);
     }
 }
 
-void AssetManager::PreprocessGltf(SceneGraphNode &root)
+void AssetManager::DiscardModel(Model &model)
+{
+    // Images this model was supposed to decode, but which are still
+    // referenced by other models:
+    std::vector<ImageTaskData> orphaned;
+    std::vector<SceneKey>      released;
+
+    // Registry entries are released before locking the scene. Acquiring
+    // takes the locks in this order too, emplacing images while the
+    // registry is locked:
+    for (const auto &task : model.ImgTasks)
+    {
+        if (mTextures.Release(task.ImageKey))
+            released.push_back(task.ImageKey);
+        else if (task.NeedsDecode)
+            orphaned.push_back(task);
+    }
+
+    {
+        auto lock = mScene.Lock();
+
+        for (auto imgKey : released)
+            mScene.Images.Erase(imgKey);
+
+        for (const auto &[_, matKey] : model.MatKeyMap)
+            mScene.Materials.Erase(matKey);
+
+        for (const auto &[_, meshKey] : model.MeshKeyMap)
+            mScene.Meshes.Erase(meshKey);
+    }
+
+    // Renderers may have picked up some of the elements already:
+    mScene.RequestUpdate(Scene::UpdateFlag::Images);
+    mScene.RequestUpdate(Scene::UpdateFlag::Meshes);
+    mScene.RequestUpdate(Scene::UpdateFlag::Materials);
+    mScene.RequestUpdate(Scene::UpdateFlag::MeshMaterials);
+
+    // Other models wait for them to be decoded, so they are finished
+    // independently of this job and committed on the main thread:
+    for (auto &task : orphaned)
+    {
+        mThreadPool->Push([this, task = std::move(task)]() {
+            mOrphanedImages.Push(FinishedImage{
+                .Key  = task.ImageKey,
+                .Data = DecodeImage(task, *mThreadPool),
+            });
+        });
+    }
+
+    std::cout << "Cancelled loading model " << model.Config.Filepath.filename().string()
+              << '\n';
+}
+
+void AssetManager::ForgetImage(SceneKey key)
+{
+    mTextures.Forget(key);
+}
+
+bool AssetManager::PreprocessGltf(Model &model)
 {
     // Load and parse gltf file:
-    mModel->Gltf = std::make_unique<GltfAsset>(mModel->Config.Filepath);
+    model.Gltf = std::make_unique<GltfAsset>(model.Config.Filepath, *mThreadPool);
+
+    if (!model.Gltf->IsValid())
+    {
+        std::cerr << "Failed to load model: " << model.Config.Filepath.string() << '\n';
+        model.Gltf.reset();
+        return false;
+    }
 
     // Retrieve materials, fill table of their keys
-    std::map<size_t, SceneKey> matKeyMap;
-    mModel->Gltf->PreprocessMaterials(mScene, matKeyMap, mModel->ImgTasks,
-                                      mModel->Config);
+    model.Gltf->PreprocessMaterials(mScene, model.MatKeyMap, model.ImgTasks,
+                                    model.Config, mTextures);
 
     // Retrieve mesh primitives, fill table of their keys, assign them materials from
     // previous table
-    mModel->Gltf->PreprocessMeshes(mScene, mModel->MeshKeyMap, mModel->PrimTasks,
-                                   mModel->Config, matKeyMap);
+    model.Gltf->PreprocessMeshes(mScene, model.MeshKeyMap, model.PrimTasks, model.Config,
+                                 model.MatKeyMap);
 
     // Retrieve node hierarchy, assign keys from mesh table:
-    mModel->Gltf->PreprocessHierarchy(root, mModel->MeshKeyMap);
+    model.Gltf->PreprocessHierarchy(model.Root, model.MeshKeyMap);
 
     // Calculate number of async tasks to do:
-    const auto primCount = mModel->ImgTasks.size();
-    const auto imgCount  = mModel->PrimTasks.size();
+    const auto imgCount  = CountDecodeTasks(model.ImgTasks);
+    const auto primCount = model.PrimTasks.size();
+
+    model.TasksLeft = static_cast<int64_t>(imgCount + primCount);
+
+    return true;
+}
+
+bool AssetManager::LoadCooked(Model &model)
+{
+    if (!model.Config.UseCache)
+        return false;
+
+    model.CookedKey = CookedModel::MakeKey(model.Config);
 
-    mModel->TasksLeft = static_cast<int64_t>(primCount + imgCount);
+    // Unreadable source, the import reports it:
+    if (!model.CookedKey.has_value())
+        return false;
+
+    const bool loaded =
+        CookedModel::Load(*model.CookedKey, mScene, model.Root, mTextures,
+                          model.ImgTasks, model.MatKeyMap, model.MeshKeyMap);
+
+    if (loaded)
+    {
+        std::cout << "Using cooked model: " << model.CookedKey->Path.string() << '\n';
+
+        // Geometry is ready, only the images still need to be decoded:
+        model.FromCooked = true;
+        model.TasksLeft  = static_cast<int64_t>(CountDecodeTasks(model.ImgTasks));
+    }
+
+    return loaded;
 }
 
 void AssetManager::LoadHdri(const std::filesystem::path &path)
@@ -182,4 +611,9 @@ void AssetManager::LoadHdri(const std::filesystem::path &path)
 void AssetManager::ClearCachedHDRI()
 {
     mHDRI.LastPath = std::nullopt;
-}
\ No newline at end of file
+}
+
+ThreadPool &AssetManager::GetThreadPool()
+{
+    return *mThreadPool;
+}
@@ -4,44 +4,108 @@
 #include "ModelConfig.h"
 #include "Scene.h"
 #include "SceneGraph.h"
+#include "SyncQueue.h"
+#include "TextureRegistry.h"
+
+#include <memory>
+#include <vector>
 
 class ThreadPool;
 
 class AssetManager {
+  public:
+    using ModelJobId = uint64_t;
+
   public:
     AssetManager(Scene &scene);
     ~AssetManager();
 
     void OnUpdate();
 
-    void LoadModel(const ModelConfig &config, SceneGraphNode &root, bool &isReady);
+    // Queues the model for loading. Several models are loaded concurrently,
+    // queued ones are started in order of decreasing priority. Issues found
+    // in the source data are appended to diagnostics as primitives finish:
+    ModelJobId LoadModel(const ModelConfig &config, SceneGraphNode &root, bool &isReady,
+                         std::vector<PrimitiveDiagnostics> &diagnostics,
+                         int32_t                            priority = 0);
+    // Anything the job already emplaced in the scene is removed
+    // as soon as its in-flight tasks finish:
+    void CancelModel(ModelJobId id);
+    // True until the job is finished, or its cancellation is complete:
+    [[nodiscard]] bool IsModelActive(ModelJobId id) const;
+
+    // Has to be called when an image is erased from the scene
+    // outside of the asset manager:
+    void ForgetImage(SceneKey key);
+
     void LoadHdri(const std::filesystem::path &path);
 
     void ClearCachedHDRI();
 
+    // Shared with other work of the editor. Its ParallelFor is safe
+    // to use while loads are in flight, the caller processes ranges too:
+    ThreadPool &GetThreadPool();
+
   private:
-    void PreprocessGltf(SceneGraphNode &root);
+    struct Model;
+
+    // Decoded image, waiting to be committed to the scene on the main thread:
+    struct FinishedImage {
+        SceneKey  Key;
+        ImageData Data;
+    };
+
+    void StartModel(Model &model);
+    void ScheduleModelTasks(Model &model);
+    // Moves finished task results into the scene, until
+    // the byte budget is exceeded. Returns bytes committed:
+    size_t CommitResults(Model &model, size_t budget);
+    bool   HasPendingResults(Model &model);
+    void   FinishModel(Model &model);
+    void   DiscardModel(Model &model);
+    // Images decoded on behalf of discarded models:
+    void CommitOrphanedImages();
+
+    bool LoadCooked(Model &model);
+    // Returns false if the file can't be loaded:
+    bool PreprocessGltf(Model &model);
 
   private:
     Scene &mScene;
 
-    struct Model;
-    std::unique_ptr<Model> mModel;
+    // Images shared between materials of all loaded models:
+    TextureRegistry mTextures;
 
     enum class ModelStage
     {
-        Idle,
+        Queued,
         Parsing,
         Parsed,
         Loading,
+        Done,
     };
 
-    ModelStage mModelStage = ModelStage::Idle;
+    // Each parsed gltf keeps its buffers in memory until the model
+    // is loaded, so number of models in flight is limited:
+    static constexpr size_t MaxActiveModels = 8;
+
+    // Bytes of finished data committed to the scene per frame by progressive
+    // loads. Limits the amount of uploads renderers do in a single frame:
+    static constexpr size_t CommitBudget = 32 * 1024 * 1024;
+
+    // All model jobs, sorted by decreasing priority:
+    std::vector<std::unique_ptr<Model>> mModels;
+    ModelJobId                          mNextJobId = 1;
 
     struct {
         ImageTaskData                        Data;
         std::optional<std::filesystem::path> LastPath;
     } mHDRI;
 
+    // Images of discarded models still shared with other ones:
+    SyncQueue<FinishedImage> mOrphanedImages;
+
+    // Declared last, so that workers are joined before
+    // the models they reference are destroyed:
     std::unique_ptr<ThreadPool> mThreadPool;
-};
\ No newline at end of file
+};
@@ -0,0 +1,92 @@
+#include "BoundsTree.h"
+#include "Pch.h"
+
+#include <algorithm>
+#include <bit>
+
+bool BoundsTree::Box::IsEmpty() const
+{
+    return Min.x > Max.x;
+}
+
+BoundsTree::Box BoundsTree::ToBox(const AABB &box)
+{
+    return Box{.Min = box.Center - box.Extent, .Max = box.Center + box.Extent};
+}
+
+AABB BoundsTree::ToAABB(const Box &box)
+{
+    return AABB{
+        .Center = 0.5f * (box.Max + box.Min),
+        .Extent = 0.5f * (box.Max - box.Min),
+    };
+}
+
+BoundsTree::Box BoundsTree::Merge(const Box &a, const Box &b)
+{
+    return Box{.Min = glm::min(a.Min, b.Min), .Max = glm::max(a.Max, b.Max)};
+}
+
+void BoundsTree::Set(uint32_t leaf, const AABB &box)
+{
+    Reserve(leaf);
+
+    mNodes[mLeafCount + leaf] = ToBox(box);
+    Propagate(leaf);
+}
+
+void BoundsTree::Reset(uint32_t leaf)
+{
+    if (leaf >= mLeafCount)
+        return;
+
+    mNodes[mLeafCount + leaf] = Box{};
+    Propagate(leaf);
+}
+
+void BoundsTree::Refit()
+{
+    for (uint32_t i = mLeafCount; i-- > 1;)
+        mNodes[i] = Merge(mNodes[2 * i], mNodes[2 * i + 1]);
+}
+
+std::optional<AABB> BoundsTree::GetTotal() const
+{
+    if (mLeafCount == 0 || mNodes[1].IsEmpty())
+        return std::nullopt;
+
+    return ToAABB(mNodes[1]);
+}
+
+void BoundsTree::Reserve(uint32_t leaf)
+{
+    if (leaf < mLeafCount)
+        return;
+
+    // Leaves keep their order when the tree grows,
+    // only the inner nodes have to be recomputed:
+    const uint32_t leafCount = std::max(std::bit_ceil(leaf + 1), MinLeafCount);
+
+    std::vector<Box> nodes(2 * leafCount);
+
+    std::copy_n(mNodes.begin() + mLeafCount, mLeafCount, nodes.begin() + leafCount);
+
+    mNodes     = std::move(nodes);
+    mLeafCount = leafCount;
+
+    Refit();
+}
+
+void BoundsTree::Propagate(uint32_t leaf)
+{
+    for (uint32_t i = (mLeafCount + leaf) / 2; i >= 1; i /= 2)
+    {
+        const Box merged = Merge(mNodes[2 * i], mNodes[2 * i + 1]);
+
+        // Ancestors already account for the change:
+        if (merged.Min == mNodes[i].Min && merged.Max == mNodes[i].Max)
+            break;
+
+        mNodes[i] = merged;
+    }
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "GeometryData.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+// Reduction tree of bounding boxes. Leaves are addressed by index (e.g. slot
+// index of a slot map key), each inner node holds the union of its children,
+// so changing a single leaf updates the total in O(log n). Empty leaves
+// don't contribute to the total:
+class BoundsTree {
+  public:
+    void Set(uint32_t leaf, const AABB &box);
+    void Reset(uint32_t leaf);
+
+    // Union of all leaves, none if all of them are empty:
+    [[nodiscard]] std::optional<AABB> GetTotal() const;
+
+  private:
+    // Min/max form makes unions cheap. Empty boxes are inverted,
+    // so they vanish in unions without extra checks:
+    struct Box {
+        glm::vec3 Min = glm::vec3(std::numeric_limits<float>::max());
+        glm::vec3 Max = glm::vec3(std::numeric_limits<float>::lowest());
+
+        [[nodiscard]] bool IsEmpty() const;
+    };
+
+    static Box  ToBox(const AABB &box);
+    static AABB ToAABB(const Box &box);
+    static Box  Merge(const Box &a, const Box &b);
+
+    void Reserve(uint32_t leaf);
+    void Propagate(uint32_t leaf);
+    // Recomputes all inner nodes from the leaves:
+    void Refit();
+
+  private:
+    // Implicit binary tree, root at 1 and leaves starting at mLeafCount:
+    std::vector<Box> mNodes;
+    uint32_t         mLeafCount = 0;
+
+    static constexpr uint32_t MinLeafCount = 64;
+};
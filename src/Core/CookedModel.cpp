@@ -0,0 +1,849 @@
+#include "CookedModel.h"
+#include "Pch.h"
+
+#include "Hash.h"
+#include "MappedFile.h"
+#include "Vassert.h"
+
+#include <algorithm>
+#include <cstring>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <ranges>
+
+// Bump the version whenever layout of the cooked file, or the way
+// any of the cooked data is produced changes:
+static constexpr uint32_t CookedMagic   = 0x4b4f4f43; // "COOK"
+static constexpr uint32_t CookedVersion = 6;
+
+static const std::filesystem::path CookedDirectory = "cache/models";
+
+class CookedWriter {
+  public:
+    CookedWriter(const std::filesystem::path &path) : mStream(path, std::ios::binary)
+    {
+    }
+
+    [[nodiscard]] bool IsOpen() const
+    {
+        return mStream.is_open();
+    }
+
+    [[nodiscard]] bool Good() const
+    {
+        return mStream.good();
+    }
+
+    template <typename T>
+    void Write(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+        WriteBytes(&value, sizeof(T));
+    }
+
+    void WriteString(const std::string &str)
+    {
+        Write(static_cast<uint64_t>(str.size()));
+        WriteBytes(str.data(), str.size());
+    }
+
+    void WriteBytes(const void *data, size_t size)
+    {
+        mStream.write(static_cast<const char *>(data),
+                      static_cast<std::streamsize>(size));
+    }
+
+  private:
+    std::ofstream mStream;
+};
+
+// Cache files may be truncated or corrupted by means outside of our control,
+// so reads never trust the data. Reads past the end, or of invalid values,
+// fail the reader: they return zeroed data and so do all further reads.
+// Parsing can then carry on, and is checked once with Failed():
+class CookedReader {
+  public:
+    CookedReader(std::span<const uint8_t> bytes) : mBytes(bytes)
+    {
+    }
+
+    [[nodiscard]] bool Failed() const
+    {
+        return mFailed;
+    }
+
+    [[nodiscard]] size_t Remaining() const
+    {
+        return mBytes.size() - mOffset;
+    }
+
+    void Require(bool condition)
+    {
+        if (!condition)
+            mFailed = true;
+    }
+
+    template <typename T>
+    T Read()
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        T res{};
+
+        if (auto bytes = ReadBytes(sizeof(T)); !bytes.empty())
+            std::memcpy(&res, bytes.data(), sizeof(T));
+
+        return res;
+    }
+
+    bool ReadBool()
+    {
+        const auto value = Read<uint8_t>();
+        Require(value <= 1);
+
+        return value == 1;
+    }
+
+    // Enums with contiguous values starting at zero:
+    template <typename E>
+    E ReadEnum(E last)
+    {
+        using Underlying = std::underlying_type_t<E>;
+
+        const auto value = Read<Underlying>();
+        Require(!std::cmp_less(value, 0) &&
+                std::cmp_less_equal(value, static_cast<Underlying>(last)));
+
+        return mFailed ? E{} : static_cast<E>(value);
+    }
+
+    // Element count of an array, each element taking at least elementSize
+    // bytes. Counts which can't fit in the rest of the file are rejected,
+    // so they are safe to allocate and loop over:
+    uint64_t ReadCount(size_t elementSize)
+    {
+        const auto count = Read<uint64_t>();
+        Require(count <= Remaining() / elementSize);
+
+        return mFailed ? 0 : count;
+    }
+
+    std::string ReadString()
+    {
+        auto bytes = ReadBytes(ReadCount(1));
+
+        return {reinterpret_cast<const char *>(bytes.data()), bytes.size()};
+    }
+
+    // Empty span on failure:
+    std::span<const uint8_t> ReadBytes(size_t size)
+    {
+        Require(size <= Remaining());
+
+        if (mFailed)
+            return {};
+
+        auto res = mBytes.subspan(mOffset, size);
+        mOffset += size;
+
+        return res;
+    }
+
+  private:
+    std::span<const uint8_t> mBytes;
+    size_t                   mOffset = 0;
+    bool                     mFailed = false;
+};
+
+static void HashVertexLayout(Hasher &hasher, const Vertex::Layout &vLayout)
+{
+    hasher.Value(vLayout.index());
+
+    if (auto *layout = std::get_if<Vertex::PushLayout>(&vLayout))
+        hasher.Value(*layout);
+    else
+        hasher.Value(std::get<Vertex::PullLayout>(vLayout));
+}
+
+std::optional<CookedModel::Key> CookedModel::MakeKey(const ModelConfig &config)
+{
+    Hasher hasher;
+    hasher.Value(CookedVersion);
+
+    // Contents of the source file itself:
+    {
+        MappedFile source(config.Filepath);
+
+        if (!source.IsValid())
+            return std::nullopt;
+
+        hasher.Bytes(source.Bytes());
+    }
+
+    // External buffers and images are referenced from the source file,
+    // finding them would require parsing it. Instead metadata of all files
+    // in the source directory is hashed, which is cheap and conservative:
+    auto sourceDir = config.Filepath.parent_path();
+
+    {
+        auto dir = sourceDir.empty() ? std::filesystem::path(".") : sourceDir;
+
+        std::vector<std::filesystem::directory_entry> entries;
+
+        for (const auto &entry : std::filesystem::directory_iterator(dir))
+        {
+            if (entry.is_regular_file())
+                entries.push_back(entry);
+        }
+
+        // Iteration order is unspecified:
+        std::ranges::sort(entries, {}, [](const auto &e) { return e.path(); });
+
+        for (const auto &entry : entries)
+        {
+            hasher.String(entry.path().filename().string());
+            hasher.Value(entry.file_size());
+            hasher.Value(entry.last_write_time().time_since_epoch().count());
+        }
+    }
+
+    // Import options that affect the resulting data:
+    HashVertexLayout(hasher, config.VertexLayout);
+    hasher.Value(config.Tangents);
+    hasher.Value(config.FetchRoughness);
+    hasher.Value(config.FetchNormal);
+    hasher.Value(config.CompressTextures);
+    hasher.Value(config.OptimizeMeshes);
+    hasher.Value(config.GenerateLods);
+    hasher.Value(config.BuildMeshlets);
+
+    const auto hash = hasher.Get();
+    const auto stem = config.Filepath.stem().string();
+
+    return Key{
+        .Hash      = hash,
+        .Path      = CookedDirectory / std::format("{}-{:016x}.cooked", stem, hash),
+        .SourceDir = sourceDir,
+    };
+}
+
+static void WriteGeometry(CookedWriter &out, const GeometryData &geo)
+{
+    const auto &vLayout = geo.Layout.VertexLayout;
+
+    out.Write(static_cast<uint8_t>(vLayout.index()));
+
+    if (auto *layout = std::get_if<Vertex::PushLayout>(&vLayout))
+        out.Write(*layout);
+    else
+        out.Write(std::get<Vertex::PullLayout>(vLayout));
+
+    out.Write(geo.Layout.IndexType);
+    out.Write(static_cast<uint64_t>(geo.VertexCount));
+    out.Write(static_cast<uint64_t>(geo.IndexCount));
+    out.Write(geo.BBox);
+
+    out.Write(static_cast<uint64_t>(geo.VertexData.Size));
+    out.WriteBytes(geo.VertexData.Data, geo.VertexData.Size);
+
+    out.Write(static_cast<uint64_t>(geo.IndexData.Size));
+    out.WriteBytes(geo.IndexData.Data, geo.IndexData.Size);
+
+    out.Write(static_cast<uint64_t>(geo.Lods.size()));
+
+    for (const auto &lod : geo.Lods)
+        out.Write(lod);
+
+    out.Write(static_cast<uint64_t>(geo.Meshlets.size()));
+    out.WriteBytes(geo.Meshlets.data(), geo.Meshlets.size() * sizeof(Meshlet));
+}
+
+static GeometryData ReadGeometry(CookedReader &in)
+{
+    GeometryLayout layout{};
+
+    const auto layoutIdx = in.Read<uint8_t>();
+    in.Require(layoutIdx <= 1);
+
+    if (layoutIdx == 0)
+    {
+        layout.VertexLayout = Vertex::PushLayout{
+            .HasTexCoord = in.ReadBool(),
+            .HasNormal   = in.ReadBool(),
+            .HasTangent  = in.ReadBool(),
+            .HasColor    = in.ReadBool(),
+        };
+    }
+    else
+        layout.VertexLayout = in.ReadEnum(Vertex::PullLayout::Compressed);
+
+    // Checked as a plain integer, the file may hold any value:
+    const auto indexType = in.Read<std::underlying_type_t<VkIndexType>>();
+    in.Require(indexType == VK_INDEX_TYPE_UINT16 || indexType == VK_INDEX_TYPE_UINT32);
+    layout.IndexType = in.Failed() ? VK_INDEX_TYPE_UINT16 : VkIndexType(indexType);
+
+    const auto vertCount = in.Read<uint64_t>();
+    const auto idxCount  = in.Read<uint64_t>();
+    const auto bbox      = in.Read<AABB>();
+
+    auto vertBytes = in.ReadBytes(in.ReadCount(1));
+    auto idxBytes  = in.ReadBytes(in.ReadCount(1));
+
+    const size_t vertSize = Vertex::GetSize(layout.VertexLayout);
+    const size_t idxSize  = GetIndexSize(layout.IndexType);
+
+    // Index buffer holds the full resolution indices followed by the lods:
+    const uint64_t idxBufferCount = idxBytes.size() / idxSize;
+
+    in.Require(vertCount <= vertBytes.size() / vertSize);
+    in.Require(idxCount <= idxBufferCount);
+
+    const auto lodCount = in.ReadCount(sizeof(GeometryLod));
+
+    std::vector<GeometryLod> lods(lodCount);
+
+    for (auto &lod : lods)
+    {
+        lod = in.Read<GeometryLod>();
+        const uint64_t lodEnd = static_cast<uint64_t>(lod.FirstIndex) + lod.IndexCount;
+        in.Require(lodEnd <= idxBufferCount);
+    }
+
+    // Meshlets are ranges of the full resolution indices:
+    const auto meshletCount = in.ReadCount(sizeof(Meshlet));
+
+    std::vector<Meshlet> meshlets(meshletCount);
+
+    for (auto &meshlet : meshlets)
+    {
+        meshlet = in.Read<Meshlet>();
+        in.Require(static_cast<uint64_t>(meshlet.FirstIndex) + meshlet.IndexCount <=
+                   idxCount);
+    }
+
+    if (in.Failed())
+        return GeometryData{};
+
+    // Vertices are fetched by index, out of range ones would read past
+    // the vertex buffer on the gpu:
+    for (uint64_t i = 0; i < idxBufferCount; i++)
+    {
+        uint32_t idx = 0;
+
+        if (idxSize == sizeof(uint16_t))
+        {
+            uint16_t idx16;
+            std::memcpy(&idx16, idxBytes.data() + i * idxSize, idxSize);
+            idx = idx16;
+        }
+        else
+            std::memcpy(&idx, idxBytes.data() + i * idxSize, idxSize);
+
+        in.Require(idx < vertCount);
+    }
+
+    if (in.Failed())
+        return GeometryData{};
+
+    const auto spec = GeometrySpec{
+        .VertCount     = vertCount,
+        .VertBuffSize  = vertBytes.size(),
+        .VertAlignment = 4,
+        .IdxCount      = idxCount,
+        .IdxBuffSize   = idxBytes.size(),
+        .IdxAlignment  = idxSize,
+    };
+
+    auto geo = GeometryData(spec);
+
+    geo.Layout   = layout;
+    geo.BBox     = bbox;
+    geo.Lods     = std::move(lods);
+    geo.Meshlets = std::move(meshlets);
+
+    std::memcpy(geo.VertexData.Data, vertBytes.data(), vertBytes.size());
+    std::memcpy(geo.IndexData.Data, idxBytes.data(), idxBytes.size());
+
+    return geo;
+}
+
+static void WriteNode(CookedWriter &out, const SceneGraphNode &node,
+                      const std::map<SceneKey, int64_t> &meshIds)
+{
+    out.WriteString(node.Name);
+    out.Write(node.Translation);
+    out.Write(node.Rotation);
+    out.Write(node.Scale);
+
+    // Prefab leaves hold mesh keys, which are stored as cooked mesh ids:
+    if (node.IsLeaf())
+    {
+        out.Write(meshIds.at(node.GetObjectKey()));
+        return;
+    }
+
+    out.Write(int64_t(-1));
+
+    const auto &children = node.GetChildrenConst();
+    out.Write(static_cast<uint64_t>(children.size()));
+
+    for (const auto &child : children)
+        WriteNode(out, *child, meshIds);
+}
+
+// Parsed contents of a cooked file. Ids refer to positions of
+// the images, materials and meshes in the file:
+struct CookedMaterial {
+    SceneMaterial          Material;
+    std::array<int64_t, 3> ImageIds;
+};
+
+struct CookedMesh {
+    SceneMesh            Mesh;
+    std::vector<int64_t> MaterialIds;
+};
+
+struct CookedNode {
+    std::string Name;
+    glm::vec3   Translation;
+    glm::vec3   Rotation;
+    glm::vec3   Scale;
+    int64_t     MeshId;
+    uint64_t    ChildCount = 0;
+};
+
+// Nodes are stored in depth-first order, each inner node followed by
+// its child count. Read into a flat list without recursion, as corrupted
+// files could nest arbitrarily deep:
+static std::vector<CookedNode> ReadNodes(CookedReader &in, uint64_t meshCount)
+{
+    constexpr size_t minNodeSize = sizeof(uint64_t) + 3 * sizeof(glm::vec3) +
+                                   sizeof(int64_t);
+
+    std::vector<CookedNode> nodes;
+
+    // Children left to read for each open inner node, starting with the root:
+    std::vector<uint64_t> pending{1};
+
+    while (!pending.empty() && !in.Failed())
+    {
+        if (pending.back() == 0)
+        {
+            pending.pop_back();
+            continue;
+        }
+
+        pending.back()--;
+
+        auto &node = nodes.emplace_back();
+
+        node.Name        = in.ReadString();
+        node.Translation = in.Read<glm::vec3>();
+        node.Rotation    = in.Read<glm::vec3>();
+        node.Scale       = in.Read<glm::vec3>();
+        node.MeshId      = in.Read<int64_t>();
+
+        in.Require(node.MeshId < static_cast<int64_t>(meshCount));
+
+        if (node.MeshId < 0)
+        {
+            node.ChildCount = in.ReadCount(minNodeSize);
+            pending.push_back(node.ChildCount);
+        }
+    }
+
+    // Prefab root is never a leaf:
+    in.Require(!nodes.empty() && nodes[0].MeshId < 0);
+
+    return nodes;
+}
+
+static void BuildNodes(const std::vector<CookedNode> &nodes, SceneGraphNode &root,
+                       const std::vector<SceneKey> &meshKeys)
+{
+    auto Apply = [](const CookedNode &src, SceneGraphNode &dst) {
+        dst.Name        = src.Name;
+        dst.Translation = src.Translation;
+        dst.Rotation    = src.Rotation;
+        dst.Scale       = src.Scale;
+    };
+
+    // Root node info is applied to the existing root:
+    Apply(nodes[0], root);
+
+    std::vector<std::pair<SceneGraphNode *, uint64_t>> parents{
+        {&root, nodes[0].ChildCount}};
+
+    for (size_t i = 1; i < nodes.size(); i++)
+    {
+        while (parents.back().second == 0)
+            parents.pop_back();
+
+        SceneGraphNode *parent = parents.back().first;
+        parents.back().second--;
+
+        const auto &src = nodes[i];
+
+        auto &node = (src.MeshId >= 0) ? parent->EmplaceChild(meshKeys[src.MeshId])
+                                       : parent->EmplaceChild();
+        Apply(src, node);
+
+        if (src.MeshId < 0)
+            parents.emplace_back(&node, src.ChildCount);
+    }
+}
+
+void CookedModel::Store(const Key &key, Scene &scene, const SceneGraphNode &root,
+                        const std::vector<ImageTaskData> &imgTasks,
+                        const std::map<size_t, SceneKey> &matKeyMap,
+                        const std::map<size_t, SceneKey> &meshKeyMap)
+{
+    // The editor may erase elements of a model that is still loading,
+    // a partially erased model is never cooked:
+    auto lock = scene.Lock();
+
+    std::vector<std::pair<SceneKey, const SceneMaterial *>> materials;
+    std::vector<std::pair<SceneKey, const SceneMesh *>>     meshes;
+
+    for (const auto &[_, matKey] : matKeyMap)
+        materials.emplace_back(matKey, scene.Materials.Find(matKey));
+
+    for (const auto &[_, meshKey] : meshKeyMap)
+        meshes.emplace_back(meshKey, scene.Meshes.Find(meshKey));
+
+    auto IsErased = [](const auto &entry) { return entry.second == nullptr; };
+
+    const bool complete = std::ranges::none_of(materials, IsErased) &&
+                          std::ranges::none_of(meshes, IsErased) &&
+                          std::ranges::all_of(imgTasks, [&](const ImageTaskData &task) {
+                              return scene.Images.Contains(task.ImageKey);
+                          });
+
+    if (!complete)
+    {
+        std::cerr << "Model was partially erased, not cooking: " << key.Path.string()
+                  << '\n';
+        return;
+    }
+
+    std::error_code ec;
+    std::filesystem::create_directories(key.Path.parent_path(), ec);
+
+    // Write to a temporary file first, so that a crash in the middle
+    // never leaves a truncated file under a valid name:
+    auto tmpPath = key.Path;
+    tmpPath += ".tmp";
+
+    {
+        CookedWriter out(tmpPath);
+
+        if (!out.IsOpen())
+        {
+            std::cerr << "Failed to create cooked model file: " << tmpPath.string()
+                      << '\n';
+            return;
+        }
+
+        out.Write(CookedMagic);
+        out.Write(CookedVersion);
+        out.Write(key.Hash);
+
+        // Images (only the decode tasks are stored):
+        std::map<SceneKey, int64_t> imgIds;
+
+        out.Write(static_cast<uint64_t>(imgTasks.size()));
+
+        for (const auto &task : imgTasks)
+        {
+            imgIds[task.ImageKey] = static_cast<int64_t>(imgIds.size());
+
+            // Source: none, external file, or embedded bytes (kept
+            // in the cooked file, as the gltf is not parsed again):
+            const bool embedded = !task.Embedded.empty();
+            out.Write(static_cast<uint8_t>(embedded ? 2 : task.Path.has_value()));
+
+            if (task.Path)
+            {
+                auto relPath = task.Path->lexically_relative(key.SourceDir);
+                out.WriteString(relPath.generic_string());
+            }
+
+            if (embedded)
+            {
+                out.Write(static_cast<uint64_t>(task.Embedded.size()));
+                out.WriteBytes(task.Embedded.data(), task.Embedded.size());
+            }
+
+            out.Write(task.BaseColor);
+            out.WriteString(task.Name);
+            out.Write(task.Unorm);
+            out.Write(task.Usage);
+            out.Write(task.Compress);
+        }
+
+        auto ImageId = [&](std::optional<SceneKey> imgKey) -> int64_t {
+            if (imgKey.has_value() && imgIds.contains(*imgKey))
+                return imgIds.at(*imgKey);
+
+            return -1;
+        };
+
+        // Materials:
+        std::map<SceneKey, int64_t> matIds;
+
+        out.Write(static_cast<uint64_t>(matKeyMap.size()));
+
+        for (const auto &[matKey, matPtr] : materials)
+        {
+            matIds[matKey] = static_cast<int64_t>(matIds.size());
+
+            const auto &mat = *matPtr;
+
+            out.WriteString(mat.Name);
+            out.Write(ImageId(mat.Albedo));
+            out.Write(ImageId(mat.Roughness));
+            out.Write(ImageId(mat.Normal));
+            out.Write(mat.DoubleSided);
+            out.Write(mat.AlphaMode);
+            out.Write(mat.AlphaCutoff);
+            out.Write(static_cast<uint8_t>(mat.TranslucentColor.has_value()));
+            out.Write(mat.TranslucentColor.value_or(glm::vec3(0.0f)));
+        }
+
+        // Meshes with their final geometry:
+        std::map<SceneKey, int64_t> meshIds;
+
+        out.Write(static_cast<uint64_t>(meshKeyMap.size()));
+
+        for (const auto &[meshKey, meshPtr] : meshes)
+        {
+            meshIds[meshKey] = static_cast<int64_t>(meshIds.size());
+
+            const auto &mesh = *meshPtr;
+
+            out.WriteString(mesh.Name);
+            out.Write(static_cast<uint64_t>(mesh.Primitives.size()));
+
+            for (const auto &prim : mesh.Primitives)
+            {
+                int64_t matId = -1;
+
+                if (prim.Material.has_value() && matIds.contains(*prim.Material))
+                    matId = matIds.at(*prim.Material);
+
+                out.Write(matId);
+                WriteGeometry(out, prim.Data);
+
+                out.Write(prim.BaseOffset);
+                out.Write(prim.BaseScale);
+                out.Write(prim.TexCoordCenter);
+                out.Write(prim.TexCoordExtent);
+            }
+        }
+
+        // Prefab hierarchy:
+        WriteNode(out, root, meshIds);
+
+        if (!out.Good())
+        {
+            std::cerr << "Failed to write cooked model file: " << tmpPath.string()
+                      << '\n';
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, key.Path, ec);
+
+    if (ec)
+    {
+        std::cerr << "Failed to store cooked model file: " << key.Path.string() << " ("
+                  << ec.message() << ")\n";
+        std::filesystem::remove(tmpPath, ec);
+    }
+}
+
+bool CookedModel::Load(const Key &key, Scene &scene, SceneGraphNode &root,
+                       TextureRegistry &registry, std::vector<ImageTaskData> &imgTasks,
+                       std::map<size_t, SceneKey> &matKeyMap,
+                       std::map<size_t, SceneKey> &meshKeyMap)
+{
+    vassert(imgTasks.empty(), "Tasks vector should be empty!");
+
+    // Embedded images are decoded straight from the mapping,
+    // so it is shared with their tasks:
+    auto file = std::make_shared<MappedFile>(key.Path);
+
+    if (!file->IsValid())
+        return false;
+
+    CookedReader in(file->Bytes());
+
+    if (in.Read<uint32_t>() != CookedMagic)
+        return false;
+
+    if (in.Read<uint32_t>() != CookedVersion)
+        return false;
+
+    if (in.Read<uint64_t>() != key.Hash)
+        return false;
+
+    // The whole file is parsed and validated before anything is emplaced
+    // in the scene. Any failure makes the caller import the source anew.
+    // Smallest possible records bound the counts read from the file:
+    constexpr size_t minImageSize = sizeof(uint8_t) + sizeof(Pixel) + sizeof(uint64_t) +
+                                    2 * sizeof(bool) + sizeof(TextureUsage);
+    constexpr size_t minMaterialSize = sizeof(uint64_t) + 3 * sizeof(int64_t) +
+                                       2 * sizeof(bool) + sizeof(MaterialAlphaMode) +
+                                       sizeof(float) + sizeof(glm::vec3);
+    constexpr size_t minMeshSize = 2 * sizeof(uint64_t);
+    constexpr size_t minPrimSize =
+        sizeof(int64_t) + 2 * sizeof(glm::vec3) + 2 * sizeof(glm::vec2);
+
+    // Images:
+    std::vector<ImageTaskData> tasks(in.ReadCount(minImageSize));
+
+    for (auto &task : tasks)
+    {
+        const auto source = in.Read<uint8_t>();
+        in.Require(source <= 2);
+
+        if (source != 0)
+            task.Path = key.SourceDir / std::filesystem::path(in.ReadString());
+
+        if (source == 2)
+        {
+            task.Embedded      = in.ReadBytes(in.ReadCount(1));
+            task.EmbeddedOwner = file;
+        }
+
+        task.BaseColor = in.Read<Pixel>();
+        task.Name      = in.ReadString();
+        task.Unorm     = in.ReadBool();
+        task.Usage     = in.ReadEnum(TextureUsage::RoughnessMetallic);
+        task.Compress  = in.ReadBool();
+    }
+
+    const auto imgCount = static_cast<int64_t>(tasks.size());
+
+    auto ReadImageId = [&]() {
+        const auto id = in.Read<int64_t>();
+        in.Require(id < imgCount);
+
+        return id;
+    };
+
+    // Materials:
+    std::vector<CookedMaterial> materials(in.ReadCount(minMaterialSize));
+
+    for (auto &[mat, imageIds] : materials)
+    {
+        mat.Name        = in.ReadString();
+        imageIds        = {ReadImageId(), ReadImageId(), ReadImageId()};
+        mat.DoubleSided = in.ReadBool();
+        mat.AlphaMode   = in.ReadEnum(MaterialAlphaMode::Blend);
+        mat.AlphaCutoff = in.Read<float>();
+
+        const bool hasTranslucent = in.ReadBool();
+        const auto translucent    = in.Read<glm::vec3>();
+
+        if (hasTranslucent)
+            mat.TranslucentColor = translucent;
+    }
+
+    const auto matCount = static_cast<int64_t>(materials.size());
+
+    // Meshes:
+    std::vector<CookedMesh> meshes(in.ReadCount(minMeshSize));
+
+    for (auto &[mesh, materialIds] : meshes)
+    {
+        mesh.Name = in.ReadString();
+
+        const auto primCount = in.ReadCount(minPrimSize);
+
+        for (uint64_t j = 0; j < primCount && !in.Failed(); j++)
+        {
+            auto &prim = mesh.Primitives.emplace_back();
+
+            const auto matId = in.Read<int64_t>();
+            in.Require(matId < matCount);
+            materialIds.push_back(matId);
+
+            prim.Data = ReadGeometry(in);
+
+            prim.BaseOffset     = in.Read<glm::vec3>();
+            prim.BaseScale      = in.Read<glm::vec3>();
+            prim.TexCoordCenter = in.Read<glm::vec2>();
+            prim.TexCoordExtent = in.Read<glm::vec2>();
+        }
+    }
+
+    // Prefab hierarchy:
+    const auto nodes = ReadNodes(in, meshes.size());
+
+    in.Require(in.Remaining() == 0);
+
+    if (in.Failed())
+    {
+        std::cerr << "Invalid cooked model file: " << key.Path.string() << '\n';
+        return false;
+    }
+
+    // Everything is valid, fill the scene:
+    std::vector<SceneKey> imgKeys;
+
+    for (auto &task : tasks)
+    {
+        auto handle = registry.Acquire(task.Path, task.BaseColor, task.Unorm,
+                                       task.Usage, task.Compress);
+        task.ImageKey    = handle.Key;
+        task.NeedsDecode = handle.IsNew;
+        imgKeys.push_back(handle.Key);
+    }
+
+    auto ImageKey = [&](int64_t id) -> std::optional<SceneKey> {
+        if (id < 0)
+            return std::nullopt;
+
+        return imgKeys[id];
+    };
+
+    std::vector<SceneKey> matKeys;
+
+    for (size_t i = 0; i < materials.size(); i++)
+    {
+        auto &[mat, imageIds] = materials[i];
+
+        mat.Albedo    = ImageKey(imageIds[0]);
+        mat.Roughness = ImageKey(imageIds[1]);
+        mat.Normal    = ImageKey(imageIds[2]);
+
+        auto matKey = scene.EmplaceMaterial(std::move(mat)).first;
+        matKeys.push_back(matKey);
+        matKeyMap[i] = matKey;
+    }
+
+    std::vector<SceneKey> meshKeys;
+
+    for (size_t i = 0; i < meshes.size(); i++)
+    {
+        auto &cooked = meshes[i];
+
+        for (size_t j = 0; j < cooked.MaterialIds.size(); j++)
+        {
+            if (cooked.MaterialIds[j] >= 0)
+                cooked.Mesh.Primitives[j].Material = matKeys[cooked.MaterialIds[j]];
+        }
+
+        auto meshKey = scene.EmplaceMesh(std::move(cooked.Mesh)).first;
+        meshKeys.push_back(meshKey);
+        meshKeyMap[i] = meshKey;
+    }
+
+    BuildNodes(nodes, root, meshKeys);
+
+    imgTasks = std::move(tasks);
+
+    return true;
+}
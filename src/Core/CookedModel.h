@@ -0,0 +1,47 @@
+#pragma once
+
+#include "GltfImporter.h"
+#include "ModelConfig.h"
+#include "Scene.h"
+#include "SceneGraph.h"
+#include "TextureRegistry.h"
+
+#include <filesystem>
+#include <map>
+#include <optional>
+#include <vector>
+
+// On-disk cache of already imported (parsed, tangent-generated and packed)
+// models. Cooked files are content addressed - the key is a hash of
+// the source file and of all config options that affect imported data,
+// so stale entries are never read, they just stop being referenced.
+namespace CookedModel
+{
+struct Key {
+    uint64_t              Hash;
+    std::filesystem::path Path;
+    // Image paths are stored relative to this directory:
+    std::filesystem::path SourceDir;
+};
+
+// None if the source file can't be read:
+std::optional<Key> MakeKey(const ModelConfig &config);
+
+// Tries to recreate the model from its cooked file. On success emplaces
+// materials and meshes (with final geometry) in the scene, acquires image
+// slots from the registry, rebuilds the prefab hierarchy under root and fills
+// out image tasks (decoding of images is not cached). Key maps are filled with
+// cooked ids in place of gltf ids. Returns false without touching the scene
+// if there is no valid cooked file for the key.
+bool Load(const Key &key, Scene &scene, SceneGraphNode &root, TextureRegistry &registry,
+          std::vector<ImageTaskData> &imgTasks, std::map<size_t, SceneKey> &matKeyMap,
+          std::map<size_t, SceneKey> &meshKeyMap);
+
+// Writes fully loaded model to the cooked file. Key maps are the ones
+// filled out by GltfAsset preprocessing functions. Takes the scene lock,
+// nothing is written if any element of the model was erased meanwhile.
+void Store(const Key &key, Scene &scene, const SceneGraphNode &root,
+           const std::vector<ImageTaskData> &imgTasks,
+           const std::map<size_t, SceneKey> &matKeyMap,
+           const std::map<size_t, SceneKey> &meshKeyMap);
+} // namespace CookedModel
@@ -0,0 +1,549 @@
+#include "DynamicBvh.h"
+#include "Pch.h"
+
+#include "Vassert.h"
+
+#include <algorithm>
+#include <optional>
+#include <utility>
+
+bool DynamicBvh::Node::IsLeaf() const
+{
+    return Children[0] == Null;
+}
+
+DynamicBvh::NodeId DynamicBvh::Insert(const AABB &box, uint64_t value)
+{
+    const NodeId leaf = Allocate();
+
+    mNodes[leaf].Bounds = ToBox(box);
+    mNodes[leaf].Value  = value;
+
+    InsertLeaf(leaf);
+    mLeafCount++;
+
+    return leaf;
+}
+
+void DynamicBvh::Remove(NodeId leaf)
+{
+    vassert(leaf < mNodes.size() && mNodes[leaf].IsLeaf() && mNodes[leaf].Height == 0,
+            "Invalid BVH leaf!");
+
+    RemoveLeaf(leaf);
+    Free(leaf);
+    mLeafCount--;
+}
+
+void DynamicBvh::Update(NodeId leaf, const AABB &box)
+{
+    vassert(leaf < mNodes.size() && mNodes[leaf].IsLeaf() && mNodes[leaf].Height == 0,
+            "Invalid BVH leaf!");
+
+    const Box    bounds = ToBox(box);
+    const NodeId parent = mNodes[leaf].Parent;
+
+    if (bounds.Min == mNodes[leaf].Bounds.Min && bounds.Max == mNodes[leaf].Bounds.Max)
+        return;
+
+    // Small moves keep the tree structure, only the ancestors shrink or grow:
+    if (parent == Null || Contains(mNodes[parent].Bounds, bounds))
+    {
+        mNodes[leaf].Bounds = bounds;
+        Refit(parent);
+        return;
+    }
+
+    RemoveLeaf(leaf);
+    mNodes[leaf].Bounds = bounds;
+    InsertLeaf(leaf);
+}
+
+void DynamicBvh::SetValue(NodeId leaf, uint64_t value)
+{
+    mNodes[leaf].Value = value;
+}
+
+void DynamicBvh::Clear()
+{
+    mNodes.clear();
+
+    mRoot      = Null;
+    mFreeList  = Null;
+    mLeafCount = 0;
+}
+
+void DynamicBvh::Build(std::span<const Item> items, std::span<NodeId> leaves)
+{
+    vassert(items.size() == leaves.size(), "Each item needs a leaf!");
+
+    Clear();
+
+    if (items.empty())
+        return;
+
+    mNodes.reserve(2 * items.size() - 1);
+
+    std::vector<BuildEntry> entries(items.size());
+
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        leaves[i] = Allocate();
+
+        mNodes[leaves[i]].Bounds = ToBox(items[i].Box);
+        mNodes[leaves[i]].Value  = items[i].Value;
+
+        entries[i] = BuildEntry{.Center = items[i].Box.Center, .Leaf = leaves[i]};
+    }
+
+    mRoot      = BuildSubtree(entries);
+    mLeafCount = items.size();
+}
+
+size_t DynamicBvh::Size() const
+{
+    return mLeafCount;
+}
+
+uint32_t DynamicBvh::GetHeight() const
+{
+    if (mRoot == Null)
+        return 0;
+
+    return static_cast<uint32_t>(mNodes[mRoot].Height);
+}
+
+void DynamicBvh::QueryFrustum(const Frustum &frustum, std::vector<uint64_t> &out) const
+{
+    if (mRoot == Null)
+        return;
+
+    static constexpr uint8_t AllPlanes = (1 << 6) - 1;
+
+    // Each node carries the mask of planes it still straddles:
+    std::vector<std::pair<NodeId, uint8_t>> stack;
+    stack.reserve(64);
+    stack.emplace_back(mRoot, AllPlanes);
+
+    while (!stack.empty())
+    {
+        const auto [idx, parentMask] = stack.back();
+        stack.pop_back();
+
+        const Node &node = mNodes[idx];
+
+        const glm::vec3 center = 0.5f * (node.Bounds.Max + node.Bounds.Min);
+        const glm::vec3 extent = 0.5f * (node.Bounds.Max - node.Bounds.Min);
+
+        uint8_t mask    = parentMask;
+        bool    outside = false;
+
+        for (size_t i = 0; i < 6 && mask != 0; i++)
+        {
+            if ((mask & (1 << i)) == 0)
+                continue;
+
+            const auto  plane  = frustum.Planes[i];
+            const auto  normal = glm::vec3(plane);
+            const float radius = glm::dot(glm::abs(normal), extent);
+            const float dist   = glm::dot(normal, center) + plane.w;
+
+            if (dist < -radius)
+            {
+                outside = true;
+                break;
+            }
+
+            // Whole box is on the inner side of this plane:
+            if (dist >= radius)
+                mask &= static_cast<uint8_t>(~(1 << i));
+        }
+
+        if (outside)
+            continue;
+
+        if (node.IsLeaf())
+        {
+            out.push_back(node.Value);
+            continue;
+        }
+
+        stack.emplace_back(node.Children[0], mask);
+        stack.emplace_back(node.Children[1], mask);
+    }
+}
+
+void DynamicBvh::QueryBox(const AABB &box, std::vector<uint64_t> &out) const
+{
+    if (mRoot == Null)
+        return;
+
+    const Box bounds = ToBox(box);
+
+    std::vector<NodeId> stack;
+    stack.reserve(64);
+    stack.push_back(mRoot);
+
+    while (!stack.empty())
+    {
+        const Node &node = mNodes[stack.back()];
+        stack.pop_back();
+
+        if (!Overlaps(node.Bounds, bounds))
+            continue;
+
+        if (node.IsLeaf())
+        {
+            out.push_back(node.Value);
+            continue;
+        }
+
+        stack.push_back(node.Children[0]);
+        stack.push_back(node.Children[1]);
+    }
+}
+
+void DynamicBvh::QueryRay(glm::vec3 origin, glm::vec3 direction, float maxDistance,
+                          std::vector<RayHit> &out) const
+{
+    if (mRoot == Null)
+        return;
+
+    // Slab test, returns entry distance or none if the ray misses:
+    auto intersect = [&](const Box &box) -> std::optional<float> {
+        float entry = 0.0f;
+        float exit  = maxDistance;
+
+        for (int axis = 0; axis < 3; axis++)
+        {
+            // Parallel rays either stay within the slab or never enter it:
+            if (direction[axis] == 0.0f)
+            {
+                if (origin[axis] < box.Min[axis] || origin[axis] > box.Max[axis])
+                    return std::nullopt;
+
+                continue;
+            }
+
+            const float inv = 1.0f / direction[axis];
+            const float t0  = (box.Min[axis] - origin[axis]) * inv;
+            const float t1  = (box.Max[axis] - origin[axis]) * inv;
+
+            entry = std::max(entry, std::min(t0, t1));
+            exit  = std::min(exit, std::max(t0, t1));
+
+            if (entry > exit)
+                return std::nullopt;
+        }
+
+        return entry;
+    };
+
+    const size_t first = out.size();
+
+    std::vector<NodeId> stack;
+    stack.reserve(64);
+    stack.push_back(mRoot);
+
+    while (!stack.empty())
+    {
+        const Node &node = mNodes[stack.back()];
+        stack.pop_back();
+
+        const auto distance = intersect(node.Bounds);
+
+        if (!distance)
+            continue;
+
+        if (node.IsLeaf())
+        {
+            out.push_back(RayHit{.Value = node.Value, .Distance = *distance});
+            continue;
+        }
+
+        stack.push_back(node.Children[0]);
+        stack.push_back(node.Children[1]);
+    }
+
+    std::sort(out.begin() + static_cast<std::ptrdiff_t>(first), out.end(),
+              [](const RayHit &a, const RayHit &b) { return a.Distance < b.Distance; });
+}
+
+DynamicBvh::Box DynamicBvh::ToBox(const AABB &box)
+{
+    return Box{.Min = box.Center - box.Extent, .Max = box.Center + box.Extent};
+}
+
+DynamicBvh::Box DynamicBvh::Union(const Box &a, const Box &b)
+{
+    return Box{.Min = glm::min(a.Min, b.Min), .Max = glm::max(a.Max, b.Max)};
+}
+
+float DynamicBvh::HalfArea(const Box &box)
+{
+    const glm::vec3 size = box.Max - box.Min;
+
+    return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+bool DynamicBvh::Contains(const Box &outer, const Box &inner)
+{
+    return glm::all(glm::lessThanEqual(outer.Min, inner.Min)) &&
+           glm::all(glm::greaterThanEqual(outer.Max, inner.Max));
+}
+
+bool DynamicBvh::Overlaps(const Box &a, const Box &b)
+{
+    return glm::all(glm::lessThanEqual(a.Min, b.Max)) &&
+           glm::all(glm::greaterThanEqual(a.Max, b.Min));
+}
+
+DynamicBvh::NodeId DynamicBvh::Allocate()
+{
+    NodeId idx;
+
+    // Free nodes are chained through their parent links:
+    if (mFreeList != Null)
+    {
+        idx       = mFreeList;
+        mFreeList = mNodes[idx].Parent;
+    }
+    else
+    {
+        idx = static_cast<NodeId>(mNodes.size());
+        mNodes.emplace_back();
+    }
+
+    mNodes[idx] = Node{};
+
+    return idx;
+}
+
+void DynamicBvh::Free(NodeId node)
+{
+    mNodes[node].Parent = mFreeList;
+    mNodes[node].Height = -1;
+
+    mFreeList = node;
+}
+
+void DynamicBvh::InsertLeaf(NodeId leaf)
+{
+    if (mRoot == Null)
+    {
+        mRoot               = leaf;
+        mNodes[leaf].Parent = Null;
+        return;
+    }
+
+    const NodeId sibling   = FindBestSibling(mNodes[leaf].Bounds);
+    const NodeId oldParent = mNodes[sibling].Parent;
+    const NodeId newParent = Allocate();
+
+    auto &parent    = mNodes[newParent];
+    parent.Parent   = oldParent;
+    parent.Bounds   = Union(mNodes[leaf].Bounds, mNodes[sibling].Bounds);
+    parent.Height   = mNodes[sibling].Height + 1;
+    parent.Children = {sibling, leaf};
+
+    mNodes[sibling].Parent = newParent;
+    mNodes[leaf].Parent    = newParent;
+
+    if (oldParent == Null)
+    {
+        mRoot = newParent;
+        return;
+    }
+
+    auto &children = mNodes[oldParent].Children;
+    children[children[0] == sibling ? 0 : 1] = newParent;
+
+    Refit(oldParent);
+}
+
+void DynamicBvh::RemoveLeaf(NodeId leaf)
+{
+    if (leaf == mRoot)
+    {
+        mRoot = Null;
+        return;
+    }
+
+    const NodeId parent      = mNodes[leaf].Parent;
+    const NodeId grandParent = mNodes[parent].Parent;
+    const auto  &siblings    = mNodes[parent].Children;
+    const NodeId sibling     = siblings[0] == leaf ? siblings[1] : siblings[0];
+
+    // Sibling takes place of the parent:
+    mNodes[sibling].Parent = grandParent;
+    Free(parent);
+
+    if (grandParent == Null)
+    {
+        mRoot = sibling;
+        return;
+    }
+
+    auto &children = mNodes[grandParent].Children;
+    children[children[0] == parent ? 0 : 1] = sibling;
+
+    Refit(grandParent);
+}
+
+DynamicBvh::NodeId DynamicBvh::FindBestSibling(const Box &box) const
+{
+    NodeId idx = mRoot;
+
+    // Greedy descent using the surface area heuristic. Pairing with a node costs
+    // the area of the new parent, while descending into it grows every
+    // ancestor on the way, which is paid in either case:
+    while (!mNodes[idx].IsLeaf())
+    {
+        const Node &node = mNodes[idx];
+
+        const float area     = HalfArea(node.Bounds);
+        const float combined = HalfArea(Union(node.Bounds, box));
+
+        const float cost        = 2.0f * combined;
+        const float inheritance = 2.0f * (combined - area);
+
+        auto descendCost = [&](NodeId child) {
+            const Node &c     = mNodes[child];
+            float       grown = HalfArea(Union(c.Bounds, box));
+
+            if (!c.IsLeaf())
+                grown -= HalfArea(c.Bounds);
+
+            return grown + inheritance;
+        };
+
+        const float cost0 = descendCost(node.Children[0]);
+        const float cost1 = descendCost(node.Children[1]);
+
+        if (cost < cost0 && cost < cost1)
+            break;
+
+        idx = cost0 < cost1 ? node.Children[0] : node.Children[1];
+    }
+
+    return idx;
+}
+
+DynamicBvh::NodeId DynamicBvh::BuildSubtree(std::span<BuildEntry> entries)
+{
+    if (entries.size() == 1)
+        return entries[0].Leaf;
+
+    // Median split along the longest axis of the leaf centers. Halves differ
+    // by at most one leaf, so the result is balanced without rotations:
+    Box centers{.Min = entries[0].Center, .Max = entries[0].Center};
+
+    for (const auto &entry : entries)
+    {
+        centers.Min = glm::min(centers.Min, entry.Center);
+        centers.Max = glm::max(centers.Max, entry.Center);
+    }
+
+    const glm::vec3 size = centers.Max - centers.Min;
+
+    int axis = size.x > size.y ? 0 : 1;
+    axis     = size.z > size[axis] ? 2 : axis;
+
+    const size_t half = entries.size() / 2;
+
+    std::nth_element(entries.begin(), entries.begin() + static_cast<std::ptrdiff_t>(half),
+                     entries.end(), [axis](const BuildEntry &a, const BuildEntry &b) {
+                         return a.Center[axis] < b.Center[axis];
+                     });
+
+    const NodeId left  = BuildSubtree(entries.first(half));
+    const NodeId right = BuildSubtree(entries.subspan(half));
+    const NodeId node  = Allocate();
+
+    auto &n    = mNodes[node];
+    n.Children = {left, right};
+    n.Bounds   = Union(mNodes[left].Bounds, mNodes[right].Bounds);
+    n.Height   = 1 + std::max(mNodes[left].Height, mNodes[right].Height);
+
+    mNodes[left].Parent  = node;
+    mNodes[right].Parent = node;
+
+    return node;
+}
+
+void DynamicBvh::Refit(NodeId node)
+{
+    while (node != Null)
+    {
+        node = Balance(node);
+
+        auto &n = mNodes[node];
+
+        const Node &left  = mNodes[n.Children[0]];
+        const Node &right = mNodes[n.Children[1]];
+
+        n.Height = 1 + std::max(left.Height, right.Height);
+        n.Bounds = Union(left.Bounds, right.Bounds);
+
+        node = n.Parent;
+    }
+}
+
+DynamicBvh::NodeId DynamicBvh::Balance(NodeId node)
+{
+    const Node &n = mNodes[node];
+
+    if (n.IsLeaf() || n.Height < 2)
+        return node;
+
+    const int32_t balance = mNodes[n.Children[1]].Height - mNodes[n.Children[0]].Height;
+
+    if (balance > 1)
+        return Rotate(node, 1);
+
+    if (balance < -1)
+        return Rotate(node, 0);
+
+    return node;
+}
+
+DynamicBvh::NodeId DynamicBvh::Rotate(NodeId node, size_t side)
+{
+    const NodeId promoted = mNodes[node].Children[side];
+    const NodeId other    = mNodes[node].Children[1 - side];
+
+    // Taller grandchild stays with the promoted node,
+    // the shorter one takes its place under the demoted node:
+    const auto [first, second] = mNodes[promoted].Children;
+
+    const bool   firstTaller = mNodes[first].Height > mNodes[second].Height;
+    const NodeId taller      = firstTaller ? first : second;
+    const NodeId shorter     = firstTaller ? second : first;
+
+    const NodeId grandParent = mNodes[node].Parent;
+
+    mNodes[promoted].Parent = grandParent;
+
+    if (grandParent == Null)
+        mRoot = promoted;
+    else
+    {
+        auto &children = mNodes[grandParent].Children;
+        children[children[0] == node ? 0 : 1] = promoted;
+    }
+
+    auto &demoted          = mNodes[node];
+    demoted.Parent         = promoted;
+    demoted.Children[side] = shorter;
+    demoted.Bounds         = Union(mNodes[other].Bounds, mNodes[shorter].Bounds);
+    demoted.Height = 1 + std::max(mNodes[other].Height, mNodes[shorter].Height);
+
+    mNodes[shorter].Parent = node;
+
+    auto &up    = mNodes[promoted];
+    up.Children = {node, taller};
+    up.Bounds   = Union(demoted.Bounds, mNodes[taller].Bounds);
+    up.Height   = 1 + std::max(demoted.Height, mNodes[taller].Height);
+
+    return promoted;
+}
@@ -0,0 +1,110 @@
+#pragma once
+
+#include "GeometryData.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Bounding volume hierarchy over boxes which move, appear and disappear over
+// time. Each leaf carries a user value (e.g. a packed instance id). Leaves are
+// inserted next to the sibling growing the tree surface the least, and
+// rotations keep the tree balanced, so each change takes O(log n).
+// Queries append values of the matching leaves to the output:
+class DynamicBvh {
+  public:
+    using NodeId = uint32_t;
+
+    static constexpr NodeId Null = UINT32_MAX;
+
+    struct RayHit {
+        uint64_t Value;
+        // Where the ray enters the box, in units of the direction length:
+        float Distance;
+    };
+
+    struct Item {
+        AABB     Box;
+        uint64_t Value;
+    };
+
+  public:
+    NodeId Insert(const AABB &box, uint64_t value);
+    void   Remove(NodeId leaf);
+    // Leaves staying within their parent only refit the ancestors,
+    // ones moving further away are reinserted:
+    void Update(NodeId leaf, const AABB &box);
+    void SetValue(NodeId leaf, uint64_t value);
+    void Clear();
+
+    // Replaces the contents with a tree built top-down over the items, much
+    // faster than inserting them one by one. Leaf of each item is written
+    // at its position in leaves:
+    void Build(std::span<const Item> items, std::span<NodeId> leaves);
+
+    [[nodiscard]] size_t   Size() const;
+    [[nodiscard]] uint32_t GetHeight() const;
+
+    // Planes which fully contain a node aren't tested again in its subtree,
+    // subtrees inside the frustum are gathered without any tests:
+    void QueryFrustum(const Frustum &frustum, std::vector<uint64_t> &out) const;
+    void QueryBox(const AABB &box, std::vector<uint64_t> &out) const;
+    // Leaves whose box the ray enters within maxDistance, nearest first:
+    void QueryRay(glm::vec3 origin, glm::vec3 direction, float maxDistance,
+                  std::vector<RayHit> &out) const;
+
+  private:
+    struct Box {
+        glm::vec3 Min;
+        glm::vec3 Max;
+    };
+
+    struct Node {
+        Box    Bounds;
+        NodeId Parent = Null;
+        // Both are null for leaves:
+        std::array<NodeId, 2> Children = {Null, Null};
+        uint64_t              Value    = 0;
+        // Leaves are at height 0, free nodes at -1:
+        int32_t Height = 0;
+
+        [[nodiscard]] bool IsLeaf() const;
+    };
+
+    static Box   ToBox(const AABB &box);
+    static Box   Union(const Box &a, const Box &b);
+    static float HalfArea(const Box &box);
+    static bool  Contains(const Box &outer, const Box &inner);
+    static bool  Overlaps(const Box &a, const Box &b);
+
+    NodeId Allocate();
+    void   Free(NodeId node);
+
+    void   InsertLeaf(NodeId leaf);
+    void   RemoveLeaf(NodeId leaf);
+    NodeId FindBestSibling(const Box &box) const;
+
+    // Leaves are sorted by center during builds, kept compact for cache locality:
+    struct BuildEntry {
+        glm::vec3 Center;
+        NodeId    Leaf;
+    };
+
+    NodeId BuildSubtree(std::span<BuildEntry> entries);
+
+    // Walks up to the root, rebalancing and recomputing bounds:
+    void   Refit(NodeId node);
+    NodeId Balance(NodeId node);
+    // Promotes the child on given side in place of the node:
+    NodeId Rotate(NodeId node, size_t side);
+
+  private:
+    std::vector<Node> mNodes;
+
+    NodeId mRoot      = Null;
+    NodeId mFreeList  = Null;
+    size_t mLeafCount = 0;
+};
@@ -3,6 +3,8 @@
 
 #include "VertexLayout.h"
 
+#include <array>
+#include <cmath>
 #include <limits>
 
 GeometryData::GeometryData(const GeometrySpec &spec)
@@ -20,6 +22,19 @@ bool operator==(const GeometryLayout &lhs, const GeometryLayout &rhs)
     return idxCompat && vertCompat;
 }
 
+VkIndexType GetIndexType(size_t vertexCount)
+{
+    if (vertexCount <= std::numeric_limits<uint16_t>::max())
+        return VK_INDEX_TYPE_UINT16;
+
+    return VK_INDEX_TYPE_UINT32;
+}
+
+size_t GetIndexSize(VkIndexType indexType)
+{
+    return indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t);
+}
+
 std::array<glm::vec3, 8> AABB::GetVertices() const
 {
     return {
@@ -113,3 +128,65 @@ AABB AABB::GetConservativeTransformedAABB(glm::mat4 transform) const
 
     return AABB{.Center = center, .Extent = extent};
 }
+
+Frustum Frustum::FromMatrix(glm::mat4 viewProj)
+{
+    // Rows of the matrix are columns of its transpose:
+    auto rows = glm::transpose(viewProj);
+
+    return Frustum{
+        .Planes = {
+            rows[3] + rows[0], rows[3] - rows[0], rows[3] + rows[1],
+            rows[3] - rows[1], rows[2],           rows[3] - rows[2],
+        },
+    };
+}
+
+bool Frustum::Intersects(const AABB &box) const
+{
+    for (auto plane : Planes)
+    {
+        auto normal = glm::vec3(plane);
+
+        // Projected half size of the box onto the plane normal:
+        float radius = glm::dot(glm::abs(normal), box.Extent);
+
+        if (glm::dot(normal, box.Center) + plane.w < -radius)
+            return false;
+    }
+
+    return true;
+}
+
+bool Meshlet::IsInView(glm::mat4 mvp) const
+{
+    // Frustum planes in the space of the meshlet:
+    const auto frustum = Frustum::FromMatrix(mvp);
+
+    for (auto plane : frustum.Planes)
+    {
+        auto normal = glm::vec3(plane);
+
+        if (glm::dot(normal, Center) + plane.w < -Radius * glm::length(normal))
+            return false;
+    }
+
+    return true;
+}
+
+bool Meshlet::IsBackfacing(glm::vec4 eye) const
+{
+    if (ConeCutoff >= 1.0f)
+        return false;
+
+    auto eyeDir = glm::vec3(eye);
+
+    // Orthographic view, all view rays are parallel:
+    if (std::abs(eye.w) <= 1e-6f * glm::length(eyeDir))
+        return glm::dot(glm::normalize(eyeDir), ConeAxis) >= ConeCutoff;
+
+    auto toCenter = Center - eyeDir / eye.w;
+
+    return glm::dot(toCenter, ConeAxis) >=
+           ConeCutoff * glm::length(toCenter) + Radius;
+}
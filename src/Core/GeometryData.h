@@ -5,6 +5,8 @@
 
 #include <glm/glm.hpp>
 
+#include <vector>
+
 struct GeometrySpec;
 
 /// Aggregate of vertex layout with index type information.
@@ -15,6 +17,11 @@ struct GeometryLayout {
 
 bool operator==(const GeometryLayout &lhs, const GeometryLayout &rhs);
 
+/// Smallest index type able to address given number of vertices.
+VkIndexType GetIndexType(size_t vertexCount);
+/// Size in bytes of a single index of given type.
+size_t GetIndexSize(VkIndexType indexType);
+
 /// Axis aligned bounding box
 struct AABB {
     glm::vec3 Center;
@@ -29,6 +36,46 @@ struct AABB {
     [[nodiscard]] static std::array<std::array<size_t, 2>, 12> GetEdgesIds();
 };
 
+/// Planes of a view frustum with inward facing normals, extracted from
+/// a view-projection matrix with depth in [0, 1] (Gribb-Hartmann).
+/// Planes are in the space the matrix transforms from:
+struct Frustum {
+    std::array<glm::vec4, 6> Planes;
+
+    static Frustum FromMatrix(glm::mat4 viewProj);
+
+    // Conservative, boxes near the corners of the frustum may pass:
+    [[nodiscard]] bool Intersects(const AABB &box) const;
+};
+
+/// Coarser level of detail of a geometry. All levels share the vertex buffer,
+/// each one is a range of the index buffer.
+struct GeometryLod {
+    uint32_t FirstIndex;
+    uint32_t IndexCount;
+    // Simplification error relative to the bounding box diagonal:
+    float Error;
+};
+
+/// Cluster of nearby triangles with bounds for culling it as a whole.
+/// Triangles of each meshlet are a range of the full resolution indices.
+struct Meshlet {
+    glm::vec3 Center;
+    float     Radius;
+    // Normals of all triangles are within the cone around the axis,
+    // cutoff is the sine of its half angle (1 if it can't be culled):
+    glm::vec3 ConeAxis;
+    float     ConeCutoff;
+    uint32_t  FirstIndex;
+    uint32_t  IndexCount;
+
+    // Bounding sphere against the frustum of given mvp matrix:
+    [[nodiscard]] bool IsInView(glm::mat4 mvp) const;
+    // Whether all triangles face away from the viewer. Eye is in the same
+    // space as the meshlet, w = 0 means a direction (orthographic view):
+    [[nodiscard]] bool IsBackfacing(glm::vec4 eye) const;
+};
+
 /// Wrapper aroung (owning) buffers for vertex and index data
 /// also contains the bounding box and geometry layout.
 struct GeometryData {
@@ -38,9 +85,17 @@ struct GeometryData {
     GeometryLayout Layout;
     OpaqueBuffer   VertexData;
     OpaqueBuffer   IndexData;
-    size_t         VertexCount;
-    size_t         IndexCount;
+    size_t         VertexCount = 0;
+    size_t         IndexCount  = 0;
     AABB           BBox;
+
+    // Levels of detail from finest to coarsest. Full resolution geometry
+    // is the first IndexCount indices, the rest of the index buffer
+    // holds indices of the coarser levels:
+    std::vector<GeometryLod> Lods;
+
+    // Clusters of the full resolution geometry, empty if not built:
+    std::vector<Meshlet> Meshlets;
 };
 
 /// Geometry specification, i.e. minimal information to correctly
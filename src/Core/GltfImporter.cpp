@@ -1,9 +1,18 @@
 #include "GltfImporter.h"
 #include "Pch.h"
 
+#include "MappedFile.h"
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MeshoptDecoder.h"
 #include "TangentsGenerator.h"
+#include "TextureRegistry.h"
+#include "ThreadPool.h"
+#include "Timer.h"
 #include "Vassert.h"
 #include "VertexLayout.h"
+#include "VertexPacking.h"
 
 #include <fastgltf/core.hpp>
 #include <fastgltf/glm_element_traits.hpp>
@@ -12,8 +21,246 @@
 
 #include <glm/gtc/quaternion.hpp>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <format>
 #include <iostream>
+#include <mutex>
 #include <ranges>
+#include <set>
+#include <span>
+#include <utility>
+
+void PrimitiveData::AllocateIndices()
+{
+    IndexType = GetIndexType(VertexCount);
+
+    const auto idxSize = GetIndexSize(IndexType);
+    Indices            = OpaqueBuffer(IndexCount * idxSize, idxSize);
+}
+
+uint32_t PrimitiveData::GetIndex(size_t idx) const
+{
+    if (IndexType == VK_INDEX_TYPE_UINT16)
+        return reinterpret_cast<const uint16_t *>(Indices.Data)[idx];
+
+    return reinterpret_cast<const uint32_t *>(Indices.Data)[idx];
+}
+
+void PrimitiveData::SetIndex(size_t idx, uint32_t value)
+{
+    if (IndexType == VK_INDEX_TYPE_UINT16)
+    {
+        vassert(value <= std::numeric_limits<uint16_t>::max());
+        reinterpret_cast<uint16_t *>(Indices.Data)[idx] = static_cast<uint16_t>(value);
+    }
+    else
+        reinterpret_cast<uint32_t *>(Indices.Data)[idx] = value;
+}
+
+OptimizationStats &OptimizationStats::operator+=(const OptimizationStats &other)
+{
+    Triangles += other.Triangles;
+    VerticesBefore += other.VerticesBefore;
+    VerticesAfter += other.VerticesAfter;
+    CacheMissesBefore += other.CacheMissesBefore;
+    CacheMissesAfter += other.CacheMissesAfter;
+
+    return *this;
+}
+
+static float Ratio(size_t num, size_t denom)
+{
+    return denom == 0 ? 0.0f : static_cast<float>(num) / static_cast<float>(denom);
+}
+
+float OptimizationStats::AcmrBefore() const
+{
+    return Ratio(CacheMissesBefore, Triangles);
+}
+
+float OptimizationStats::AcmrAfter() const
+{
+    return Ratio(CacheMissesAfter, Triangles);
+}
+
+float OptimizationStats::AtvrBefore() const
+{
+    return Ratio(CacheMissesBefore, VerticesBefore);
+}
+
+float OptimizationStats::AtvrAfter() const
+{
+    return Ratio(CacheMissesAfter, VerticesAfter);
+}
+
+TangentBenchmark &TangentBenchmark::operator+=(const TangentBenchmark &other)
+{
+    Vertices += other.Vertices;
+    FastSeconds += other.FastSeconds;
+    MikkSeconds += other.MikkSeconds;
+    MaxAngle = std::max(MaxAngle, other.MaxAngle);
+    AngleSum += other.AngleSum;
+    SignMismatches += other.SignMismatches;
+
+    return *this;
+}
+
+float TangentBenchmark::MeanAngle() const
+{
+    return Vertices == 0 ? 0.0f : static_cast<float>(AngleSum / Vertices);
+}
+
+EncodeStats &EncodeStats::operator+=(const EncodeStats &other)
+{
+    Vertices += other.Vertices;
+    Seconds += other.Seconds;
+
+    return *this;
+}
+
+float EncodeStats::VerticesPerSecond() const
+{
+    return Seconds == 0.0f ? 0.0f : static_cast<float>(Vertices) / Seconds;
+}
+
+const char *GetIssueName(ImportIssue issue)
+{
+    switch (issue)
+    {
+    case ImportIssue::AttributeCountMismatch:
+        return "attribute count mismatch";
+    case ImportIssue::DegenerateTexCoords:
+        return "degenerate texcoord range";
+    case ImportIssue::MissingTexCoords:
+        return "missing texcoords";
+    case ImportIssue::MissingNormals:
+        return "missing normals";
+    case ImportIssue::DegenerateNormal:
+        return "degenerate normals";
+    case ImportIssue::UnnormalizedNormal:
+        return "unnormalized normals";
+    case ImportIssue::DegenerateTangent:
+        return "degenerate tangents";
+    case ImportIssue::UnnormalizedTangent:
+        return "unnormalized tangents";
+    }
+
+    return "unknown issue";
+}
+
+bool PrimitiveDiagnostics::Empty() const
+{
+    return std::ranges::all_of(Counts, [](size_t count) { return count == 0; });
+}
+
+size_t PrimitiveDiagnostics::Count(ImportIssue issue) const
+{
+    return Counts[static_cast<size_t>(issue)];
+}
+
+std::string PrimitiveDiagnostics::Summary() const
+{
+    auto res =
+        std::format("Gltf file: {} mesh: {} prim: {}", Filename, GltfMesh, GltfPrim);
+
+    for (size_t i = 0; i < ImportIssueCount; i++)
+    {
+        if (Counts[i] == 0)
+            continue;
+
+        const auto issue = static_cast<ImportIssue>(i);
+
+        res += std::format(", {}: {}", GetIssueName(issue), Counts[i]);
+
+        if (!Examples[i].empty())
+            res += std::format(" (first: {})", Examples[i].front());
+    }
+
+    return res;
+}
+
+// Gathers issues of a single primitive. Decode tasks report concurrently,
+// so counts are atomic and only the first few reports of each issue take
+// the lock to store their description:
+class DiagnosticsCollector {
+  public:
+    DiagnosticsCollector(const ModelConfig &config, PrimitiveTaskData data)
+        : mFilename(config.Filepath.filename().string()), mGltfMesh(data.GltfMesh),
+          mGltfPrim(data.GltfPrim)
+    {
+    }
+
+    template <typename... Args>
+    void Report(ImportIssue issue, std::format_string<Args...> fmt, Args &&...args)
+    {
+        const auto idx  = static_cast<size_t>(issue);
+        const auto prev = mCounts[idx].fetch_add(1, std::memory_order_relaxed);
+
+        if (prev >= PrimitiveDiagnostics::MaxExamples)
+            return;
+
+        auto desc = std::format(fmt, std::forward<Args>(args)...);
+
+        std::lock_guard lock(mMutex);
+        mExamples[idx].push_back(std::move(desc));
+    }
+
+    // Degenerate vectors are reported and rejected, the caller
+    // then keeps the default. Others only get reported if they
+    // are not normalized:
+    bool CheckUnit(glm::vec3 v, size_t index, ImportIssue degenerate,
+                   ImportIssue unnormalized)
+    {
+        const float tolerance = 0.01f;
+
+        const float len = glm::length(v);
+
+        if (len < tolerance)
+        {
+            Report(degenerate, "vertex {}: {} {} {}", index, v.x, v.y, v.z);
+            return false;
+        }
+
+        if (std::abs(len - 1.0f) > tolerance)
+            Report(unnormalized, "vertex {}: {} {} {}", index, v.x, v.y, v.z);
+
+        return true;
+    }
+
+    // Logs a single summary line if anything was reported.
+    // Has to be called after all decode tasks are done:
+    std::optional<PrimitiveDiagnostics> Finish()
+    {
+        PrimitiveDiagnostics res{
+            .Filename = mFilename,
+            .GltfMesh = mGltfMesh,
+            .GltfPrim = mGltfPrim,
+        };
+
+        for (size_t i = 0; i < ImportIssueCount; i++)
+            res.Counts[i] = mCounts[i].load(std::memory_order_relaxed);
+
+        if (res.Empty())
+            return std::nullopt;
+
+        res.Examples = std::move(mExamples);
+
+        std::cerr << res.Summary() + '\n';
+
+        return res;
+    }
+
+  private:
+    std::string mFilename;
+    int64_t     mGltfMesh;
+    int64_t     mGltfPrim;
+
+    std::array<std::atomic<size_t>, ImportIssueCount>      mCounts{};
+    std::array<std::vector<std::string>, ImportIssueCount> mExamples;
+    std::mutex                                             mMutex;
+};
 
 struct VertexLoadFlags {
     bool LoadTexCoord;
@@ -43,39 +290,276 @@ static VertexLoadFlags GetLoadFlags(Vertex::Layout vLayout)
     };
 }
 
+// Returns bytes of a data source, if they are already in memory:
+static std::span<const uint8_t> GetSourceBytes(const fastgltf::DataSource &source)
+{
+    auto AsBytes = [](const auto &bytes) {
+        return std::span(reinterpret_cast<const uint8_t *>(bytes.data()), bytes.size());
+    };
+
+    if (auto *src = std::get_if<fastgltf::sources::Array>(&source))
+        return AsBytes(src->bytes);
+
+    if (auto *src = std::get_if<fastgltf::sources::Vector>(&source))
+        return AsBytes(src->bytes);
+
+    if (auto *src = std::get_if<fastgltf::sources::ByteView>(&source))
+        return AsBytes(src->bytes);
+
+    return {};
+}
+
+// Modes and filters unknown to the decoder fail the whole file:
+static std::optional<MeshoptDecoder::Mode> GetMeshoptMode(
+    fastgltf::MeshoptCompressionMode mode)
+{
+    switch (mode)
+    {
+    case fastgltf::MeshoptCompressionMode::Attributes:
+        return MeshoptDecoder::Mode::Attributes;
+    case fastgltf::MeshoptCompressionMode::Triangles:
+        return MeshoptDecoder::Mode::Triangles;
+    case fastgltf::MeshoptCompressionMode::Indices:
+        return MeshoptDecoder::Mode::Indices;
+    default:
+        return std::nullopt;
+    }
+}
+
+static std::optional<MeshoptDecoder::Filter> GetMeshoptFilter(
+    fastgltf::MeshoptCompressionFilter filter)
+{
+    switch (filter)
+    {
+    case fastgltf::MeshoptCompressionFilter::None:
+        return MeshoptDecoder::Filter::None;
+    case fastgltf::MeshoptCompressionFilter::Octahedral:
+        return MeshoptDecoder::Filter::Octahedral;
+    case fastgltf::MeshoptCompressionFilter::Quaternion:
+        return MeshoptDecoder::Filter::Quaternion;
+    case fastgltf::MeshoptCompressionFilter::Exponential:
+        return MeshoptDecoder::Filter::Exponential;
+    default:
+        return std::nullopt;
+    }
+}
+
 struct GltfAsset::Impl {
-    Impl(const std::filesystem::path &path, bool loadBuffers)
+    Impl(const std::filesystem::path &path, bool loadBuffers, ThreadPool &pool)
     {
-        fastgltf::Parser parser(fastgltf::Extensions::KHR_materials_diffuse_transmission);
-        auto             data = fastgltf::GltfDataBuffer::FromPath(path);
+        fastgltf::Parser parser(fastgltf::Extensions::KHR_materials_diffuse_transmission |
+                                fastgltf::Extensions::EXT_meshopt_compression |
+                                fastgltf::Extensions::KHR_mesh_quantization);
+
+        auto data = fastgltf::GltfDataBuffer::FromPath(path);
 
         vassert(data.error() == fastgltf::Error::None,
                 "Failed to load a gltf file: " + path.string());
 
-        auto loadOptions = fastgltf::Options::None;
-
-        if (loadBuffers)
-            loadOptions = fastgltf::Options::LoadExternalBuffers;
-
-        auto load = parser.loadGltf(data.get(), path.parent_path(), loadOptions);
+        // External buffers are mapped below instead of being read by fastgltf:
+        auto load =
+            parser.loadGltf(data.get(), path.parent_path(), fastgltf::Options::None);
 
         vassert(load.error() == fastgltf::Error::None,
                 "Failed to load a gltf file: " + path.string());
 
         Asset = std::move(load.get());
+
+        if (loadBuffers)
+        {
+            MapBuffers(path.parent_path());
+            Valid = DecodeCompressedViews(path, pool);
+        }
+    }
+
+    // Replaces external buffer uris with views of memory-mapped files,
+    // so that parsing can start right away and only the accessors
+    // that are actually decoded get paged in:
+    void MapBuffers(const std::filesystem::path &workingDir)
+    {
+        Mappings.resize(Asset.buffers.size());
+
+        for (auto [id, buffer] : std::views::enumerate(Asset.buffers))
+        {
+            auto *uri = std::get_if<fastgltf::sources::URI>(&buffer.data);
+
+            if (uri == nullptr)
+                continue;
+
+            vassert(uri->uri.isLocalPath(), "Only local gltf buffers are supported!");
+
+            auto &file = Mappings[id];
+            file       = MappedFile(workingDir / uri->uri.fspath());
+
+            vassert(file.IsValid() &&
+                        uri->fileByteOffset + buffer.byteLength <= file.Size(),
+                    "Failed to map a gltf buffer: " + std::string(uri->uri.string()));
+
+            auto bytes = file.Bytes().subspan(uri->fileByteOffset, buffer.byteLength);
+
+            buffer.data = fastgltf::sources::ByteView{
+                .bytes = fastgltf::span<const std::byte>(
+                    reinterpret_cast<const std::byte *>(bytes.data()), bytes.size()),
+                .mimeType = uri->mimeType,
+            };
+        }
+    }
+
+    // Decodes buffer views compressed with EXT_meshopt_compression into new
+    // buffers and points the views at them, so that accessors are read
+    // the same way as for uncompressed files. Views are decoded in parallel.
+    // Returns false if any of them is malformed, leaving the views untouched:
+    bool DecodeCompressedViews(const std::filesystem::path &path, ThreadPool &pool)
+    {
+        std::vector<size_t> viewIds;
+
+        for (auto [id, view] : std::views::enumerate(Asset.bufferViews))
+        {
+            if (view.meshoptCompression)
+                viewIds.push_back(id);
+        }
+
+        if (viewIds.empty())
+            return true;
+
+        std::vector<std::vector<std::byte>> decoded(viewIds.size());
+        std::atomic_bool                    failed = false;
+
+        pool.ParallelFor(viewIds.size(), 1, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; i++)
+            {
+                const auto &meshopt = *Asset.bufferViews[viewIds[i]].meshoptCompression;
+
+                const auto mode   = GetMeshoptMode(meshopt.mode);
+                const auto filter = GetMeshoptFilter(meshopt.filter);
+
+                if (!mode.has_value() || !filter.has_value())
+                {
+                    std::cerr << "Unsupported meshopt compression in " << path.string()
+                              << '\n';
+                    failed = true;
+                    continue;
+                }
+
+                auto src = GetSourceBytes(Asset.buffers[meshopt.bufferIndex].data);
+
+                if (meshopt.byteOffset + meshopt.byteLength > src.size())
+                {
+                    std::cerr << "Compressed buffer view out of bounds in "
+                              << path.string() << '\n';
+                    failed = true;
+                    continue;
+                }
+
+                src = src.subspan(meshopt.byteOffset, meshopt.byteLength);
+
+                auto &dst = decoded[i];
+                dst.resize(meshopt.count * meshopt.byteStride);
+
+                const bool ok = MeshoptDecoder::Decode(
+                    std::span(reinterpret_cast<uint8_t *>(dst.data()), dst.size()),
+                    meshopt.count, meshopt.byteStride, src, *mode, *filter);
+
+                if (!ok)
+                {
+                    std::cerr << "Malformed compressed buffer view in " << path.string()
+                              << '\n';
+                    failed = true;
+                    continue;
+                }
+
+                // Compressed data is not needed anymore:
+                if (meshopt.bufferIndex < Mappings.size())
+                {
+                    if (const auto &file = Mappings[meshopt.bufferIndex]; file.IsValid())
+                        file.Evict(src);
+                }
+            }
+        });
+
+        if (failed)
+            return false;
+
+        // Buffers are only appended once no decoding task reads them:
+        for (auto [viewId, bytes] : std::views::zip(viewIds, decoded))
+        {
+            auto       &view    = Asset.bufferViews[viewId];
+            const auto &meshopt = *view.meshoptCompression;
+
+            if (meshopt.mode == fastgltf::MeshoptCompressionMode::Attributes)
+                view.byteStride = meshopt.byteStride;
+
+            view.bufferIndex = Asset.buffers.size();
+            view.byteOffset  = 0;
+            view.byteLength  = bytes.size();
+            view.meshoptCompression.reset();
+
+            Asset.buffers.push_back(fastgltf::Buffer{
+                .byteLength = bytes.size(),
+                .data =
+                    fastgltf::sources::Vector{
+                        .bytes    = std::move(bytes),
+                        .mimeType = fastgltf::MimeType::GltfBuffer,
+                    },
+            });
+        }
+
+        return true;
+    }
+
+    // Pages of a primitive's source data are dropped once it is encoded.
+    // Views shared with other primitives are simply paged in again:
+    void EvictPrimitive(const fastgltf::Primitive &primitive)
+    {
+        auto EvictAccessor = [&](size_t accessorId) {
+            auto &viewId = Asset.accessors[accessorId].bufferViewIndex;
+
+            if (!viewId.has_value())
+                return;
+
+            auto &view = Asset.bufferViews[*viewId];
+
+            if (view.bufferIndex >= Mappings.size())
+                return;
+
+            auto &file = Mappings[view.bufferIndex];
+
+            if (!file.IsValid())
+                return;
+
+            auto buffer = GetSourceBytes(Asset.buffers[view.bufferIndex].data);
+            file.Evict(buffer.subspan(view.byteOffset, view.byteLength));
+        };
+
+        for (const auto &attribute : primitive.attributes)
+            EvictAccessor(attribute.accessorIndex);
+
+        if (primitive.indicesAccessor.has_value())
+            EvictAccessor(*primitive.indicesAccessor);
     }
 
     fastgltf::Asset Asset;
+
+    // Indexed like gltf buffers, invalid for buffers that are not mapped:
+    std::vector<MappedFile> Mappings;
+
+    // False if compressed views couldn't be decoded:
+    bool Valid = true;
 };
 
-GltfAsset::GltfAsset(const std::filesystem::path &filepath)
+GltfAsset::GltfAsset(const std::filesystem::path &filepath, ThreadPool &pool)
 {
-    mPImpl = std::make_unique<GltfAsset::Impl>(filepath, true);
+    mPImpl = std::make_shared<GltfAsset::Impl>(filepath, true, pool);
 }
 
 GltfAsset::~GltfAsset()
 {
-    mPImpl.reset(nullptr);
+    mPImpl.reset();
+}
+
+bool GltfAsset::IsValid() const
+{
+    return mPImpl->Valid;
 }
 
 GltfAsset::GltfAsset(GltfAsset &&other) noexcept
@@ -89,34 +573,63 @@ GltfAsset &GltfAsset::operator=(GltfAsset &&other) noexcept
     return *this;
 }
 
-// Utility function to obtain absolute paths to gltf-referenced images.
+struct TextureSource {
+    // For embedded images this only identifies the image:
+    std::optional<std::filesystem::path> Path;
+    std::span<const uint8_t>             Embedded;
+};
+
+// Utility function to obtain gltf-referenced images. External ones are given
+// by absolute path, images embedded in the glb binary chunk, buffer views or
+// data uris point straight into the loaded buffers.
 // Templated, because it handles several types from fastgltf.
 template <typename T>
-static auto GetTexturePath(fastgltf::Asset &gltf, std::optional<T> &texInfo,
-                           const std::filesystem::path &workingDir)
-    -> std::optional<std::filesystem::path>
+static auto GetTextureSource(fastgltf::Asset &gltf, std::optional<T> &texInfo,
+                             const std::filesystem::path &filepath) -> TextureSource
 {
     // 1. Check if info has value
     if (!texInfo.has_value())
-        return std::nullopt;
+        return {};
 
     // 2. Retrieve image index if present
     auto imgId = gltf.textures[texInfo->textureIndex].imageIndex;
 
     if (!imgId.has_value())
-        return std::nullopt;
+        return {};
 
     // 3. Get data source
     auto &dataSource = gltf.images[imgId.value()].data;
 
-    // 4. Retrieve the URI if present;
-    if (!std::holds_alternative<fastgltf::sources::URI>(dataSource))
-        return std::nullopt;
+    // 4. Retrieve the filepath, if the image is external:
+    if (auto *uri = std::get_if<fastgltf::sources::URI>(&dataSource))
+        return TextureSource{.Path = filepath.parent_path() / uri->uri.fspath()};
 
-    auto &uri = std::get<fastgltf::sources::URI>(dataSource);
+    // 5. Otherwise find the encoded bytes in memory:
+    std::span<const uint8_t> bytes;
+
+    if (auto *view = std::get_if<fastgltf::sources::BufferView>(&dataSource))
+    {
+        auto &bufferView = gltf.bufferViews[view->bufferViewIndex];
+        auto  buffer     = GetSourceBytes(gltf.buffers[bufferView.bufferIndex].data);
+
+        if (bufferView.byteOffset + bufferView.byteLength <= buffer.size())
+            bytes = buffer.subspan(bufferView.byteOffset, bufferView.byteLength);
+    }
+    else
+        bytes = GetSourceBytes(dataSource);
 
-    // 5. Retrieve the filepath:
-    return workingDir / uri.uri.fspath();
+    if (bytes.empty())
+    {
+        std::cerr << "Unsupported data source of image " << *imgId << " in "
+                  << filepath.string() << '\n';
+        return {};
+    }
+
+    // Embedded images are unique per file and image index:
+    auto id = filepath;
+    id += "#image" + std::to_string(*imgId);
+
+    return TextureSource{.Path = id, .Embedded = bytes};
 }
 
 // Small utility to convert from normalized float
@@ -128,24 +641,59 @@ static uint8_t PixelChannelFromFloat(float x)
 
 void GltfAsset::PreprocessMaterials(Scene &scene, std::map<size_t, SceneKey> &keyMap,
                                     std::vector<ImageTaskData> &tasks,
-                                    const ModelConfig          &config)
+                                    const ModelConfig          &config,
+                                    TextureRegistry            &registry)
 {
     using namespace std::views;
 
     vassert(keyMap.empty(), "Key map should be empty!");
     vassert(tasks.empty(), "Tasks vector should be empty!");
 
-    const std::filesystem::path workingDir = config.Filepath.parent_path();
-    const std::string           baseName   = config.Filepath.stem().string();
+    auto             &gltf     = mPImpl->Asset;
+    const std::string baseName = config.Filepath.stem().string();
+
+    // Images are shared through the registry. Each one is acquired only once
+    // per model, and decoded only by the model which acquired it first:
+    std::set<SceneKey> modelImages;
+
+    auto AddImage = [&](const TextureSource &source, Pixel baseColor,
+                        const std::string &name, bool unorm, TextureUsage usage) {
+        const bool compress = config.CompressTextures && source.Path.has_value();
+
+        auto handle = registry.Acquire(source.Path, baseColor, unorm, usage, compress);
+
+        if (!modelImages.insert(handle.Key).second)
+        {
+            registry.Release(handle.Key);
+            return handle.Key;
+        }
+
+        tasks.push_back(ImageTaskData{
+            .ImageKey    = handle.Key,
+            .Path        = source.Path,
+            .BaseColor   = baseColor,
+            .Name        = name,
+            .Unorm       = unorm,
+            .Usage       = usage,
+            .Compress    = compress,
+            .NeedsDecode = handle.IsNew,
+        });
+
+        if (!source.Embedded.empty())
+        {
+            tasks.back().Embedded      = source.Embedded;
+            tasks.back().EmbeddedOwner = mPImpl;
+        }
+
+        return handle.Key;
+    };
 
     // Loop over all materials in gltf:
-    for (auto [id, material] : enumerate(mPImpl->Asset.materials))
+    for (auto [id, material] : enumerate(gltf.materials))
     {
-        // Create new scene material:
-        auto [matKey, mat] = scene.EmplaceMaterial();
-        mat.Name           = baseName + std::to_string(id);
-
-        keyMap[id] = matKey;
+        // Filled in before it's emplaced into the scene:
+        SceneMaterial mat;
+        mat.Name = baseName + std::to_string(id);
 
         // Load alpha information:
         switch (material.alphaMode)
@@ -178,11 +726,8 @@ void GltfAsset::PreprocessMaterials(Scene &scene, std::map<size_t, SceneKey> &ke
 
         // Handle albedo:
         {
-            auto [imgKey, img] = scene.EmplaceImage();
-            mat.Albedo         = imgKey;
-
             auto &albedoInfo = material.pbrData.baseColorTexture;
-            auto  albedoPath = GetTexturePath(mPImpl->Asset, albedoInfo, workingDir);
+            auto  albedoSrc  = GetTextureSource(gltf, albedoInfo, config.Filepath);
 
             auto &fac = material.pbrData.baseColorFactor;
 
@@ -193,23 +738,15 @@ void GltfAsset::PreprocessMaterials(Scene &scene, std::map<size_t, SceneKey> &ke
                 .A = PixelChannelFromFloat(fac.w()),
             };
 
-            tasks.push_back(ImageTaskData{
-                .ImageKey  = imgKey,
-                .Path      = albedoPath,
-                .BaseColor = baseColor,
-                .Name      = mat.Name + " Albedo",
-                .Unorm     = false,
-            });
+            mat.Albedo = AddImage(albedoSrc, baseColor, mat.Name + " Albedo", false,
+                                  TextureUsage::Color);
         }
 
         // Do the same for roughness/metallic:
         if (config.FetchRoughness)
         {
-            auto [imgKey, img] = scene.EmplaceImage();
-            mat.Roughness      = imgKey;
-
             auto &roughnessInfo = material.pbrData.metallicRoughnessTexture;
-            auto roughnessPath = GetTexturePath(mPImpl->Asset, roughnessInfo, workingDir);
+            auto  roughnessSrc  = GetTextureSource(gltf, roughnessInfo, config.Filepath);
 
             auto baseColor = Pixel{
                 .R = PixelChannelFromFloat(0.0f),
@@ -218,35 +755,23 @@ void GltfAsset::PreprocessMaterials(Scene &scene, std::map<size_t, SceneKey> &ke
                 .A = PixelChannelFromFloat(0.0f),
             };
 
-            tasks.push_back(ImageTaskData{
-                .ImageKey  = imgKey,
-                .Path      = roughnessPath,
-                .BaseColor = baseColor,
-                .Name      = mat.Name + " Roughness",
-                .Unorm     = true,
-            });
+            mat.Roughness = AddImage(roughnessSrc, baseColor, mat.Name + " Roughness",
+                                     true, TextureUsage::RoughnessMetallic);
         }
 
         // Do the same for normal map if requested:
         if (config.FetchNormal)
         {
             auto &normalInfo = material.normalTexture;
-            auto  normalPath = GetTexturePath(mPImpl->Asset, normalInfo, workingDir);
+            auto  normalSrc  = GetTextureSource(gltf, normalInfo, config.Filepath);
 
-            if (normalPath.has_value())
-            {
-                auto [imgKey, img] = scene.EmplaceImage();
-                mat.Normal         = imgKey;
-
-                tasks.push_back(ImageTaskData{
-                    .ImageKey  = imgKey,
-                    .Path      = normalPath,
-                    .BaseColor = Pixel{},
-                    .Name      = mat.Name + " Normal",
-                    .Unorm     = true,
-                });
-            }
+            if (normalSrc.Path.has_value())
+                mat.Normal = AddImage(normalSrc, Pixel{}, mat.Name + " Normal", true,
+                                      TextureUsage::Normal);
         }
+
+        // Create new scene material:
+        keyMap[id] = scene.EmplaceMaterial(std::move(mat)).first;
     }
 }
 
@@ -265,15 +790,12 @@ void GltfAsset::PreprocessMeshes(Scene &scene, std::map<size_t, SceneKey> &meshK
     // Iterate all gltf meshes:
     for (auto [gltfMeshId, gltfMesh] : enumerate(mPImpl->Asset.meshes))
     {
-        // Create the new mesh:
-        auto [meshKey, mesh] = scene.EmplaceMesh();
-        mesh.Name            = std::format("{} {}", baseName, gltfMesh.name);
-
-        // Update mesh key map:
-        meshKeyMap[gltfMeshId] = meshKey;
+        // Filled in before it's emplaced into the scene:
+        SceneMesh mesh;
+        mesh.Name = std::format("{} {}", baseName, gltfMesh.name);
 
         // Retrieve its primitives:
-        for (auto [gltfPrimId, gltfPrim] : enumerate(gltfMesh.primitives))
+        for (auto &gltfPrim : gltfMesh.primitives)
         {
             // Emplace new primitive:
             auto &newMeshPrim = mesh.Primitives.emplace_back();
@@ -284,10 +806,19 @@ void GltfAsset::PreprocessMeshes(Scene &scene, std::map<size_t, SceneKey> &meshK
                 auto matId           = matKeyMap.at(*id);
                 newMeshPrim.Material = matId;
             }
+        }
 
+        // Create the new mesh:
+        auto meshKey = scene.EmplaceMesh(std::move(mesh)).first;
+
+        // Update mesh key map:
+        meshKeyMap[gltfMeshId] = meshKey;
+
+        for (auto [gltfPrimId, _] : enumerate(gltfMesh.primitives))
+        {
             tasks.push_back(PrimitiveTaskData{
                 .SceneMesh = meshKey,
-                .ScenePrim = mesh.Primitives.size() - 1,
+                .ScenePrim = static_cast<size_t>(gltfPrimId),
                 .GltfMesh  = gltfMeshId,
                 .GltfPrim  = gltfPrimId,
             });
@@ -414,56 +945,136 @@ static size_t GetIndexCount(fastgltf::Asset &gltf, fastgltf::Primitive &primitiv
     return indexAccessor.count;
 }
 
-PrimitiveData GltfAsset::LoadPrimitive(PrimitiveTaskData data, const ModelConfig &config)
+// Number of elements handled by a single sub-task when decoding
+// large primitives. Smaller accessors are decoded on the calling thread:
+static constexpr size_t ParallelGrainSize = 64 * 1024;
+
+template <typename T>
+struct Bounds {
+    T Min = T(std::numeric_limits<float>::max());
+    T Max = T(std::numeric_limits<float>::lowest());
+
+    void Add(T v)
+    {
+        Min = glm::min(Min, v);
+        Max = glm::max(Max, v);
+    }
+
+    void Merge(const Bounds &other)
+    {
+        Min = glm::min(Min, other.Min);
+        Max = glm::max(Max, other.Max);
+    }
+};
+
+// Reduces bounds of count elements returned by get(index), ranges are
+// reduced in parallel and their partial results merged afterwards:
+template <typename T, typename Getter>
+static Bounds<T> ReduceBounds(ThreadPool &pool, size_t count, Getter &&get)
 {
-    PrimitiveData res{};
+    const size_t rangeCount = (count + ParallelGrainSize - 1) / ParallelGrainSize;
 
-    auto &gltf      = mPImpl->Asset;
-    auto &mesh      = gltf.meshes[data.GltfMesh];
-    auto &primitive = mesh.primitives[data.GltfPrim];
+    std::vector<Bounds<T>> partial(rangeCount);
 
-    auto flags = GetLoadFlags(config.VertexLayout);
+    pool.ParallelFor(count, ParallelGrainSize, [&](size_t begin, size_t end) {
+        auto &bounds = partial[begin / ParallelGrainSize];
 
-    // Retrieve indices:
-    res.IndexCount = GetIndexCount(gltf, primitive);
+        for (size_t i = begin; i < end; i++)
+            bounds.Add(get(i));
+    });
 
-    {
-        res.Indices.resize(res.IndexCount);
+    Bounds<T> res;
 
-        auto &indexAccessor = gltf.accessors[primitive.indicesAccessor.value()];
+    for (const auto &bounds : partial)
+        res.Merge(bounds);
 
-        size_t current = 0;
+    return res;
+}
 
-        fastgltf::iterateAccessor<std::uint32_t>(gltf, indexAccessor,
-                                                 [&](std::uint32_t idx) {
-                                                     res.Indices[current] = idx;
-                                                     current++;
-                                                 });
+// Calls func(value, index) for every element of the accessor.
+// Large accessors are split into ranges decoded in parallel:
+template <typename T, typename F>
+static void DecodeAccessor(ThreadPool &pool, fastgltf::Asset &gltf,
+                           const fastgltf::Accessor &accessor, F &&func)
+{
+    if (accessor.count <= ParallelGrainSize)
+    {
+        fastgltf::iterateAccessorWithIndex<T>(gltf, accessor, func);
+        return;
     }
 
-    // Retrieve vertex attributes:
+    pool.ParallelFor(accessor.count, ParallelGrainSize, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+            func(fastgltf::getAccessorElement<T>(gltf, accessor, i), i);
+    });
+}
+
+static void LoadIndices(ThreadPool &pool, fastgltf::Asset &gltf,
+                        fastgltf::Primitive &primitive, PrimitiveData &res)
+{
+    // Vertex count is retrieved first, since it determines the index type:
     res.VertexCount = GetVertexCount(gltf, primitive);
+    res.IndexCount  = GetIndexCount(gltf, primitive);
+
+    // Indices are decoded directly into the final buffer:
+    res.AllocateIndices();
+
+    auto &indexAccessor = gltf.accessors[primitive.indicesAccessor.value()];
 
-    // Retrieve the positions and calculate bounding box in one go:
+    if (res.IndexCount > ParallelGrainSize)
     {
-        res.Positions.resize(res.VertexCount);
+        DecodeAccessor<std::uint32_t>(pool, gltf, indexAccessor,
+                                      [&](std::uint32_t idx, size_t index) {
+                                          res.SetIndex(index, idx);
+                                      });
+    }
+    else if (res.IndexType == VK_INDEX_TYPE_UINT16)
+        fastgltf::copyFromAccessor<std::uint16_t>(gltf, indexAccessor, res.Indices.Data);
+    else
+        fastgltf::copyFromAccessor<std::uint32_t>(gltf, indexAccessor, res.Indices.Data);
+}
 
-        auto minCoords = glm::vec3(std::numeric_limits<float>::max());
-        auto maxCoords = glm::vec3(std::numeric_limits<float>::lowest());
+PrimitiveData GltfAsset::LoadPrimitive(PrimitiveTaskData data, const ModelConfig &config,
+                                       ThreadPool                          &pool,
+                                       std::optional<TangentBenchmark>     *tangentBench,
+                                       std::optional<PrimitiveDiagnostics> *diagnostics)
+{
+    PrimitiveData res{};
+
+    auto &gltf      = mPImpl->Asset;
+    auto &mesh      = gltf.meshes[data.GltfMesh];
+    auto &primitive = mesh.primitives[data.GltfPrim];
+
+    auto flags = GetLoadFlags(config.VertexLayout);
+
+    DiagnosticsCollector diag(config, data);
+
+    auto CheckCount = [&](const fastgltf::Accessor &accessor, const char *name) {
+        if (accessor.count != res.VertexCount)
+        {
+            diag.Report(ImportIssue::AttributeCountMismatch, "{} {} for {} vertices",
+                        accessor.count, name, res.VertexCount);
+        }
+    };
+
+    LoadIndices(pool, gltf, primitive, res);
+
+    // Retrieve the positions and calculate bounding box:
+    {
+        res.Positions.resize(res.VertexCount);
 
         fastgltf::Accessor &posAccessor =
             GetAttributeAccessor(gltf, primitive, "POSITION");
 
-        fastgltf::iterateAccessorWithIndex<glm::vec3>(
-            gltf, posAccessor, [&](glm::vec3 v, size_t index) {
-                res.Positions[index] = v;
+        DecodeAccessor<glm::vec3>(pool, gltf, posAccessor, [&](glm::vec3 v, size_t index) {
+            res.Positions[index] = v;
+        });
 
-                minCoords = glm::min(minCoords, v);
-                maxCoords = glm::max(maxCoords, v);
-            });
+        auto bounds = ReduceBounds<glm::vec3>(pool, res.VertexCount,
+                                              [&](size_t i) { return res.Positions[i]; });
 
-        res.BBox.Center = 0.5f * (maxCoords + minCoords);
-        res.BBox.Extent = 0.5f * (maxCoords - minCoords);
+        res.BBox.Center = 0.5f * (bounds.Max + bounds.Min);
+        res.BBox.Extent = 0.5f * (bounds.Max - bounds.Min);
     }
 
     // Retrieve texture coords
@@ -478,25 +1089,18 @@ PrimitiveData GltfAsset::LoadPrimitive(PrimitiveTaskData data, const ModelConfig
             fastgltf::Accessor &texcoordAccessor =
                 gltf.accessors[texcoordIt->accessorIndex];
 
-            if (texcoordAccessor.count != res.VertexCount)
-            {
-                std::cerr << "In gltf file " << config.Filepath.string()
-                          << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                          << "Attribute count discrepancy:"
-                          << "num vertices: " << res.VertexCount << ", "
-                          << "num texcoords:" << texcoordAccessor.count << '\n';
-            }
+            CheckCount(texcoordAccessor, "texcoords");
 
-            auto minCoords = glm::vec2(std::numeric_limits<float>::max());
-            auto maxCoords = glm::vec2(std::numeric_limits<float>::lowest());
+            DecodeAccessor<glm::vec2>(pool, gltf, texcoordAccessor,
+                                      [&](glm::vec2 v, size_t index) {
+                                          res.TexCoords[index] = v;
+                                      });
 
-            fastgltf::iterateAccessorWithIndex<glm::vec2>(
-                gltf, texcoordAccessor, [&](glm::vec2 v, size_t index) {
-                    res.TexCoords[index] = v;
+            auto bounds = ReduceBounds<glm::vec2>(
+                pool, res.VertexCount, [&](size_t i) { return res.TexCoords[i]; });
 
-                    minCoords = glm::min(minCoords, v);
-                    maxCoords = glm::max(maxCoords, v);
-                });
+            glm::vec2 minCoords = bounds.Min;
+            glm::vec2 maxCoords = bounds.Max;
 
             glm::vec2 center = 0.5f * (maxCoords + minCoords);
             glm::vec2 extent = 0.5f * (maxCoords - minCoords);
@@ -508,19 +1112,14 @@ PrimitiveData GltfAsset::LoadPrimitive(PrimitiveTaskData data, const ModelConfig
             }
             else
             {
-                std::cerr << "In gltf file " << config.Filepath.string()
-                          << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                          << "degenerate texcoord range: " << minCoords.x << ", "
-                          << minCoords.y << "to " << maxCoords.x << ", " << maxCoords.y
-                          << '\n';
+                diag.Report(ImportIssue::DegenerateTexCoords, "{}, {} to {}, {}",
+                            minCoords.x, minCoords.y, maxCoords.x, maxCoords.y);
             }
         }
 
         else
         {
-            std::cerr << "Gltf file: " << config.Filepath.string()
-                      << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                      << "The primitive doesn't contain texture coordinates.\n";
+            diag.Report(ImportIssue::MissingTexCoords, "no TEXCOORD_0 attribute");
         }
     }
 
@@ -535,26 +1134,9 @@ PrimitiveData GltfAsset::LoadPrimitive(PrimitiveTaskData data, const ModelConfig
             res.Normals.resize(res.VertexCount, defaultNormal);
 
             auto normalHandler = [&](glm::vec3 v, size_t index) {
-                const float tolerance = 0.01f;
-
-                float len = glm::length(v);
-
-                if (len < tolerance)
-                {
-                    std::cerr << "Gltf file: " << config.Filepath.string()
-                              << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                              << "Normal vector is degenerate (close to zero): " << v.x
-                              << " " << v.y << " " << v.z << '\n';
+                if (!diag.CheckUnit(v, index, ImportIssue::DegenerateNormal,
+                                    ImportIssue::UnnormalizedNormal))
                     return;
-                }
-
-                if (std::abs(len - 1.0f) > tolerance)
-                {
-                    std::cerr << "Gltf file: " << config.Filepath.string()
-                              << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                              << "Provided normal vector is not normalized:" << v.x << " "
-                              << v.y << " " << v.z << '\n';
-                }
 
                 // Renormalize anyway just to be sure:
                 res.Normals[index] = glm::normalize(v);
@@ -562,23 +1144,14 @@ PrimitiveData GltfAsset::LoadPrimitive(PrimitiveTaskData data, const ModelConfig
 
             fastgltf::Accessor &normalAccessor = gltf.accessors[normalIt->accessorIndex];
 
-            if (normalAccessor.count != res.VertexCount)
-            {
-                std::cerr << "In gltf file " << config.Filepath.string()
-                          << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                          << "Attribute count discrepancy:"
-                          << "num vertices: " << res.VertexCount << ", "
-                          << "num normals:" << normalAccessor.count << '\n';
-            }
+            CheckCount(normalAccessor, "normals");
 
-            fastgltf::iterateAccessorWithIndex<glm::vec3>(gltf, normalAccessor,
-                                                          normalHandler);
+            DecodeAccessor<glm::vec3>(pool, gltf, normalAccessor, normalHandler);
         }
 
         else
         {
-            std::cerr << "Gltf file: " << config.Filepath.string()
-                      << "primitive doesn't contain normals.\n";
+            diag.Report(ImportIssue::MissingNormals, "no NORMAL attribute");
         }
     }
 
@@ -594,26 +1167,9 @@ PrimitiveData GltfAsset::LoadPrimitive(PrimitiveTaskData data, const ModelConfig
             res.Tangents.resize(res.VertexCount, defaultTangent);
 
             auto tangentHandler = [&](glm::vec4 v, size_t index) {
-                const float tolerance = 0.01f;
-
-                float len = glm::length(glm::vec3(v));
-
-                if (len < tolerance)
-                {
-                    std::cerr << "Gltf file: " << config.Filepath.string()
-                              << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                              << "Tangent vector is degenerate (close to zero): " << v.x
-                              << " " << v.y << " " << v.z << '\n';
+                if (!diag.CheckUnit(glm::vec3(v), index, ImportIssue::DegenerateTangent,
+                                    ImportIssue::UnnormalizedTangent))
                     return;
-                }
-
-                if (std::abs(len - 1.0f) > tolerance)
-                {
-                    std::cerr << "Gltf file: " << config.Filepath.string()
-                              << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                              << "Provided tangent vector is not normalized:" << v.x
-                              << " " << v.y << " " << v.z << '\n';
-                }
 
                 res.Tangents[index] = {glm::normalize(glm::vec3(v)), v.w};
             };
@@ -621,25 +1177,240 @@ PrimitiveData GltfAsset::LoadPrimitive(PrimitiveTaskData data, const ModelConfig
             fastgltf::Accessor &tangentAccessor =
                 gltf.accessors[tangentIt->accessorIndex];
 
-            if (tangentAccessor.count != res.VertexCount)
-            {
-                std::cerr << "In gltf file " << config.Filepath.string()
-                          << " mesh: " << data.GltfMesh << " prim: " << data.GltfPrim
-                          << "Attribute count discrepancy:"
-                          << "num vertices: " << res.VertexCount << ", "
-                          << "num tangents:" << tangentAccessor.count << '\n';
-            }
+            CheckCount(tangentAccessor, "tangents");
 
-            fastgltf::iterateAccessorWithIndex<glm::vec4>(gltf, tangentAccessor,
-                                                          tangentHandler);
+            DecodeAccessor<glm::vec4>(pool, gltf, tangentAccessor, tangentHandler);
+        }
+        else if (config.BenchmarkTangents && tangentBench)
+        {
+            *tangentBench = tangen::Benchmark(res, config.Tangents, pool);
         }
         else
         {
-            tangen::GenerateTangents(res);
+            tangen::GenerateTangents(res, config.Tangents, pool);
         }
     }
 
     // TODO: Fetch colors?
 
+    auto issues = diag.Finish();
+
+    if (diagnostics)
+        *diagnostics = std::move(issues);
+
     return res;
-}
\ No newline at end of file
+}
+
+// Number of vertices decoded at once by the streaming path.
+// Float staging for a chunk is 12KB, so it stays in L1:
+static constexpr size_t StreamChunkSize = 256;
+
+template <typename T>
+static void ReadChunk(fastgltf::Asset &gltf, const fastgltf::Accessor &accessor,
+                      size_t first, std::span<T> dst)
+{
+    for (size_t i = 0; i < dst.size(); i++)
+        dst[i] = fastgltf::getAccessorElement<T>(gltf, accessor, first + i);
+}
+
+// Fused import for the compressed layout - accessors are read chunk by chunk
+// and quantized straight into the vertex buffer, so only the final vertices
+// and indices are ever held in memory. Generating tangents needs the whole
+// primitive, so this only works if the file provides normals and tangents:
+static std::optional<ImportedPrimitive> StreamCompressed(ThreadPool           &pool,
+                                                         fastgltf::Asset      &gltf,
+                                                         fastgltf::Primitive  &primitive,
+                                                         DiagnosticsCollector &diag)
+{
+    const auto attribEnd = primitive.attributes.end();
+
+    auto texcoordIt = primitive.findAttribute("TEXCOORD_0");
+    auto normalIt   = primitive.findAttribute("NORMAL");
+    auto tangentIt  = primitive.findAttribute("TANGENT");
+
+    if (normalIt == attribEnd || tangentIt == attribEnd)
+        return std::nullopt;
+
+    auto &posAccessor     = GetAttributeAccessor(gltf, primitive, "POSITION");
+    auto &normalAccessor  = gltf.accessors[normalIt->accessorIndex];
+    auto &tangentAccessor = gltf.accessors[tangentIt->accessorIndex];
+
+    const fastgltf::Accessor *texcoordAccessor = nullptr;
+
+    if (texcoordIt != attribEnd)
+        texcoordAccessor = &gltf.accessors[texcoordIt->accessorIndex];
+
+    // Attribute count discrepancies are left to the regular path:
+    const size_t vertCount = posAccessor.count;
+
+    bool countsMatch = normalAccessor.count == vertCount;
+    countsMatch      = countsMatch && tangentAccessor.count == vertCount;
+
+    if (texcoordAccessor)
+        countsMatch = countsMatch && texcoordAccessor->count == vertCount;
+
+    if (!countsMatch)
+        return std::nullopt;
+
+    PrimitiveData prim{};
+    LoadIndices(pool, gltf, primitive, prim);
+
+    // Quantization needs bounds of the whole primitive upfront,
+    // they are calculated in a separate pass that doesn't store anything:
+    {
+        auto bounds = ReduceBounds<glm::vec3>(pool, vertCount, [&](size_t i) {
+            return fastgltf::getAccessorElement<glm::vec3>(gltf, posAccessor, i);
+        });
+
+        prim.BBox.Center = 0.5f * (bounds.Max + bounds.Min);
+        prim.BBox.Extent = 0.5f * (bounds.Max - bounds.Min);
+    }
+
+    if (texcoordAccessor)
+    {
+        auto bounds = ReduceBounds<glm::vec2>(pool, vertCount, [&](size_t i) {
+            return fastgltf::getAccessorElement<glm::vec2>(gltf, *texcoordAccessor, i);
+        });
+
+        glm::vec2 center = 0.5f * (bounds.Max + bounds.Min);
+        glm::vec2 extent = 0.5f * (bounds.Max - bounds.Min);
+
+        // Degenerate ranges keep the default bounds, same as in LoadPrimitive:
+        if (extent.x != 0.0 && extent.y != 0.0)
+        {
+            prim.TexBounds.Center = center;
+            prim.TexBounds.Extent = extent;
+        }
+        else
+        {
+            diag.Report(ImportIssue::DegenerateTexCoords, "{}, {} to {}, {}",
+                        bounds.Min.x, bounds.Min.y, bounds.Max.x, bounds.Max.y);
+        }
+    }
+    else
+    {
+        diag.Report(ImportIssue::MissingTexCoords, "no TEXCOORD_0 attribute");
+    }
+
+    ImportedPrimitive res{
+        .Data      = VertexPacking::Allocate(prim, Vertex::PullLayout::Compressed),
+        .TexBounds = prim.TexBounds,
+    };
+
+    auto vertices = new (res.Data.VertexData.Data) Vertex::PullCompressed[vertCount];
+
+    // Large primitives are split into ranges compressed in parallel,
+    // each streaming through its own staging chunks:
+    pool.ParallelFor(vertCount, ParallelGrainSize, [&](size_t begin, size_t end) {
+        std::array<glm::vec3, StreamChunkSize> positions;
+        std::array<glm::vec2, StreamChunkSize> texcoords{};
+        std::array<glm::vec3, StreamChunkSize> normals;
+        std::array<glm::vec4, StreamChunkSize> tangents;
+
+        for (size_t first = begin; first < end; first += StreamChunkSize)
+        {
+            const size_t count = std::min(StreamChunkSize, end - first);
+
+            ReadChunk(gltf, posAccessor, first, std::span(positions).first(count));
+            ReadChunk(gltf, normalAccessor, first, std::span(normals).first(count));
+            ReadChunk(gltf, tangentAccessor, first, std::span(tangents).first(count));
+
+            if (texcoordAccessor)
+            {
+                auto dst = std::span(texcoords).first(count);
+                ReadChunk(gltf, *texcoordAccessor, first, dst);
+            }
+
+            for (size_t i = 0; i < count; i++)
+            {
+                // Degenerate vectors get the same defaults as in LoadPrimitive:
+                glm::vec3 normal = normals[i];
+                glm::vec3 tan3   = glm::vec3(tangents[i]);
+
+                if (diag.CheckUnit(normal, first + i, ImportIssue::DegenerateNormal,
+                                   ImportIssue::UnnormalizedNormal))
+                    normals[i] = glm::normalize(normal);
+                else
+                    normals[i] = glm::vec3(0, -1, 0);
+
+                if (diag.CheckUnit(tan3, first + i, ImportIssue::DegenerateTangent,
+                                   ImportIssue::UnnormalizedTangent))
+                    tangents[i] = glm::vec4(glm::normalize(tan3), tangents[i].w);
+                else
+                    tangents[i] = glm::vec4(1, 0, 0, 1);
+            }
+
+            VertexPacking::CompressVertices(
+                std::span(positions).first(count), std::span(texcoords).first(count),
+                std::span(normals).first(count), std::span(tangents).first(count),
+                prim.BBox, prim.TexBounds, std::span(vertices + first, count));
+        }
+    });
+
+    return res;
+}
+
+ImportedPrimitive GltfAsset::LoadGeometry(PrimitiveTaskData data, const ModelConfig &config,
+                                          ThreadPool &pool)
+{
+    auto &gltf      = mPImpl->Asset;
+    auto &primitive = gltf.meshes[data.GltfMesh].primitives[data.GltfPrim];
+
+    std::optional<ImportedPrimitive> res;
+
+    // Optimization, simplification and clustering need the whole
+    // primitive, so it can't be streamed:
+    const bool streamable =
+        !config.OptimizeMeshes && !config.GenerateLods && !config.BuildMeshlets;
+
+    if (config.VertexLayout == Vertex::PullLayout::Compressed && streamable)
+    {
+        DiagnosticsCollector diag(config, data);
+
+        res = StreamCompressed(pool, gltf, primitive, diag);
+
+        if (res)
+            res->Diagnostics = diag.Finish();
+    }
+
+    if (!res)
+    {
+        std::optional<TangentBenchmark>     tangentBench;
+        std::optional<PrimitiveDiagnostics> diagnostics;
+
+        auto prim = LoadPrimitive(data, config, pool, &tangentBench, &diagnostics);
+
+        std::optional<OptimizationStats> stats;
+
+        if (config.OptimizeMeshes)
+            stats = MeshOptimizer::Optimize(prim);
+
+        if (config.GenerateLods)
+            MeshSimplifier::GenerateLods(prim, config.OptimizeMeshes);
+
+        if (config.BuildMeshlets)
+            MeshletBuilder::Build(prim);
+
+        const auto encodeStart = Timer::Now();
+
+        auto geo = VertexPacking::Encode(prim, config.VertexLayout, &pool);
+
+        const EncodeStats encoding{
+            .Vertices = geo.VertexCount,
+            .Seconds  = Timer::GetDiffSeconds(Timer::Now(), encodeStart),
+        };
+
+        res = ImportedPrimitive{
+            .Data         = std::move(geo),
+            .TexBounds    = prim.TexBounds,
+            .Stats        = stats,
+            .TangentBench = tangentBench,
+            .Encoding     = encoding,
+            .Diagnostics  = std::move(diagnostics),
+        };
+    }
+
+    mPImpl->EvictPrimitive(primitive);
+
+    return std::move(*res);
+}
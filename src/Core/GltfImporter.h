@@ -4,8 +4,16 @@
 #include "Scene.h"
 #include "SceneGraph.h"
 
+#include <array>
 #include <filesystem>
+#include <map>
 #include <memory>
+#include <span>
+#include <string>
+#include <vector>
+
+class TextureRegistry;
+class ThreadPool;
 
 struct TextureBounds {
     glm::vec2 Center = glm::vec2(0.5f);
@@ -15,9 +23,10 @@ struct TextureBounds {
 struct PrimitiveData {
     size_t IndexCount;
     size_t VertexCount;
-    // TODO: Indices could already be stored as
-    // opaque buffer to save that one memcpy
-    std::vector<uint32_t>  Indices;
+    // Indices are decoded straight into their final buffer, using
+    // the smallest index type that can address all the vertices:
+    VkIndexType            IndexType = VK_INDEX_TYPE_UINT32;
+    OpaqueBuffer           Indices;
     std::vector<glm::vec3> Positions;
     std::vector<glm::vec2> TexCoords;
     std::vector<glm::vec3> Normals;
@@ -25,6 +34,115 @@ struct PrimitiveData {
     std::vector<glm::vec4> Colors;
     AABB                   BBox;
     TextureBounds          TexBounds;
+    // Coarser levels, their indices follow the first IndexCount ones:
+    std::vector<GeometryLod> Lods;
+    // Clusters of the first IndexCount indices:
+    std::vector<Meshlet> Meshlets;
+
+    // Picks index type and allocates index buffer
+    // based on current vertex and index counts:
+    void AllocateIndices();
+
+    [[nodiscard]] uint32_t GetIndex(size_t idx) const;
+    void                   SetIndex(size_t idx, uint32_t value);
+};
+
+// Vertex cache statistics of an optimized primitive. Counts are kept,
+// so that they can be summed up over the whole model:
+struct OptimizationStats {
+    size_t Triangles         = 0;
+    size_t VerticesBefore    = 0;
+    size_t VerticesAfter     = 0;
+    size_t CacheMissesBefore = 0;
+    size_t CacheMissesAfter  = 0;
+
+    OptimizationStats &operator+=(const OptimizationStats &other);
+
+    // Average cache miss ratio (misses per triangle)
+    // and average transform to vertex ratio (misses per vertex):
+    [[nodiscard]] float AcmrBefore() const;
+    [[nodiscard]] float AcmrAfter() const;
+    [[nodiscard]] float AtvrBefore() const;
+    [[nodiscard]] float AtvrAfter() const;
+};
+
+// Comparison of the fast tangent generator with mikktspace:
+struct TangentBenchmark {
+    size_t Vertices    = 0;
+    float  FastSeconds = 0.0f;
+    float  MikkSeconds = 0.0f;
+    // Angles between tangents of the two generators, in degrees:
+    float  MaxAngle       = 0.0f;
+    double AngleSum       = 0.0;
+    size_t SignMismatches = 0;
+
+    TangentBenchmark &operator+=(const TangentBenchmark &other);
+
+    [[nodiscard]] float MeanAngle() const;
+};
+
+// Throughput of VertexPacking::Encode, summed over primitives:
+struct EncodeStats {
+    size_t Vertices = 0;
+    float  Seconds  = 0.0f;
+
+    EncodeStats &operator+=(const EncodeStats &other);
+
+    [[nodiscard]] float VerticesPerSecond() const;
+};
+
+// Problems with the source data found while importing a primitive.
+// None of them are fatal, affected data is replaced with defaults:
+enum class ImportIssue
+{
+    AttributeCountMismatch,
+    DegenerateTexCoords,
+    MissingTexCoords,
+    MissingNormals,
+    DegenerateNormal,
+    UnnormalizedNormal,
+    DegenerateTangent,
+    UnnormalizedTangent,
+};
+
+inline constexpr size_t ImportIssueCount = 8;
+
+const char *GetIssueName(ImportIssue issue);
+
+// Issues of a single primitive. Each one is counted, but only the first
+// few occurrences keep a description, so that broken files with millions
+// of bad vertices don't flood the log:
+struct PrimitiveDiagnostics {
+    static constexpr size_t MaxExamples = 4;
+
+    std::string Filename;
+    int64_t     GltfMesh = 0;
+    int64_t     GltfPrim = 0;
+
+    std::array<size_t, ImportIssueCount>                   Counts{};
+    std::array<std::vector<std::string>, ImportIssueCount> Examples{};
+
+    [[nodiscard]] bool   Empty() const;
+    [[nodiscard]] size_t Count(ImportIssue issue) const;
+
+    // Single line listing counts of all present issues:
+    [[nodiscard]] std::string Summary() const;
+};
+
+// Primitive imported straight into its final vertex layout,
+// texture bounds are needed to decode compressed texcoords:
+struct ImportedPrimitive {
+    GeometryData  Data;
+    TextureBounds TexBounds;
+    // Only present if mesh optimization was requested:
+    std::optional<OptimizationStats> Stats = std::nullopt;
+    // Only present if tangents were generated and benchmarked:
+    std::optional<TangentBenchmark> TangentBench = std::nullopt;
+    // Only present if vertices were encoded from a loaded primitive
+    // (streamed vertices are encoded while they are read):
+    std::optional<EncodeStats> Encoding = std::nullopt;
+    // Only present if the source data had any issues:
+    std::optional<PrimitiveDiagnostics> Diagnostics = std::nullopt;
 };
 
 struct ImageTaskData {
@@ -33,6 +151,16 @@ struct ImageTaskData {
     Pixel                                BaseColor;
     std::string                          Name;
     bool                                 Unorm;
+    TextureUsage                         Usage;
+    // Block-compressed at decode (never done for single pixels):
+    bool Compress = false;
+    // False if the image is shared with another model which decodes it:
+    bool NeedsDecode = true;
+    // Encoded image embedded in the gltf (glb chunk, buffer view or data uri)
+    // is decoded from memory instead, Path then only identifies it.
+    // Owner keeps the bytes alive until the decode is done:
+    std::span<const uint8_t>    Embedded;
+    std::shared_ptr<const void> EmbeddedOwner;
 };
 
 struct PrimitiveTaskData {
@@ -44,8 +172,9 @@ struct PrimitiveTaskData {
 
 class GltfAsset {
   public:
-    // Will load gltf buffers into memory:
-    GltfAsset(const std::filesystem::path &filepath);
+    // Will load gltf buffers into memory, compressed
+    // buffer views are decoded on the thread pool:
+    GltfAsset(const std::filesystem::path &filepath, ThreadPool &pool);
     ~GltfAsset();
 
     GltfAsset(const GltfAsset &)            = delete;
@@ -54,12 +183,17 @@ class GltfAsset {
     GltfAsset(GltfAsset &&) noexcept;
     GltfAsset &operator=(GltfAsset &&) noexcept;
 
+    // False if compressed buffer views are malformed or use unsupported
+    // modes, in which case nothing should be preprocessed:
+    [[nodiscard]] bool IsValid() const;
+
     // Retrieves all materials and creates corresponding objects in the scene
-    // Fills out a vector of async image-load tasks to be dispatched.
+    // Fills out a vector of async image-load tasks to be dispatched, images
+    // with the same source are shared through the registry.
     // Also fills out map (gltf id) -> (scene id) for materials.
     void PreprocessMaterials(Scene &scene, std::map<size_t, SceneKey> &matKeyMap,
                              std::vector<ImageTaskData> &tasks,
-                             const ModelConfig          &config);
+                             const ModelConfig &config, TextureRegistry &registry);
 
     // Consumes material table filled by PreprocessMaterials.
     // Retrieves all mesh primitives and creates corresponding objects in the scene
@@ -75,10 +209,25 @@ class GltfAsset {
     void PreprocessHierarchy(SceneGraphNode                   &root,
                              const std::map<size_t, SceneKey> &meshKeyMap);
 
-    // The gltf primitive should be move-returned:
-    PrimitiveData LoadPrimitive(PrimitiveTaskData data, const ModelConfig &config);
+    // The gltf primitive should be move-returned. Large primitives are
+    // decoded in parallel ranges on the pool. If tangents get generated
+    // with benchmarking enabled, the comparison is stored in tangentBench.
+    // Issues with the source data are summed up in a single log line
+    // and stored in diagnostics:
+    PrimitiveData LoadPrimitive(
+        PrimitiveTaskData data, const ModelConfig &config, ThreadPool &pool,
+        std::optional<TangentBenchmark>     *tangentBench = nullptr,
+        std::optional<PrimitiveDiagnostics> *diagnostics  = nullptr);
+
+    // Loads the primitive and encodes it in the configured vertex layout.
+    // For compressed layout vertices are streamed from the accessors
+    // without an intermediate float copy, whenever the file provides
+    // all of the needed attributes:
+    ImportedPrimitive LoadGeometry(PrimitiveTaskData data, const ModelConfig &config,
+                                   ThreadPool &pool);
 
   private:
     struct Impl;
-    std::unique_ptr<Impl> mPImpl;
+    // Shared with decode tasks of embedded images, which point into its buffers:
+    std::shared_ptr<Impl> mPImpl;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "ImageData.h"
 #include "Pch.h"
 
+#include "MipGenerator.h"
 #include "Vassert.h"
 
 #define KHRONOS_STATIC
@@ -13,6 +14,8 @@
 #define TINYEXR_IMPLEMENTATION
 #include "tinyexr.h"
 
+#include <algorithm>
+#include <array>
 #include <filesystem>
 #include <utility>
 
@@ -38,6 +41,47 @@ static VkDeviceSize BytesPerPixel(VkFormat format)
     std::unreachable();
 }
 
+// Parses ktx swizzle metadata, e.g. "rg01":
+static VkComponentMapping GetKtxSwizzle(ktxTexture *texture)
+{
+    unsigned int len   = 0;
+    void        *value = nullptr;
+
+    auto ret = ktxHashList_FindValue(&texture->kvDataHead, KTX_SWIZZLE_KEY, &len, &value);
+
+    if (ret != KTX_SUCCESS || len < 4)
+        return {};
+
+    auto Component = [](char c) {
+        switch (c)
+        {
+        case 'r':
+            return VK_COMPONENT_SWIZZLE_R;
+        case 'g':
+            return VK_COMPONENT_SWIZZLE_G;
+        case 'b':
+            return VK_COMPONENT_SWIZZLE_B;
+        case 'a':
+            return VK_COMPONENT_SWIZZLE_A;
+        case '0':
+            return VK_COMPONENT_SWIZZLE_ZERO;
+        case '1':
+            return VK_COMPONENT_SWIZZLE_ONE;
+        default:
+            return VK_COMPONENT_SWIZZLE_IDENTITY;
+        }
+    };
+
+    auto str = static_cast<const char *>(value);
+
+    return VkComponentMapping{
+        .r = Component(str[0]),
+        .g = Component(str[1]),
+        .b = Component(str[2]),
+        .a = Component(str[3]),
+    };
+}
+
 ImageData ImageData::SinglePixel(Pixel p, bool unorm)
 {
     auto data = new Pixel(p);
@@ -60,86 +104,151 @@ ImageData ImageData::ImportImage(const char *path, bool unorm)
 {
     std::filesystem::path pathObj(path);
 
-    auto res = ImageData();
-    res.Name = pathObj.stem().string();
+    ImageData res;
 
     if (pathObj.extension().string() == ".ktx" || pathObj.extension().string() == ".ktx2")
     {
-        ktxTexture *texture; // TODO: This needs to be stored as well
+        ktxTexture *texture;
 
         auto result = ktxTexture_CreateFromNamedFile(
             path, KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture);
         vassert(result == KTX_SUCCESS);
 
-        // Retrieve info about the texture:
-        ktx_uint32_t baseWidth  = texture->baseWidth;
-        ktx_uint32_t baseHeight = texture->baseHeight;
+        res = ImportKtx(texture, unorm);
+    }
+    else
+    {
+        int32_t width, height, channels;
 
-        ktx_size_t dataSize = ktxTexture_GetDataSize(texture);
+        //'STBI_rgb_alpha' forces 4 channels, even if source image has less:
+        stbi_uc *pixels = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
 
-        // TODO: Support more image types
-        // ktx_uint32_t baseDepth = texture->baseDepth;
-        // ktx_uint32_t numLevels = texture->numLevels;
-        // ktx_bool_t isArray = texture->isArray;
+        vassert(pixels != nullptr,
+                "Failed to load texture image. Filepath: " + std::string(path));
 
-        auto mips = texture->generateMipmaps ? MipStrategy::Generate : MipStrategy::Load;
+        res = ImportStb(pixels, width, height, unorm);
+    }
 
-        if (mips == MipStrategy::Load)
-        {
-            res.NumMips = texture->numLevels;
+    res.Name = pathObj.stem().string();
 
-            for (size_t lvl = 0; lvl < res.NumMips; lvl++)
-            {
-                ktx_size_t offset{0};
-                auto       ret = ktxTexture_GetImageOffset(texture, lvl, 0, 0, &offset);
+    return res;
+}
 
-                vassert(ret == KTX_SUCCESS);
+ImageData ImageData::ImportImage(std::span<const uint8_t> bytes, bool unorm)
+{
+    // Container is recognized by its signature, as mime types
+    // of embedded images are optional:
+    static constexpr std::array<uint8_t, 12> ktx1Id = {
+        0xAB, 'K', 'T', 'X', ' ', '1', '1', 0xBB, '\r', '\n', 0x1A, '\n'};
+    static constexpr std::array<uint8_t, 12> ktx2Id = {
+        0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+
+    auto IsKtx = [&](const auto &id) {
+        return bytes.size() >= id.size() &&
+               std::ranges::equal(bytes.first(id.size()), id);
+    };
 
-                res.MipOffsets.push_back(offset);
-            }
-        }
+    ImageData res;
 
-        ktx_uint8_t *image = ktxTexture_GetData(texture);
+    if (IsKtx(ktx1Id) || IsKtx(ktx2Id))
+    {
+        ktxTexture *texture;
 
-        VkFormat format = ktxTexture_GetVkFormat(texture);
+        auto result = ktxTexture_CreateFromMemory(
+            bytes.data(), bytes.size(), KTX_TEXTURE_CREATE_LOAD_IMAGE_DATA_BIT, &texture);
+        vassert(result == KTX_SUCCESS);
 
-        // TODO: this is a horrible hack:
-        if (unorm && (format == VK_FORMAT_BC7_SRGB_BLOCK))
-            format = VK_FORMAT_BC7_UNORM_BLOCK;
+        res = ImportKtx(texture, unorm);
+    }
+    else
+    {
+        int32_t width, height, channels;
 
-        if (!unorm && (format == VK_FORMAT_BC7_UNORM_BLOCK))
-            format = VK_FORMAT_BC7_SRGB_BLOCK;
+        stbi_uc *pixels =
+            stbi_load_from_memory(bytes.data(), static_cast<int>(bytes.size()), &width,
+                                  &height, &channels, STBI_rgb_alpha);
 
-        res.Width  = baseWidth;
-        res.Height = baseHeight;
-        res.Mips   = mips;
-        res.Format = format;
-        res.Data   = static_cast<void *>(image);
-        res.Size   = dataSize;
-        res.mType  = Type::Ktx;
+        vassert(pixels != nullptr, "Failed to load embedded texture image.");
 
-        // Store texture handle to use when freeing memory:
-        res.mExtra = static_cast<void *>(texture);
+        res = ImportStb(pixels, width, height, unorm);
     }
-    else
+
+    res.Name = "Embedded";
+
+    return res;
+}
+
+ImageData ImageData::ImportKtx(ktxTexture *texture, bool unorm)
+{
+    auto res = ImageData();
+
+    // Retrieve info about the texture:
+    ktx_uint32_t baseWidth  = texture->baseWidth;
+    ktx_uint32_t baseHeight = texture->baseHeight;
+
+    ktx_size_t dataSize = ktxTexture_GetDataSize(texture);
+
+    // TODO: Support more image types
+    // ktx_uint32_t baseDepth = texture->baseDepth;
+    // ktx_uint32_t numLevels = texture->numLevels;
+    // ktx_bool_t isArray = texture->isArray;
+
+    auto mips = texture->generateMipmaps ? MipStrategy::Generate : MipStrategy::Load;
+
+    if (mips == MipStrategy::Load)
     {
-        int32_t width, height, channels;
+        res.NumMips = texture->numLevels;
 
-        //'STBI_rgb_alpha' forces 4 channels, even if source image has less:
-        stbi_uc *pixels = stbi_load(path, &width, &height, &channels, STBI_rgb_alpha);
+        for (size_t lvl = 0; lvl < res.NumMips; lvl++)
+        {
+            ktx_size_t offset{0};
+            auto       ret = ktxTexture_GetImageOffset(texture, lvl, 0, 0, &offset);
 
-        vassert(pixels != nullptr,
-                "Failed to load texture image. Filepath: " + std::string(path));
+            vassert(ret == KTX_SUCCESS);
 
-        res.Width  = width;
-        res.Height = height;
-        res.Mips   = MipStrategy::Generate;
-        res.Format = unorm ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
-        res.Data   = static_cast<void *>(pixels);
-        res.Size   = width * height * BytesPerPixel(res.Format);
-        res.mType  = Type::Stb;
+            res.MipOffsets.push_back(offset);
+        }
     }
 
+    ktx_uint8_t *image = ktxTexture_GetData(texture);
+
+    VkFormat format = ktxTexture_GetVkFormat(texture);
+
+    // TODO: this is a horrible hack:
+    if (unorm && (format == VK_FORMAT_BC7_SRGB_BLOCK))
+        format = VK_FORMAT_BC7_UNORM_BLOCK;
+
+    if (!unorm && (format == VK_FORMAT_BC7_UNORM_BLOCK))
+        format = VK_FORMAT_BC7_SRGB_BLOCK;
+
+    res.Width   = baseWidth;
+    res.Height  = baseHeight;
+    res.Mips    = mips;
+    res.Format  = format;
+    res.Swizzle = GetKtxSwizzle(texture);
+    res.Data    = static_cast<void *>(image);
+    res.Size    = dataSize;
+    res.mType   = Type::Ktx;
+
+    // Store texture handle to use when freeing memory:
+    res.mExtra = static_cast<void *>(texture);
+
+    return res;
+}
+
+ImageData ImageData::ImportStb(uint8_t *pixels, int32_t width, int32_t height,
+                               bool unorm)
+{
+    auto res = ImageData();
+
+    res.Width  = width;
+    res.Height = height;
+    res.Mips   = MipStrategy::Generate;
+    res.Format = unorm ? VK_FORMAT_R8G8B8A8_UNORM : VK_FORMAT_R8G8B8A8_SRGB;
+    res.Data   = static_cast<void *>(pixels);
+    res.Size   = width * height * BytesPerPixel(res.Format);
+    res.mType  = Type::Stb;
+
     return res;
 }
 
@@ -170,7 +279,7 @@ ImageData ImageData::ImportHDRI(const char *path)
 ImageData::ImageData(ImageData &&other) noexcept
     : Name(std::move(other.Name)), Width(other.Width), Height(other.Height),
       Mips(other.Mips), NumMips(other.NumMips), MipOffsets(std::move(other.MipOffsets)),
-      Format(other.Format), Data(other.Data), Size(other.Size),
+      Format(other.Format), Swizzle(other.Swizzle), Data(other.Data), Size(other.Size),
       IsUpToDate(other.IsUpToDate), mType(other.mType), mExtra(other.mExtra)
 {
     other.Data   = nullptr;
@@ -187,6 +296,7 @@ ImageData &ImageData::operator=(ImageData &&other) noexcept
     NumMips    = other.NumMips;
     MipOffsets = std::move(other.MipOffsets);
     Format     = other.Format;
+    Swizzle    = other.Swizzle;
     Data       = other.Data;
     Size       = other.Size;
     mType      = other.mType;
@@ -232,6 +342,39 @@ bool ImageData::IsSinglePixel() const
     return mType == Type::Pixel;
 }
 
+void ImageData::GenerateMips(ThreadPool &pool)
+{
+    if (mType != Type::Stb || Mips != MipStrategy::Generate)
+        return;
+
+    const auto chain = MipGenerator::GetChain(Width, Height);
+
+    const auto  &last       = chain.back();
+    const size_t pixelCount = last.Offset + last.Width * last.Height;
+
+    // Levels are appended after the base one. The buffer still
+    // comes from stb's allocator, so it is freed the same way:
+    auto pixels = static_cast<Pixel *>(STBI_REALLOC(Data, pixelCount * sizeof(Pixel)));
+
+    vassert(pixels != nullptr, "Failed to allocate image mip levels!");
+
+    Data = static_cast<void *>(pixels);
+
+    const bool srgb = Format == VK_FORMAT_R8G8B8A8_SRGB;
+
+    MipGenerator::Generate(std::span(pixels, pixelCount), chain, srgb,
+                           MipGenerator::Filter::Kaiser, pool);
+
+    Mips    = MipStrategy::Load;
+    NumMips = chain.size();
+    Size    = pixelCount * sizeof(Pixel);
+
+    MipOffsets.clear();
+
+    for (const auto &level : chain)
+        MipOffsets.push_back(level.Offset * sizeof(Pixel));
+}
+
 glm::vec4 ImageData::GetPixelData() const
 {
     vassert(mType == Type::Pixel);
@@ -1,10 +1,14 @@
 #pragma once
 
 #include <cstdint>
+#include <span>
 #include <string>
 
 #include <glm/glm.hpp>
 
+struct ktxTexture;
+class ThreadPool;
+
 struct Pixel {
     uint8_t R;
     uint8_t G;
@@ -12,6 +16,14 @@ struct Pixel {
     uint8_t A;
 };
 
+// Role of an image in materials, decides how it may be block-compressed:
+enum class TextureUsage : uint8_t
+{
+    Color,
+    Normal,
+    RoughnessMetallic,
+};
+
 enum class MipStrategy
 {
     DoNothing,
@@ -26,6 +38,9 @@ class ImageData {
     // Uses c_str as that is what is passed to the underlying libraries anyway
     // and using filesystem::path measurably bloats the compile time.
     static ImageData ImportImage(const char *path, bool unorm);
+    // Decodes an encoded image (ktx or anything stb_image handles) which
+    // is already in memory, e.g. embedded in a glb. Bytes are not retained:
+    static ImageData ImportImage(std::span<const uint8_t> bytes, bool unorm);
     static ImageData ImportHDRI(const char *path);
 
     ImageData() = default;
@@ -39,6 +54,10 @@ class ImageData {
 
     [[nodiscard]] bool IsSinglePixel() const;
 
+    // Computes the mip chain on the cpu, so that all levels are uploaded
+    // at once. Only images decoded by stb are affected, others are left as is:
+    void GenerateMips(ThreadPool &pool);
+
     [[nodiscard]] glm::vec4 GetPixelData() const;
     void                    UpdatePixelData(glm::vec4 v);
 
@@ -53,11 +72,21 @@ class ImageData {
     std::vector<size_t> MipOffsets;
     VkFormat            Format;
 
+    // Applied by the image view, as compressed formats may pack
+    // channels differently than shaders expect them (read from ktx):
+    VkComponentMapping Swizzle = {};
+
     void        *Data = nullptr;
     VkDeviceSize Size = 0;
 
     mutable bool IsUpToDate = false;
 
+  private:
+    // Take ownership of the library-allocated data:
+    static ImageData ImportKtx(ktxTexture *texture, bool unorm);
+    static ImageData ImportStb(uint8_t *pixels, int32_t width, int32_t height,
+                               bool unorm);
+
   private:
     // Strategy of freeing memory depends on what library was used
     // to import the image, hence this enum.
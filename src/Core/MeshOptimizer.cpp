@@ -0,0 +1,484 @@
+#include "MeshOptimizer.h"
+#include "Pch.h"
+
+#include "Hash.h"
+#include "Vassert.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <unordered_map>
+
+// Size of the fifo cache used to measure the results:
+static constexpr size_t SimulatedCacheSize = 16;
+
+// Parameters of Forsyth's vertex scoring:
+static constexpr size_t ScoringCacheSize  = 32;
+static constexpr float  CacheDecayPower   = 1.5f;
+static constexpr float  LastTriangleScore = 0.75f;
+static constexpr float  ValenceBoostScale = 2.0f;
+static constexpr float  ValenceBoostPower = 0.5f;
+
+static constexpr uint32_t InvalidId = ~0u;
+
+static std::vector<uint32_t> ReadIndices(const PrimitiveData &prim)
+{
+    std::vector<uint32_t> indices(prim.IndexCount);
+
+    for (size_t i = 0; i < prim.IndexCount; i++)
+        indices[i] = prim.GetIndex(i);
+
+    return indices;
+}
+
+static void WriteIndices(PrimitiveData &prim, std::span<const uint32_t> indices)
+{
+    // Vertex count may have dropped enough to use a narrower index type:
+    prim.IndexCount = indices.size();
+    prim.AllocateIndices();
+
+    for (size_t i = 0; i < indices.size(); i++)
+        prim.SetIndex(i, indices[i]);
+}
+
+// Moves attributes to their new positions, newIds[old] == new:
+template <typename T>
+static void RemapAttribute(std::vector<T> &attr, std::span<const uint32_t> newIds,
+                           size_t newCount)
+{
+    if (attr.empty())
+        return;
+
+    std::vector<T> res(newCount);
+
+    for (size_t i = 0; i < newIds.size(); i++)
+    {
+        if (newIds[i] != InvalidId)
+            res[newIds[i]] = attr[i];
+    }
+
+    attr = std::move(res);
+}
+
+static void RemapVertices(PrimitiveData &prim, std::span<const uint32_t> newIds,
+                          size_t newCount)
+{
+    RemapAttribute(prim.Positions, newIds, newCount);
+    RemapAttribute(prim.TexCoords, newIds, newCount);
+    RemapAttribute(prim.Normals, newIds, newCount);
+    RemapAttribute(prim.Tangents, newIds, newCount);
+    RemapAttribute(prim.Colors, newIds, newCount);
+
+    prim.VertexCount = newCount;
+}
+
+template <typename T>
+static void HashAttribute(Hasher &hasher, const std::vector<T> &attr, size_t id)
+{
+    if (!attr.empty())
+        hasher.Value(attr[id]);
+}
+
+template <typename T>
+static bool AttributeEqual(const std::vector<T> &attr, size_t lhs, size_t rhs)
+{
+    return attr.empty() || std::memcmp(&attr[lhs], &attr[rhs], sizeof(T)) == 0;
+}
+
+static void WeldVertices(PrimitiveData &prim, std::vector<uint32_t> &indices)
+{
+    std::vector<uint32_t> newIds(prim.VertexCount);
+
+    std::unordered_map<uint64_t, uint32_t> unique;
+    unique.reserve(prim.VertexCount);
+
+    uint32_t newCount = 0;
+
+    for (size_t v = 0; v < prim.VertexCount; v++)
+    {
+        Hasher hasher;
+        HashAttribute(hasher, prim.Positions, v);
+        HashAttribute(hasher, prim.TexCoords, v);
+        HashAttribute(hasher, prim.Normals, v);
+        HashAttribute(hasher, prim.Tangents, v);
+        HashAttribute(hasher, prim.Colors, v);
+
+        auto [it, inserted] = unique.try_emplace(hasher.Get(), static_cast<uint32_t>(v));
+
+        const size_t other = it->second;
+
+        // Hash collisions between different vertices are so rare,
+        // that such vertices are simply left unwelded:
+        const bool equal = AttributeEqual(prim.Positions, v, other) &&
+                           AttributeEqual(prim.TexCoords, v, other) &&
+                           AttributeEqual(prim.Normals, v, other) &&
+                           AttributeEqual(prim.Tangents, v, other) &&
+                           AttributeEqual(prim.Colors, v, other);
+
+        if (!inserted && equal)
+            newIds[v] = newIds[other];
+        else
+            newIds[v] = newCount++;
+    }
+
+    if (newCount == prim.VertexCount)
+        return;
+
+    // Several old vertices map to the same new one, any of them will do:
+    RemapVertices(prim, newIds, newCount);
+
+    for (auto &idx : indices)
+        idx = newIds[idx];
+}
+
+static float VertexScore(int32_t cachePos, uint32_t remainingTriangles)
+{
+    // No triangles left to add, vertex is useless:
+    if (remainingTriangles == 0)
+        return -1.0f;
+
+    float score = 0.0f;
+
+    if (cachePos >= 0)
+    {
+        // Vertices of the last triangle are scored lower on purpose,
+        // so that strips don't go back and forth:
+        if (cachePos < 3)
+            score = LastTriangleScore;
+        else
+        {
+            const float scaler = 1.0f / static_cast<float>(ScoringCacheSize - 3);
+            const float pos    = static_cast<float>(cachePos - 3);
+
+            score = std::pow(1.0f - pos * scaler, CacheDecayPower);
+        }
+    }
+
+    // Favor vertices with few triangles left, so that they are finished
+    // and don't leave lone triangles to be picked up much later:
+    const float valence = static_cast<float>(remainingTriangles);
+    score += ValenceBoostScale * std::pow(valence, -ValenceBoostPower);
+
+    return score;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32_t> &indices,
+                                        size_t                 vertexCount)
+{
+    const size_t triCount = indices.size() / 3;
+
+    // Vertex -> triangle adjacency, stored as offsets into a single array:
+    std::vector<uint32_t> adjOffsets(vertexCount + 1, 0);
+    std::vector<uint32_t> remaining(vertexCount, 0);
+
+    for (auto idx : indices)
+        remaining[idx]++;
+
+    std::partial_sum(remaining.begin(), remaining.end(), adjOffsets.begin() + 1);
+
+    std::vector<uint32_t> adjacency(indices.size());
+
+    {
+        std::vector<uint32_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::vector<int32_t> cachePos(vertexCount, -1);
+    std::vector<float>   vertexScore(vertexCount);
+
+    for (size_t v = 0; v < vertexCount; v++)
+        vertexScore[v] = VertexScore(-1, remaining[v]);
+
+    std::vector<float> triScore(triCount);
+    std::vector<bool>  emitted(triCount, false);
+
+    uint32_t bestTri   = InvalidId;
+    float    bestScore = -1.0f;
+
+    for (size_t t = 0; t < triCount; t++)
+    {
+        triScore[t] = vertexScore[indices[3 * t + 0]] + vertexScore[indices[3 * t + 1]] +
+                      vertexScore[indices[3 * t + 2]];
+
+        if (triScore[t] > bestScore)
+        {
+            bestScore = triScore[t];
+            bestTri   = static_cast<uint32_t>(t);
+        }
+    }
+
+    std::vector<uint32_t> res;
+    res.reserve(indices.size());
+
+    // Cache is a few entries longer, to hold the vertices pushed out
+    // by the newest triangle until their scores are updated:
+    std::vector<uint32_t> cache, newCache;
+    cache.reserve(ScoringCacheSize + 3);
+    newCache.reserve(ScoringCacheSize + 3);
+
+    // Fallback when no cached vertex has triangles left:
+    size_t scanPos = 0;
+
+    while (res.size() < indices.size())
+    {
+        if (bestTri == InvalidId)
+        {
+            while (emitted[scanPos])
+                scanPos++;
+
+            bestTri = static_cast<uint32_t>(scanPos);
+        }
+
+        const std::array<uint32_t, 3> tri = {
+            indices[3 * bestTri + 0],
+            indices[3 * bestTri + 1],
+            indices[3 * bestTri + 2],
+        };
+
+        res.insert(res.end(), tri.begin(), tri.end());
+        emitted[bestTri] = true;
+
+        // Remove the triangle from adjacency of its vertices:
+        for (auto v : tri)
+        {
+            auto begin = adjacency.begin() + adjOffsets[v];
+            auto end   = begin + remaining[v];
+            auto it    = std::find(begin, end, bestTri);
+
+            if (it != end)
+            {
+                std::iter_swap(it, end - 1);
+                remaining[v]--;
+            }
+        }
+
+        // Triangle vertices go to the front of the cache:
+        newCache.assign(tri.begin(), tri.end());
+
+        for (auto v : cache)
+        {
+            if (v != tri[0] && v != tri[1] && v != tri[2])
+                newCache.push_back(v);
+        }
+
+        std::swap(cache, newCache);
+
+        // Update scores of all vertices whose position changed,
+        // including the ones that just fell out of the cache:
+        for (size_t i = 0; i < cache.size(); i++)
+        {
+            const auto v = cache[i];
+
+            cachePos[v]    = i < ScoringCacheSize ? static_cast<int32_t>(i) : -1;
+            vertexScore[v] = VertexScore(cachePos[v], remaining[v]);
+        }
+
+        if (cache.size() > ScoringCacheSize)
+            cache.resize(ScoringCacheSize);
+
+        // Next triangle is the best one touching the cache:
+        bestTri   = InvalidId;
+        bestScore = -1.0f;
+
+        for (auto v : cache)
+        {
+            for (uint32_t i = 0; i < remaining[v]; i++)
+            {
+                const auto t = adjacency[adjOffsets[v] + i];
+
+                triScore[t] = vertexScore[indices[3 * t + 0]] +
+                              vertexScore[indices[3 * t + 1]] +
+                              vertexScore[indices[3 * t + 2]];
+
+                if (triScore[t] > bestScore)
+                {
+                    bestScore = triScore[t];
+                    bestTri   = t;
+                }
+            }
+        }
+    }
+
+    indices = std::move(res);
+}
+
+// Splits cache-optimized triangles into clusters starting at cache restarts
+// (triangles with all vertices missed), so that reordering the clusters
+// doesn't hurt cache efficiency. Clusters facing away from the mesh center
+// are drawn first, as they are likely to occlude the inner ones:
+static void OptimizeOverdraw(std::vector<uint32_t>        &indices,
+                             const std::vector<glm::vec3> &positions)
+{
+    const size_t triCount = indices.size() / 3;
+
+    if (triCount == 0 || positions.empty())
+        return;
+
+    std::vector<size_t> clusterStarts;
+
+    {
+        std::vector<uint32_t> timestamps(positions.size(), 0);
+        uint32_t              time = SimulatedCacheSize + 1;
+
+        for (size_t t = 0; t < triCount; t++)
+        {
+            uint32_t misses = 0;
+
+            for (size_t c = 0; c < 3; c++)
+            {
+                const auto v = indices[3 * t + c];
+
+                if (time - timestamps[v] > SimulatedCacheSize)
+                {
+                    timestamps[v] = time++;
+                    misses++;
+                }
+            }
+
+            if (misses == 3 || t == 0)
+                clusterStarts.push_back(t);
+        }
+    }
+
+    clusterStarts.push_back(triCount);
+
+    const size_t clusterCount = clusterStarts.size() - 1;
+
+    if (clusterCount < 2)
+        return;
+
+    // Area-weighted centroid and normal of each cluster:
+    std::vector<glm::vec3> centroids(clusterCount, glm::vec3(0.0f));
+    std::vector<glm::vec3> normals(clusterCount, glm::vec3(0.0f));
+    std::vector<float>     areas(clusterCount, 0.0f);
+
+    glm::vec3 meshCentroid(0.0f);
+    float     meshArea = 0.0f;
+
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        for (size_t t = clusterStarts[c]; t < clusterStarts[c + 1]; t++)
+        {
+            auto p0 = positions[indices[3 * t + 0]];
+            auto p1 = positions[indices[3 * t + 1]];
+            auto p2 = positions[indices[3 * t + 2]];
+
+            auto  normal = glm::cross(p1 - p0, p2 - p0);
+            float area   = glm::length(normal);
+
+            centroids[c] += area * (p0 + p1 + p2) / 3.0f;
+            normals[c] += normal;
+            areas[c] += area;
+        }
+
+        meshCentroid += centroids[c];
+        meshArea += areas[c];
+
+        if (areas[c] > 0.0f)
+            centroids[c] /= areas[c];
+    }
+
+    if (meshArea > 0.0f)
+        meshCentroid /= meshArea;
+
+    std::vector<float> sortKeys(clusterCount);
+
+    for (size_t c = 0; c < clusterCount; c++)
+    {
+        auto normal = normals[c];
+        auto len    = glm::length(normal);
+
+        if (len > 0.0f)
+            normal /= len;
+
+        sortKeys[c] = glm::dot(centroids[c] - meshCentroid, normal);
+    }
+
+    std::vector<size_t> order(clusterCount);
+    std::iota(order.begin(), order.end(), 0);
+
+    std::ranges::stable_sort(order, std::ranges::greater{},
+                             [&](size_t c) { return sortKeys[c]; });
+
+    std::vector<uint32_t> res;
+    res.reserve(indices.size());
+
+    for (auto c : order)
+    {
+        auto begin = indices.begin() + 3 * clusterStarts[c];
+        auto end   = indices.begin() + 3 * clusterStarts[c + 1];
+
+        res.insert(res.end(), begin, end);
+    }
+
+    indices = std::move(res);
+}
+
+// Renumbers vertices in order of first reference:
+static void OptimizeVertexFetch(PrimitiveData &prim, std::vector<uint32_t> &indices)
+{
+    std::vector<uint32_t> newIds(prim.VertexCount, InvalidId);
+
+    uint32_t newCount = 0;
+
+    for (auto &idx : indices)
+    {
+        if (newIds[idx] == InvalidId)
+            newIds[idx] = newCount++;
+
+        idx = newIds[idx];
+    }
+
+    RemapVertices(prim, newIds, newCount);
+}
+
+size_t MeshOptimizer::CountCacheMisses(std::span<const uint32_t> indices,
+                                       size_t                    vertexCount)
+{
+    // Fifo cache - a vertex is in the cache if it was inserted
+    // less than cache size misses ago:
+    std::vector<size_t> timestamps(vertexCount, 0);
+    size_t              time = SimulatedCacheSize + 1;
+
+    size_t misses = 0;
+
+    for (auto v : indices)
+    {
+        if (time - timestamps[v] > SimulatedCacheSize)
+        {
+            timestamps[v] = time++;
+            misses++;
+        }
+    }
+
+    return misses;
+}
+
+OptimizationStats MeshOptimizer::Optimize(PrimitiveData &prim)
+{
+    vassert(prim.IndexCount % 3 == 0, "Only triangle lists can be optimized!");
+    vassert(prim.Positions.size() == prim.VertexCount, "Missing positions!");
+
+    auto indices = ReadIndices(prim);
+
+    OptimizationStats stats;
+    stats.Triangles         = prim.IndexCount / 3;
+    stats.VerticesBefore    = prim.VertexCount;
+    stats.CacheMissesBefore = CountCacheMisses(indices, prim.VertexCount);
+
+    WeldVertices(prim, indices);
+    OptimizeVertexCache(indices, prim.VertexCount);
+    OptimizeOverdraw(indices, prim.Positions);
+    OptimizeVertexFetch(prim, indices);
+
+    WriteIndices(prim, indices);
+
+    stats.VerticesAfter    = prim.VertexCount;
+    stats.CacheMissesAfter = CountCacheMisses(indices, prim.VertexCount);
+
+    return stats;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "GltfImporter.h"
+
+// Post-import optimization of primitive index and vertex order, for
+// the GPU post-transform cache, overdraw and vertex fetch locality
+namespace MeshOptimizer
+{
+// Runs the whole stage on an indexed triangle list:
+// 1. Welds vertices with bitwise identical attributes
+// 2. Reorders triangles for vertex cache locality (Forsyth)
+// 3. Reorders clusters of triangles between cache restarts, so that
+//    outward-facing ones come first and occlude the rest
+// 4. Renumbers vertices in order of first use, dropping unused ones
+// Returns vertex cache statistics from before and after:
+OptimizationStats Optimize(PrimitiveData &prim);
+
+// Reorders triangles for vertex cache locality only,
+// using Tom Forsyth's linear-speed algorithm:
+void OptimizeVertexCache(std::vector<uint32_t> &indices, size_t vertexCount);
+
+// Number of post-transform cache misses for given indices,
+// simulated with a fifo cache of typical hardware size:
+size_t CountCacheMisses(std::span<const uint32_t> indices, size_t vertexCount);
+} // namespace MeshOptimizer
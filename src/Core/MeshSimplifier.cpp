@@ -0,0 +1,449 @@
+#include "MeshSimplifier.h"
+#include "Pch.h"
+
+#include "Hash.h"
+#include "MeshOptimizer.h"
+#include "Vassert.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+
+// At most this many coarser levels are generated:
+static constexpr size_t MaxLodCount = 4;
+// Levels are not generated for primitives smaller than that:
+static constexpr size_t MinLodTriangles = 64;
+// Each level targets this fraction of triangles of the previous one:
+static constexpr float LodReduction = 0.5f;
+// Level is dropped if it doesn't get at least this much smaller:
+static constexpr float MinLodReduction = 0.8f;
+
+// Symmetric 4x4 matrix accumulating squared distances to triangle planes:
+struct Quadric {
+    std::array<double, 10> M{};
+
+    static Quadric FromPlane(glm::vec3 normal, float dist)
+    {
+        const double nx = normal.x, ny = normal.y, nz = normal.z, d = dist;
+
+        Quadric q;
+        q.M = {
+            nx * nx, nx * ny, nx * nz, nx * d, ny * ny,
+            ny * nz, ny * d,  nz * nz, nz * d, d * d,
+        };
+        return q;
+    }
+
+    Quadric &operator+=(const Quadric &other)
+    {
+        for (size_t i = 0; i < M.size(); i++)
+            M[i] += other.M[i];
+
+        return *this;
+    }
+
+    [[nodiscard]] double Eval(glm::vec3 p) const
+    {
+        const double x = p.x, y = p.y, z = p.z;
+
+        const double res = M[0] * x * x + 2.0 * M[1] * x * y + 2.0 * M[2] * x * z +
+                           2.0 * M[3] * x + M[4] * y * y + 2.0 * M[5] * y * z +
+                           2.0 * M[6] * y + M[7] * z * z + 2.0 * M[8] * z + M[9];
+
+        // Can go slightly negative due to rounding:
+        return std::max(res, 0.0);
+    }
+};
+
+struct Collapse {
+    double   Cost;
+    uint32_t From;
+    uint32_t To;
+};
+
+// Vertices which must not move - attribute seams (vertices sharing
+// position with other vertices) and borders of open surfaces:
+static std::vector<bool> FindLockedVertices(std::span<const uint32_t>  indices,
+                                            std::span<const glm::vec3> positions)
+{
+    std::vector<bool> locked(positions.size(), false);
+
+    {
+        std::unordered_map<uint64_t, uint32_t> firstWithPosition;
+        firstWithPosition.reserve(positions.size());
+
+        for (uint32_t v = 0; v < positions.size(); v++)
+        {
+            Hasher hasher;
+            hasher.Value(positions[v]);
+
+            auto [it, inserted] = firstWithPosition.try_emplace(hasher.Get(), v);
+
+            if (!inserted)
+            {
+                locked[v]          = true;
+                locked[it->second] = true;
+            }
+        }
+    }
+
+    // Edges used by a single triangle are on the border:
+    std::vector<uint64_t> edges;
+    edges.reserve(indices.size());
+
+    for (size_t t = 0; t < indices.size(); t += 3)
+    {
+        for (size_t c = 0; c < 3; c++)
+        {
+            uint64_t a = indices[t + c];
+            uint64_t b = indices[t + (c + 1) % 3];
+
+            edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+        }
+    }
+
+    std::ranges::sort(edges);
+
+    for (size_t i = 0; i < edges.size();)
+    {
+        size_t j = i;
+
+        while (j < edges.size() && edges[j] == edges[i])
+            j++;
+
+        if (j - i == 1)
+        {
+            locked[edges[i] >> 32]         = true;
+            locked[edges[i] & 0xFFFFFFFFu] = true;
+        }
+
+        i = j;
+    }
+
+    return locked;
+}
+
+static glm::vec3 TriangleNormal(glm::vec3 p0, glm::vec3 p1, glm::vec3 p2)
+{
+    return glm::cross(p1 - p0, p2 - p0);
+}
+
+class Simplifier {
+  public:
+    Simplifier(std::span<const uint32_t> indices, std::span<const glm::vec3> positions)
+        : mPositions(positions), mIndices(indices.begin(), indices.end()),
+          mLocked(FindLockedVertices(indices, positions)), mQuadrics(positions.size())
+    {
+        for (size_t t = 0; t < mIndices.size(); t += 3)
+        {
+            auto p0 = positions[mIndices[t + 0]];
+            auto p1 = positions[mIndices[t + 1]];
+            auto p2 = positions[mIndices[t + 2]];
+
+            auto  normal = TriangleNormal(p0, p1, p2);
+            float len    = glm::length(normal);
+
+            if (len == 0.0f)
+                continue;
+
+            normal /= len;
+
+            auto q = Quadric::FromPlane(normal, -glm::dot(normal, p0));
+
+            for (size_t c = 0; c < 3; c++)
+                mQuadrics[mIndices[t + c]] += q;
+        }
+    }
+
+    // Collapses edges until index count drops to the target, or
+    // nothing can be collapsed anymore. Returns false in the latter case:
+    bool Simplify(size_t targetIndexCount)
+    {
+        while (mIndices.size() > targetIndexCount)
+        {
+            if (!CollapsePass(targetIndexCount))
+                return false;
+        }
+
+        return true;
+    }
+
+    [[nodiscard]] const std::vector<uint32_t> &Indices() const
+    {
+        return mIndices;
+    }
+
+    // Square root of the largest quadric error accepted so far:
+    [[nodiscard]] float Error() const
+    {
+        return static_cast<float>(std::sqrt(mMaxCost));
+    }
+
+  private:
+    void BuildAdjacency()
+    {
+        const size_t vertexCount = mPositions.size();
+
+        mAdjOffsets.assign(vertexCount + 1, 0);
+
+        for (auto idx : mIndices)
+            mAdjOffsets[idx + 1]++;
+
+        std::partial_sum(mAdjOffsets.begin(), mAdjOffsets.end(), mAdjOffsets.begin());
+
+        mAdjacency.resize(mIndices.size());
+
+        std::vector<uint32_t> fill(mAdjOffsets.begin(), mAdjOffsets.end() - 1);
+
+        for (size_t i = 0; i < mIndices.size(); i++)
+            mAdjacency[fill[mIndices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    std::span<const uint32_t> AdjacentTriangles(uint32_t v) const
+    {
+        return std::span(mAdjacency).subspan(mAdjOffsets[v],
+                                             mAdjOffsets[v + 1] - mAdjOffsets[v]);
+    }
+
+    // Moving the vertex must not turn any of its triangles over:
+    bool FlipsTriangles(uint32_t from, uint32_t to) const
+    {
+        for (auto t : AdjacentTriangles(from))
+        {
+            std::array<uint32_t, 3> tri = {
+                mIndices[3 * t + 0],
+                mIndices[3 * t + 1],
+                mIndices[3 * t + 2],
+            };
+
+            // Triangles containing the edge disappear:
+            if (std::ranges::find(tri, to) != tri.end())
+                continue;
+
+            auto before = TriangleNormal(mPositions[tri[0]], mPositions[tri[1]],
+                                         mPositions[tri[2]]);
+
+            std::ranges::replace(tri, from, to);
+
+            auto after = TriangleNormal(mPositions[tri[0]], mPositions[tri[1]],
+                                        mPositions[tri[2]]);
+
+            if (glm::dot(before, after) <= 0.0f)
+                return true;
+        }
+
+        return false;
+    }
+
+    bool CollapsePass(size_t targetIndexCount)
+    {
+        BuildAdjacency();
+
+        // Gather unique edges with their cheapest collapse direction:
+        std::vector<uint64_t> edges;
+        edges.reserve(mIndices.size());
+
+        for (size_t t = 0; t < mIndices.size(); t += 3)
+        {
+            for (size_t c = 0; c < 3; c++)
+            {
+                uint64_t a = mIndices[t + c];
+                uint64_t b = mIndices[t + (c + 1) % 3];
+
+                edges.push_back(std::min(a, b) << 32 | std::max(a, b));
+            }
+        }
+
+        std::ranges::sort(edges);
+        auto [first, last] = std::ranges::unique(edges);
+        edges.erase(first, last);
+
+        std::vector<Collapse> collapses;
+        collapses.reserve(edges.size());
+
+        for (auto edge : edges)
+        {
+            const auto a = static_cast<uint32_t>(edge >> 32);
+            const auto b = static_cast<uint32_t>(edge & 0xFFFFFFFFu);
+
+            auto q = mQuadrics[a];
+            q += mQuadrics[b];
+
+            std::optional<Collapse> best;
+
+            if (!mLocked[a])
+                best = Collapse{q.Eval(mPositions[b]), a, b};
+
+            if (!mLocked[b])
+            {
+                const double cost = q.Eval(mPositions[a]);
+
+                if (!best || cost < best->Cost)
+                    best = Collapse{cost, b, a};
+            }
+
+            if (best)
+                collapses.push_back(*best);
+        }
+
+        std::ranges::sort(collapses, {}, &Collapse::Cost);
+
+        // Collapses within a pass must not touch the same triangles,
+        // otherwise flip checks would use stale positions:
+        std::vector<bool>     touched(mPositions.size(), false);
+        std::vector<uint32_t> remap(mPositions.size());
+        std::iota(remap.begin(), remap.end(), 0);
+
+        const size_t trianglesToRemove = (mIndices.size() - targetIndexCount) / 3;
+
+        size_t removed   = 0;
+        size_t collapsed = 0;
+
+        for (const auto &collapse : collapses)
+        {
+            if (removed >= trianglesToRemove)
+                break;
+
+            if (touched[collapse.From] || touched[collapse.To])
+                continue;
+
+            if (FlipsTriangles(collapse.From, collapse.To))
+                continue;
+
+            remap[collapse.From] = collapse.To;
+            mQuadrics[collapse.To] += mQuadrics[collapse.From];
+            mMaxCost = std::max(mMaxCost, collapse.Cost);
+
+            for (auto t : AdjacentTriangles(collapse.From))
+            {
+                bool hasEdge = false;
+
+                for (size_t c = 0; c < 3; c++)
+                {
+                    touched[mIndices[3 * t + c]] = true;
+                    hasEdge |= mIndices[3 * t + c] == collapse.To;
+                }
+
+                removed += hasEdge;
+            }
+
+            collapsed++;
+        }
+
+        if (collapsed == 0)
+            return false;
+
+        // Apply the collapses and drop triangles that became degenerate:
+        size_t write = 0;
+
+        for (size_t t = 0; t < mIndices.size(); t += 3)
+        {
+            const auto a = remap[mIndices[t + 0]];
+            const auto b = remap[mIndices[t + 1]];
+            const auto c = remap[mIndices[t + 2]];
+
+            if (a == b || b == c || c == a)
+                continue;
+
+            mIndices[write++] = a;
+            mIndices[write++] = b;
+            mIndices[write++] = c;
+        }
+
+        mIndices.resize(write);
+
+        return true;
+    }
+
+  private:
+    std::span<const glm::vec3> mPositions;
+    std::vector<uint32_t>      mIndices;
+    std::vector<bool>          mLocked;
+    std::vector<Quadric>       mQuadrics;
+    double                     mMaxCost = 0.0;
+
+    // Vertex -> triangle adjacency, rebuilt every pass:
+    std::vector<uint32_t> mAdjOffsets;
+    std::vector<uint32_t> mAdjacency;
+};
+
+void MeshSimplifier::GenerateLods(PrimitiveData &prim, bool optimizeCache)
+{
+    vassert(prim.IndexCount % 3 == 0, "Only triangle lists can be simplified!");
+    vassert(prim.Positions.size() == prim.VertexCount, "Missing positions!");
+
+    if (prim.IndexCount / 3 < MinLodTriangles)
+        return;
+
+    std::vector<uint32_t> indices(prim.IndexCount);
+
+    for (size_t i = 0; i < prim.IndexCount; i++)
+        indices[i] = prim.GetIndex(i);
+
+    // Errors are relative to the size of the primitive:
+    const float diagonal = 2.0f * glm::length(prim.BBox.Extent);
+
+    Simplifier simplifier(indices, prim.Positions);
+
+    std::vector<std::vector<uint32_t>> levels;
+    std::vector<float>                 errors;
+
+    size_t lastCount = prim.IndexCount;
+
+    while (levels.size() < MaxLodCount && lastCount / 3 >= MinLodTriangles)
+    {
+        const auto target = static_cast<size_t>(LodReduction * lastCount) / 3 * 3;
+
+        simplifier.Simplify(target);
+
+        const auto &res = simplifier.Indices();
+
+        if (res.empty() || res.size() > MinLodReduction * lastCount)
+            break;
+
+        levels.push_back(res);
+        errors.push_back(diagonal > 0.0f ? simplifier.Error() / diagonal : 0.0f);
+
+        lastCount = res.size();
+    }
+
+    if (levels.empty())
+        return;
+
+    // Append all levels after the full resolution indices:
+    size_t totalCount = prim.IndexCount;
+
+    for (const auto &level : levels)
+        totalCount += level.size();
+
+    const auto idxSize = GetIndexSize(prim.IndexType);
+    auto       lodIndices = OpaqueBuffer(totalCount * idxSize, idxSize);
+
+    std::memcpy(lodIndices.Data, prim.Indices.Data, prim.IndexCount * idxSize);
+    prim.Indices = std::move(lodIndices);
+
+    size_t offset = prim.IndexCount;
+
+    for (size_t lvl = 0; lvl < levels.size(); lvl++)
+    {
+        auto &level = levels[lvl];
+
+        if (optimizeCache)
+            MeshOptimizer::OptimizeVertexCache(level, prim.VertexCount);
+
+        for (size_t i = 0; i < level.size(); i++)
+            prim.SetIndex(offset + i, level[i]);
+
+        prim.Lods.push_back(GeometryLod{
+            .FirstIndex = static_cast<uint32_t>(offset),
+            .IndexCount = static_cast<uint32_t>(level.size()),
+            .Error      = errors[lvl],
+        });
+
+        offset += level.size();
+    }
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "GltfImporter.h"
+
+// Import-time simplification of primitives into levels of detail
+namespace MeshSimplifier
+{
+// Repeatedly halves the triangle count with quadric error edge collapses
+// and stores the results as coarser levels of the primitive. Collapses
+// only move vertices onto their neighbours, so all levels reference
+// the original vertex buffer. Attribute seams and open borders are kept
+// in place. If optimizeCache is set, indices of each level are reordered
+// for the vertex cache:
+void GenerateLods(PrimitiveData &prim, bool optimizeCache);
+} // namespace MeshSimplifier
@@ -0,0 +1,261 @@
+#include "MeshletBuilder.h"
+#include "Pch.h"
+
+#include "Vassert.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+static constexpr uint32_t InvalidId = ~0u;
+
+// Cones spreading (almost) over a half space can't be culled from anywhere:
+static constexpr float MinConeDot = 0.1f;
+
+// Bounding sphere and normal cone of a finished meshlet:
+static Meshlet ComputeBounds(std::span<const uint32_t>  indices,
+                             std::span<const glm::vec3> positions)
+{
+    auto vmin = glm::vec3(std::numeric_limits<float>::max());
+    auto vmax = glm::vec3(std::numeric_limits<float>::lowest());
+
+    for (auto idx : indices)
+    {
+        vmin = glm::min(vmin, positions[idx]);
+        vmax = glm::max(vmax, positions[idx]);
+    }
+
+    const auto center = 0.5f * (vmin + vmax);
+    float      radius = 0.0f;
+
+    for (auto idx : indices)
+        radius = std::max(radius, glm::length(positions[idx] - center));
+
+    // Cone axis is the average of triangle normals, degenerate ones are skipped:
+    std::vector<glm::vec3> normals;
+    normals.reserve(indices.size() / 3);
+
+    auto axis = glm::vec3(0.0f);
+
+    for (size_t i = 0; i < indices.size(); i += 3)
+    {
+        const auto p0 = positions[indices[i + 0]];
+        const auto p1 = positions[indices[i + 1]];
+        const auto p2 = positions[indices[i + 2]];
+
+        auto       normal = glm::cross(p1 - p0, p2 - p0);
+        const auto len    = glm::length(normal);
+
+        if (len <= 0.0f)
+            continue;
+
+        normals.push_back(normal / len);
+        axis += normals.back();
+    }
+
+    float cutoff = 1.0f;
+
+    if (const auto axisLen = glm::length(axis); axisLen > 0.0f)
+    {
+        axis /= axisLen;
+
+        float minDot = 1.0f;
+
+        for (auto normal : normals)
+            minDot = std::min(minDot, glm::dot(normal, axis));
+
+        if (minDot > MinConeDot)
+            cutoff = std::sqrt(1.0f - minDot * minDot);
+    }
+    else
+    {
+        axis = glm::vec3(0.0f, 0.0f, 1.0f);
+    }
+
+    return Meshlet{
+        .Center     = center,
+        .Radius     = radius,
+        .ConeAxis   = axis,
+        .ConeCutoff = cutoff,
+        .FirstIndex = 0,
+        .IndexCount = static_cast<uint32_t>(indices.size()),
+    };
+}
+
+void MeshletBuilder::Build(PrimitiveData &prim)
+{
+    vassert(prim.IndexCount % 3 == 0, "Only triangle lists can be split into meshlets!");
+    vassert(prim.Positions.size() == prim.VertexCount, "Missing positions!");
+
+    const size_t triCount = prim.IndexCount / 3;
+
+    // A single meshlet would only duplicate the primitive bounds:
+    if (triCount <= MaxTriangles)
+        return;
+
+    std::vector<uint32_t> indices(prim.IndexCount);
+
+    for (size_t i = 0; i < prim.IndexCount; i++)
+        indices[i] = prim.GetIndex(i);
+
+    // Vertex -> triangle adjacency, stored as offsets into a single array:
+    std::vector<uint32_t> adjOffsets(prim.VertexCount + 1, 0);
+
+    for (auto idx : indices)
+        adjOffsets[idx + 1]++;
+
+    std::partial_sum(adjOffsets.begin(), adjOffsets.end(), adjOffsets.begin());
+
+    std::vector<uint32_t> adjacency(indices.size());
+
+    {
+        std::vector<uint32_t> fill(adjOffsets.begin(), adjOffsets.end() - 1);
+
+        for (size_t i = 0; i < indices.size(); i++)
+            adjacency[fill[indices[i]]++] = static_cast<uint32_t>(i / 3);
+    }
+
+    auto Centroid = [&](uint32_t tri) {
+        const auto &pos = prim.Positions;
+
+        return (pos[indices[3 * tri + 0]] + pos[indices[3 * tri + 1]] +
+                pos[indices[3 * tri + 2]]) /
+               3.0f;
+    };
+
+    std::vector<bool>     emitted(triCount, false);
+    std::vector<uint32_t> reordered;
+    std::vector<Meshlet>  meshlets;
+
+    reordered.reserve(indices.size());
+
+    // Id of the last meshlet using each vertex:
+    std::vector<uint32_t> vertMeshlet(prim.VertexCount, InvalidId);
+
+    // State of the meshlet being built:
+    size_t    meshletStart = 0;
+    size_t    vertCount    = 0;
+    glm::vec3 centroidSum  = glm::vec3(0.0f);
+
+    auto MeshletId = [&]() { return static_cast<uint32_t>(meshlets.size()); };
+
+    auto NewVertices = [&](uint32_t tri) {
+        size_t res = 0;
+
+        for (size_t k = 0; k < 3; k++)
+            res += vertMeshlet[indices[3 * tri + k]] != MeshletId();
+
+        return res;
+    };
+
+    // Unused triangle adjacent to given vertices, adding the least vertices
+    // to the meshlet, with ties broken by distance to the meshlet centre:
+    auto FindCandidate = [&](std::span<const uint32_t> verts) {
+        const auto tris   = std::max<size_t>((reordered.size() - meshletStart) / 3, 1);
+        const auto center = centroidSum / static_cast<float>(tris);
+
+        uint32_t best     = InvalidId;
+        size_t   bestNew  = 4;
+        float    bestDist = std::numeric_limits<float>::max();
+
+        for (auto v : verts)
+        {
+            for (auto a = adjOffsets[v]; a < adjOffsets[v + 1]; a++)
+            {
+                const auto tri = adjacency[a];
+
+                if (emitted[tri])
+                    continue;
+
+                const auto newVerts = NewVertices(tri);
+                const auto offset   = Centroid(tri) - center;
+                const auto dist     = glm::dot(offset, offset);
+
+                if (newVerts < bestNew || (newVerts == bestNew && dist < bestDist))
+                {
+                    best     = tri;
+                    bestNew  = newVerts;
+                    bestDist = dist;
+                }
+            }
+        }
+
+        return best;
+    };
+
+    auto FinishMeshlet = [&]() {
+        auto meshletIndices = std::span(reordered).subspan(meshletStart);
+
+        auto meshlet       = ComputeBounds(meshletIndices, prim.Positions);
+        meshlet.FirstIndex = static_cast<uint32_t>(meshletStart);
+        meshlets.push_back(meshlet);
+
+        meshletStart = reordered.size();
+        vertCount    = 0;
+        centroidSum  = glm::vec3(0.0f);
+    };
+
+    auto Emit = [&](uint32_t tri) {
+        for (size_t k = 0; k < 3; k++)
+        {
+            const auto v = indices[3 * tri + k];
+
+            if (vertMeshlet[v] != MeshletId())
+            {
+                vertMeshlet[v] = MeshletId();
+                vertCount++;
+            }
+
+            reordered.push_back(v);
+        }
+
+        emitted[tri] = true;
+        centroidSum += Centroid(tri);
+    };
+
+    // First triangle that may still be unused:
+    size_t seed = 0;
+
+    for (size_t emittedCount = 0; emittedCount < triCount; emittedCount++)
+    {
+        const size_t tris = (reordered.size() - meshletStart) / 3;
+
+        uint32_t next = InvalidId;
+
+        // Grow through neighbours of the last triangle, then of the whole meshlet:
+        if (tris > 0)
+        {
+            auto current = std::span(reordered).subspan(meshletStart);
+
+            next = FindCandidate(current.last(3));
+
+            if (next == InvalidId)
+                next = FindCandidate(current);
+        }
+
+        // Continue with the next unused triangle in the original order, which
+        // is usually close by if the primitive was optimized for the cache:
+        if (next == InvalidId)
+        {
+            while (emitted[seed])
+                seed++;
+
+            next = static_cast<uint32_t>(seed);
+        }
+
+        const bool fits = tris < MaxTriangles && vertCount + NewVertices(next) <= MaxVertices;
+
+        if (tris > 0 && !fits)
+            FinishMeshlet();
+
+        Emit(next);
+    }
+
+    FinishMeshlet();
+
+    for (size_t i = 0; i < reordered.size(); i++)
+        prim.SetIndex(i, reordered[i]);
+
+    prim.Meshlets = std::move(meshlets);
+}
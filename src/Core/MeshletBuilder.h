@@ -0,0 +1,19 @@
+#pragma once
+
+#include "GltfImporter.h"
+
+// Import-time clustering of primitives into meshlets,
+// small enough to be culled individually by the renderer
+namespace MeshletBuilder
+{
+// Limits of a single meshlet, matching common mesh shader limits:
+inline constexpr size_t MaxVertices  = 64;
+inline constexpr size_t MaxTriangles = 124;
+
+// Groups triangles of the full resolution geometry into meshlets,
+// growing each one through adjacent triangles. The indices are reordered
+// so that every meshlet is a contiguous range, coarser levels of detail
+// are left as they are. Each meshlet gets a bounding sphere and a normal
+// cone for backface culling:
+void Build(PrimitiveData &prim);
+} // namespace MeshletBuilder
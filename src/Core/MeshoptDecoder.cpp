@@ -0,0 +1,543 @@
+#include "MeshoptDecoder.h"
+#include "Pch.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+// Vertex attribute codec:
+static constexpr uint8_t VertexHeader       = 0xa0;
+static constexpr size_t  VertexBlockBytes   = 8192;
+static constexpr size_t  VertexBlockMaxSize = 256;
+static constexpr size_t  VertexTailMinSize  = 32;
+static constexpr size_t  VertexMaxStride    = 256;
+static constexpr size_t  ByteGroupSize      = 16;
+
+// Index codecs:
+static constexpr uint8_t TriangleHeader    = 0xe0;
+static constexpr uint8_t SequenceHeader    = 0xd0;
+static constexpr size_t  TriangleTableSize = 16;
+static constexpr size_t  SequenceTailSize  = 4;
+static constexpr size_t  FifoSize          = 16;
+
+static uint8_t Unzigzag8(uint8_t v)
+{
+    return static_cast<uint8_t>(-(v & 1) ^ (v >> 1));
+}
+
+static uint32_t Unzigzag32(uint32_t v)
+{
+    return (0u - (v & 1)) ^ (v >> 1);
+}
+
+// Group of 16 bytes packed with 0, 2, 4 or 8 bits each. Packed values equal
+// to the maximum are sentinels, their bytes follow the packed ones:
+static const uint8_t *DecodeBytesGroup(const uint8_t *data, const uint8_t *end,
+                                       uint8_t *dst, int bitsLog2)
+{
+    if (bitsLog2 == 0)
+    {
+        std::memset(dst, 0, ByteGroupSize);
+        return data;
+    }
+
+    if (bitsLog2 == 3)
+    {
+        if (static_cast<size_t>(end - data) < ByteGroupSize)
+            return nullptr;
+
+        std::memcpy(dst, data, ByteGroupSize);
+        return data + ByteGroupSize;
+    }
+
+    const size_t  bits     = size_t(1) << bitsLog2;
+    const uint8_t sentinel = static_cast<uint8_t>((1u << bits) - 1);
+
+    if (static_cast<size_t>(end - data) < ByteGroupSize * bits / 8)
+        return nullptr;
+
+    const uint8_t *literals = data + ByteGroupSize * bits / 8;
+
+    for (size_t i = 0; i < ByteGroupSize; i++)
+    {
+        // Values are packed starting from the high bits:
+        const size_t bitOffset = i * bits;
+        const auto   shift     = 8 - bits - bitOffset % 8;
+        const auto   value     = (data[bitOffset / 8] >> shift) & sentinel;
+
+        if (value != sentinel)
+        {
+            dst[i] = static_cast<uint8_t>(value);
+            continue;
+        }
+
+        if (literals == end)
+            return nullptr;
+
+        dst[i] = *literals++;
+    }
+
+    return literals;
+}
+
+static const uint8_t *DecodeBytes(const uint8_t *data, const uint8_t *end, uint8_t *dst,
+                                  size_t size)
+{
+    // Two header bits per group:
+    const size_t groupCount = size / ByteGroupSize;
+    const size_t headerSize = (groupCount + 3) / 4;
+
+    if (static_cast<size_t>(end - data) < headerSize)
+        return nullptr;
+
+    const uint8_t *header = data;
+    data += headerSize;
+
+    for (size_t group = 0; group < groupCount && data; group++)
+    {
+        const int bitsLog2 = (header[group / 4] >> ((group % 4) * 2)) & 3;
+        data = DecodeBytesGroup(data, end, dst + group * ByteGroupSize, bitsLog2);
+    }
+
+    return data;
+}
+
+// Each byte of the vertex is stored separately for the whole block,
+// as deltas from the same byte of the previous vertex:
+static const uint8_t *DecodeVertexBlock(const uint8_t *data, const uint8_t *end,
+                                        uint8_t *dst, size_t count, size_t stride,
+                                        std::span<uint8_t> last)
+{
+    std::array<uint8_t, VertexBlockMaxSize> deltas;
+
+    const size_t alignedCount = (count + ByteGroupSize - 1) & ~(ByteGroupSize - 1);
+
+    for (size_t k = 0; k < stride; k++)
+    {
+        data = DecodeBytes(data, end, deltas.data(), alignedCount);
+
+        if (data == nullptr)
+            return nullptr;
+
+        uint8_t value = last[k];
+
+        for (size_t i = 0; i < count; i++)
+        {
+            value += Unzigzag8(deltas[i]);
+            dst[i * stride + k] = value;
+        }
+
+        last[k] = value;
+    }
+
+    return data;
+}
+
+static bool DecodeVertexBuffer(std::span<uint8_t> dst, size_t count, size_t stride,
+                               std::span<const uint8_t> src)
+{
+    if (stride == 0 || stride > VertexMaxStride || stride % 4 != 0)
+        return false;
+
+    // The first vertex is stored in a tail, which also pads the stream:
+    const size_t tailSize = std::max(stride, VertexTailMinSize);
+
+    if (src.size() < 1 + tailSize || src[0] != VertexHeader)
+        return false;
+
+    std::array<uint8_t, VertexMaxStride> last;
+    std::memcpy(last.data(), src.data() + src.size() - stride, stride);
+
+    const uint8_t *data = src.data() + 1;
+    const uint8_t *end  = src.data() + src.size() - tailSize;
+
+    const size_t blockSize =
+        std::min((VertexBlockBytes / stride) & ~(ByteGroupSize - 1), VertexBlockMaxSize);
+
+    for (size_t first = 0; first < count; first += blockSize)
+    {
+        const size_t blockCount = std::min(blockSize, count - first);
+
+        data = DecodeVertexBlock(data, end, dst.data() + first * stride, blockCount,
+                                 stride, last);
+
+        if (data == nullptr)
+            return false;
+    }
+
+    return data == end;
+}
+
+// Variable length integer, 7 bits per byte:
+static uint32_t DecodeVByte(const uint8_t *&data)
+{
+    const uint8_t lead = *data++;
+
+    if (lead < 128)
+        return lead;
+
+    uint32_t res   = lead & 127;
+    uint32_t shift = 7;
+
+    for (size_t i = 0; i < 4; i++)
+    {
+        const uint8_t group = *data++;
+        res |= static_cast<uint32_t>(group & 127) << shift;
+        shift += 7;
+
+        if (group < 128)
+            break;
+    }
+
+    return res;
+}
+
+static void WriteIndex(std::span<uint8_t> dst, size_t stride, size_t idx, uint32_t value)
+{
+    if (stride == 2)
+    {
+        const auto narrow = static_cast<uint16_t>(value);
+        std::memcpy(dst.data() + idx * 2, &narrow, 2);
+    }
+    else
+    {
+        std::memcpy(dst.data() + idx * 4, &value, 4);
+    }
+}
+
+// Triangles are coded relative to fifos of recently seen edges and vertices,
+// new vertices are expected to come in order of first use:
+static bool DecodeTriangles(std::span<uint8_t> dst, size_t count, size_t stride,
+                            std::span<const uint8_t> src)
+{
+    if (count % 3 != 0 || (stride != 2 && stride != 4))
+        return false;
+
+    if (src.size() < 1 + count / 3 + TriangleTableSize)
+        return false;
+
+    if ((src[0] & 0xf0) != TriangleHeader)
+        return false;
+
+    const int version = src[0] & 0x0f;
+
+    if (version > 1)
+        return false;
+
+    std::array<std::array<uint32_t, 2>, FifoSize> edgeFifo;
+    std::array<uint32_t, FifoSize>                vertexFifo;
+
+    std::ranges::fill(edgeFifo, std::array<uint32_t, 2>{~0u, ~0u});
+    std::ranges::fill(vertexFifo, ~0u);
+
+    size_t edgeOffset   = 0;
+    size_t vertexOffset = 0;
+
+    auto PushEdge = [&](uint32_t a, uint32_t b) {
+        edgeFifo[edgeOffset] = {a, b};
+        edgeOffset           = (edgeOffset + 1) % FifoSize;
+    };
+
+    auto PushVertex = [&](uint32_t v, bool cond = true) {
+        vertexFifo[vertexOffset] = v;
+        vertexOffset             = (vertexOffset + cond) % FifoSize;
+    };
+
+    // Fifo reads wrap around, going back from the last pushed entry:
+    auto Edge = [&](size_t back) {
+        return edgeFifo[(edgeOffset - 1 - back) % FifoSize];
+    };
+
+    auto Vertex = [&](size_t back) {
+        return vertexFifo[(vertexOffset - back) % FifoSize];
+    };
+
+    uint32_t next = 0;
+    uint32_t last = 0;
+
+    // Version 1 codes +-1 deltas of free indices in the fifo range:
+    const uint32_t fecMax = version >= 1 ? 13 : 15;
+
+    const uint8_t *code     = src.data() + 1;
+    const uint8_t *data     = code + count / 3;
+    const uint8_t *safeEnd  = src.data() + src.size() - TriangleTableSize;
+    const uint8_t *auxTable = safeEnd;
+
+    for (size_t i = 0; i < count; i += 3)
+    {
+        // A triangle reads at most 16 bytes, the table pads the stream:
+        if (data > safeEnd)
+            return false;
+
+        const uint8_t codeTri = *code++;
+        uint32_t      a, b, c;
+
+        if (codeTri < 0xf0)
+        {
+            // Edge from the fifo, third vertex is new, in the fifo or free:
+            const auto edge = Edge(codeTri >> 4);
+            a               = edge[0];
+            b               = edge[1];
+
+            const uint32_t fec = codeTri & 15;
+
+            if (fec < fecMax)
+            {
+                c = (fec == 0) ? next : Vertex(fec + 1);
+                next += (fec == 0);
+
+                PushVertex(c, fec == 0);
+            }
+            else
+            {
+                // Free index, stored as a delta from the last one:
+                if (fec != 15)
+                    c = last + (fec == 13 ? ~0u : 1u);
+                else
+                    c = last + Unzigzag32(DecodeVByte(data));
+
+                last = c;
+                PushVertex(c);
+            }
+
+            PushEdge(c, b);
+            PushEdge(a, c);
+        }
+        else if (codeTri < 0xfe)
+        {
+            // New vertex followed by two vertices coded in the table:
+            const uint8_t  codeAux = auxTable[codeTri & 15];
+            const uint32_t feb     = codeAux >> 4;
+            const uint32_t fec     = codeAux & 15;
+
+            a = next++;
+            b = (feb == 0) ? next : Vertex(feb);
+            next += (feb == 0);
+            c = (fec == 0) ? next : Vertex(fec);
+            next += (fec == 0);
+
+            PushVertex(a);
+            PushVertex(b, feb == 0);
+            PushVertex(c, fec == 0);
+
+            PushEdge(b, a);
+            PushEdge(c, b);
+            PushEdge(a, c);
+        }
+        else
+        {
+            // All three vertices coded explicitly:
+            const uint8_t  codeAux = *data++;
+            const uint32_t fea     = codeTri == 0xfe ? 0 : 15;
+            const uint32_t feb     = codeAux >> 4;
+            const uint32_t fec     = codeAux & 15;
+
+            if (codeAux == 0)
+                next = 0;
+
+            a = (fea == 0) ? next++ : 0;
+            b = (feb == 0) ? next++ : Vertex(feb);
+            c = (fec == 0) ? next++ : Vertex(fec);
+
+            if (fea == 15)
+                last = a = last + Unzigzag32(DecodeVByte(data));
+
+            if (feb == 15)
+                last = b = last + Unzigzag32(DecodeVByte(data));
+
+            if (fec == 15)
+                last = c = last + Unzigzag32(DecodeVByte(data));
+
+            PushVertex(a);
+            PushVertex(b, feb == 0 || feb == 15);
+            PushVertex(c, fec == 0 || fec == 15);
+
+            PushEdge(b, a);
+            PushEdge(c, b);
+            PushEdge(a, c);
+        }
+
+        WriteIndex(dst, stride, i + 0, a);
+        WriteIndex(dst, stride, i + 1, b);
+        WriteIndex(dst, stride, i + 2, c);
+    }
+
+    return data == safeEnd;
+}
+
+// Plain index sequence, delta coded against one of two baselines:
+static bool DecodeSequence(std::span<uint8_t> dst, size_t count, size_t stride,
+                           std::span<const uint8_t> src)
+{
+    if (stride != 2 && stride != 4)
+        return false;
+
+    if (src.size() < 1 + count + SequenceTailSize)
+        return false;
+
+    if ((src[0] & 0xf0) != SequenceHeader || (src[0] & 0x0f) > 1)
+        return false;
+
+    std::array<uint32_t, 2> last{0, 0};
+
+    const uint8_t *data    = src.data() + 1;
+    const uint8_t *safeEnd = src.data() + src.size() - SequenceTailSize;
+
+    for (size_t i = 0; i < count; i++)
+    {
+        // Index reads at most 5 bytes, the tail pads the stream:
+        if (data >= safeEnd)
+            return false;
+
+        const uint32_t v        = DecodeVByte(data);
+        const uint32_t baseline = v & 1;
+
+        last[baseline] += Unzigzag32(v >> 1);
+        WriteIndex(dst, stride, i, last[baseline]);
+    }
+
+    return data == safeEnd;
+}
+
+template <typename T>
+static T RoundToInt(float v)
+{
+    return static_cast<T>(static_cast<int>(v + (v >= 0.0f ? 0.5f : -0.5f)));
+}
+
+// Octahedral unit vectors with the third component holding the scale:
+template <typename T>
+static void FilterOctahedral(std::span<uint8_t> bytes, size_t count)
+{
+    const float maxValue = static_cast<float>((1 << (sizeof(T) * 8 - 1)) - 1);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        std::array<T, 4> v;
+        std::memcpy(v.data(), bytes.data() + i * sizeof(v), sizeof(v));
+
+        float x = v[0];
+        float y = v[1];
+        float z = static_cast<float>(v[2]) - std::abs(x) - std::abs(y);
+
+        // Unfold the lower hemisphere:
+        const float t = std::min(z, 0.0f);
+        x += (x >= 0.0f) ? t : -t;
+        y += (y >= 0.0f) ? t : -t;
+
+        const float scale = maxValue / std::sqrt(x * x + y * y + z * z);
+
+        v[0] = RoundToInt<T>(x * scale);
+        v[1] = RoundToInt<T>(y * scale);
+        v[2] = RoundToInt<T>(z * scale);
+
+        std::memcpy(bytes.data() + i * sizeof(v), v.data(), sizeof(v));
+    }
+}
+
+// Quaternions with the largest component dropped, its index
+// and the scale of the others are stored in the fourth one:
+static void FilterQuaternion(std::span<uint8_t> bytes, size_t count)
+{
+    const float invSqrt2 = 1.0f / std::sqrt(2.0f);
+
+    for (size_t i = 0; i < count; i++)
+    {
+        std::array<int16_t, 4> v;
+        std::memcpy(v.data(), bytes.data() + i * sizeof(v), sizeof(v));
+
+        const float scale = invSqrt2 / static_cast<float>(v[3] | 3);
+
+        const float x = v[0] * scale;
+        const float y = v[1] * scale;
+        const float z = v[2] * scale;
+        const float w = std::sqrt(std::max(1.0f - x * x - y * y - z * z, 0.0f));
+
+        const size_t maxIdx = v[3] & 3;
+
+        std::array<int16_t, 4> res;
+        res[(maxIdx + 1) % 4] = RoundToInt<int16_t>(x * 32767.0f);
+        res[(maxIdx + 2) % 4] = RoundToInt<int16_t>(y * 32767.0f);
+        res[(maxIdx + 3) % 4] = RoundToInt<int16_t>(z * 32767.0f);
+        res[(maxIdx + 0) % 4] = RoundToInt<int16_t>(w * 32767.0f);
+
+        std::memcpy(bytes.data() + i * sizeof(res), res.data(), sizeof(res));
+    }
+}
+
+// Floats stored as a 24 bit mantissa with a shared 8 bit exponent:
+static void FilterExponential(std::span<uint8_t> bytes, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        int32_t v;
+        std::memcpy(&v, bytes.data() + i * sizeof(v), sizeof(v));
+
+        const int32_t mantissa = static_cast<int32_t>(static_cast<uint32_t>(v) << 8) >> 8;
+        const int32_t exponent = v >> 24;
+
+        const float res = std::ldexp(static_cast<float>(mantissa), exponent);
+        std::memcpy(bytes.data() + i * sizeof(res), &res, sizeof(res));
+    }
+}
+
+static bool ApplyFilter(std::span<uint8_t> dst, size_t count, size_t stride,
+                        MeshoptDecoder::Filter filter)
+{
+    using enum MeshoptDecoder::Filter;
+
+    switch (filter)
+    {
+    case None:
+        return true;
+
+    case Octahedral:
+        if (stride == 4)
+            FilterOctahedral<int8_t>(dst, count);
+        else if (stride == 8)
+            FilterOctahedral<int16_t>(dst, count);
+        else
+            return false;
+
+        return true;
+
+    case Quaternion:
+        if (stride != 8)
+            return false;
+
+        FilterQuaternion(dst, count);
+        return true;
+
+    case Exponential:
+        if (stride % 4 != 0)
+            return false;
+
+        FilterExponential(dst, count * stride / 4);
+        return true;
+    }
+
+    return false;
+}
+
+bool MeshoptDecoder::Decode(std::span<uint8_t> dst, size_t count, size_t stride,
+                            std::span<const uint8_t> src, Mode mode, Filter filter)
+{
+    if (dst.size() != count * stride)
+        return false;
+
+    switch (mode)
+    {
+    case Mode::Attributes:
+        return DecodeVertexBuffer(dst, count, stride, src) &&
+               ApplyFilter(dst, count, stride, filter);
+
+    case Mode::Triangles:
+        return DecodeTriangles(dst, count, stride, src);
+
+    case Mode::Indices:
+        return DecodeSequence(dst, count, stride, src);
+    }
+
+    return false;
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Decoders of the bitstreams defined by EXT_meshopt_compression
+namespace MeshoptDecoder
+{
+enum class Mode
+{
+    Attributes,
+    Triangles,
+    Indices,
+};
+
+enum class Filter
+{
+    None,
+    Octahedral,
+    Quaternion,
+    Exponential,
+};
+
+// Decodes count elements of given stride from src into dst, which must hold
+// exactly count * stride bytes. Filters only apply to attributes.
+// Returns false if the data is malformed:
+bool Decode(std::span<uint8_t> dst, size_t count, size_t stride,
+            std::span<const uint8_t> src, Mode mode, Filter filter);
+} // namespace MeshoptDecoder
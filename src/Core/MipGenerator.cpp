@@ -0,0 +1,281 @@
+#include "MipGenerator.h"
+#include "Pch.h"
+
+#include "ThreadPool.h"
+#include "Vassert.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <numbers>
+
+// Support of the filters, in destination pixels:
+static constexpr float BoxRadius    = 0.5f;
+static constexpr float KaiserRadius = 1.5f;
+static constexpr float KaiserAlpha  = 4.0f;
+
+// Resolution of the table converting linear values back to srgb:
+static constexpr size_t SrgbTableSize = 4096;
+
+static float SrgbToLinear(float x)
+{
+    if (x <= 0.04045f)
+        return x / 12.92f;
+
+    return std::pow((x + 0.055f) / 1.055f, 2.4f);
+}
+
+static float LinearToSrgb(float x)
+{
+    if (x <= 0.0031308f)
+        return x * 12.92f;
+
+    return 1.055f * std::pow(x, 1.0f / 2.4f) - 0.055f;
+}
+
+// Zeroth order modified Bessel function of the first kind:
+static float BesselI0(float x)
+{
+    float sum  = 1.0f;
+    float term = 1.0f;
+
+    for (int32_t k = 1; k < 32 && term > 1e-7f * sum; k++)
+    {
+        const float factor = x / (2.0f * static_cast<float>(k));
+
+        term *= factor * factor;
+        sum += term;
+    }
+
+    return sum;
+}
+
+static float FilterWeight(MipGenerator::Filter filter, float x)
+{
+    const float ax = std::abs(x);
+
+    if (filter == MipGenerator::Filter::Box)
+    {
+        if (ax < BoxRadius)
+            return 1.0f;
+
+        return ax == BoxRadius ? 0.5f : 0.0f;
+    }
+
+    if (ax >= KaiserRadius)
+        return 0.0f;
+
+    const float px   = std::numbers::pi_v<float> * x;
+    const float sinc = (x == 0.0f) ? 1.0f : std::sin(px) / px;
+
+    const float t      = x / KaiserRadius;
+    const float window = BesselI0(KaiserAlpha * std::sqrt(1.0f - t * t));
+
+    return sinc * window / BesselI0(KaiserAlpha);
+}
+
+// Source pixels contributing to a single destination pixel, along one axis.
+// Taps may fall outside of the image, sampling is clamped to the edge:
+struct Taps {
+    int32_t            First;
+    std::vector<float> Weights;
+};
+
+static std::vector<Taps> ComputeTaps(uint32_t srcSize, uint32_t dstSize,
+                                     MipGenerator::Filter filter)
+{
+    const float scale  = static_cast<float>(srcSize) / static_cast<float>(dstSize);
+    const float radius = scale * (filter == MipGenerator::Filter::Box ? BoxRadius
+                                                                      : KaiserRadius);
+
+    std::vector<Taps> res(dstSize);
+
+    for (uint32_t i = 0; i < dstSize; i++)
+    {
+        const float center = (static_cast<float>(i) + 0.5f) * scale - 0.5f;
+
+        const auto first = static_cast<int32_t>(std::ceil(center - radius));
+        const auto last  = static_cast<int32_t>(std::floor(center + radius));
+
+        auto &taps = res[i];
+        taps.First = first;
+
+        float sum = 0.0f;
+
+        for (int32_t s = first; s <= last; s++)
+        {
+            const float w = FilterWeight(filter, (static_cast<float>(s) - center) / scale);
+
+            taps.Weights.push_back(w);
+            sum += w;
+        }
+
+        for (auto &w : taps.Weights)
+            w /= sum;
+    }
+
+    return res;
+}
+
+std::vector<MipGenerator::Level> MipGenerator::GetChain(uint32_t width, uint32_t height)
+{
+    std::vector<Level> res;
+
+    size_t offset = 0;
+
+    while (true)
+    {
+        res.push_back(Level{.Width = width, .Height = height, .Offset = offset});
+
+        if (width == 1 && height == 1)
+            break;
+
+        offset += static_cast<size_t>(width) * height;
+
+        width  = std::max(width / 2, 1u);
+        height = std::max(height / 2, 1u);
+    }
+
+    return res;
+}
+
+void MipGenerator::Generate(std::span<Pixel> pixels, std::span<const Level> chain,
+                            bool srgb, Filter filter, ThreadPool &pool)
+{
+    vassert(!chain.empty(), "Mip chain needs at least one level!");
+
+    const auto &lastLevel = chain.back();
+
+    vassert(lastLevel.Offset + lastLevel.Width * lastLevel.Height <= pixels.size(),
+            "Mip chain doesn't fit in the pixel data!");
+
+    // Color channels are converted to linear space on load and back on store:
+    std::array<float, 256> toLinear;
+
+    for (size_t i = 0; i < toLinear.size(); i++)
+    {
+        const float x = static_cast<float>(i) / 255.0f;
+        toLinear[i]   = srgb ? SrgbToLinear(x) : x;
+    }
+
+    std::vector<uint8_t> fromLinear(SrgbTableSize + 1);
+
+    for (size_t i = 0; i <= SrgbTableSize; i++)
+    {
+        float x = static_cast<float>(i) / static_cast<float>(SrgbTableSize);
+        x       = srgb ? LinearToSrgb(x) : x;
+
+        fromLinear[i] = static_cast<uint8_t>(255.0f * x + 0.5f);
+    }
+
+    auto StoreColor = [&](float x) {
+        const float t = std::clamp(x, 0.0f, 1.0f) * static_cast<float>(SrgbTableSize);
+        return fromLinear[static_cast<size_t>(t + 0.5f)];
+    };
+
+    auto StoreAlpha = [](float x) {
+        return static_cast<uint8_t>(255.0f * std::clamp(x, 0.0f, 1.0f) + 0.5f);
+    };
+
+    for (size_t lvl = 1; lvl < chain.size(); lvl++)
+    {
+        const auto &src = chain[lvl - 1];
+        const auto &dst = chain[lvl];
+
+        auto srcPixels = pixels.subspan(src.Offset, src.Width * src.Height);
+        auto dstPixels = pixels.subspan(dst.Offset, dst.Width * dst.Height);
+
+        const auto hTaps = ComputeTaps(src.Width, dst.Width, filter);
+        const auto vTaps = ComputeTaps(src.Height, dst.Height, filter);
+
+        size_t maxVTaps = 0;
+
+        for (const auto &taps : vTaps)
+            maxVTaps = std::max(maxVTaps, taps.Weights.size());
+
+        const size_t grainSize = std::max<size_t>(1, 16384 / dst.Width);
+
+        pool.ParallelFor(dst.Height, grainSize, [&](size_t first, size_t last) {
+            // Horizontally filtered source rows (rgba floats), kept for
+            // the following destination rows, which share most of them:
+            const size_t rowFloats = 4 * dst.Width;
+
+            std::vector<float>   rows(maxVTaps * rowFloats);
+            std::vector<int64_t> rowIds(maxVTaps, -1);
+
+            std::vector<float> linear(4 * src.Width);
+            std::vector<float> acc(rowFloats);
+
+            auto FilteredRow = [&](uint32_t y) {
+                const size_t slot = y % maxVTaps;
+                float       *row  = rows.data() + slot * rowFloats;
+
+                if (rowIds[slot] == y)
+                    return row;
+
+                rowIds[slot] = y;
+
+                const auto srcRow = srcPixels.subspan(y * src.Width, src.Width);
+
+                for (size_t x = 0; x < src.Width; x++)
+                {
+                    linear[4 * x + 0] = toLinear[srcRow[x].R];
+                    linear[4 * x + 1] = toLinear[srcRow[x].G];
+                    linear[4 * x + 2] = toLinear[srcRow[x].B];
+                    linear[4 * x + 3] = static_cast<float>(srcRow[x].A) / 255.0f;
+                }
+
+                for (size_t x = 0; x < dst.Width; x++)
+                {
+                    const auto &taps = hTaps[x];
+
+                    std::array<float, 4> sum{};
+
+                    for (size_t k = 0; k < taps.Weights.size(); k++)
+                    {
+                        const auto sx = std::clamp<int32_t>(
+                            taps.First + static_cast<int32_t>(k), 0, src.Width - 1);
+
+                        for (size_t c = 0; c < 4; c++)
+                            sum[c] += taps.Weights[k] * linear[4 * sx + c];
+                    }
+
+                    std::ranges::copy(sum, row + 4 * x);
+                }
+
+                return row;
+            };
+
+            for (size_t y = first; y < last; y++)
+            {
+                const auto &taps = vTaps[y];
+
+                std::ranges::fill(acc, 0.0f);
+
+                for (size_t k = 0; k < taps.Weights.size(); k++)
+                {
+                    const auto sy = std::clamp<int32_t>(
+                        taps.First + static_cast<int32_t>(k), 0, src.Height - 1);
+
+                    const float  w   = taps.Weights[k];
+                    const float *row = FilteredRow(sy);
+
+                    for (size_t i = 0; i < rowFloats; i++)
+                        acc[i] += w * row[i];
+                }
+
+                auto dstRow = dstPixels.subspan(y * dst.Width, dst.Width);
+
+                for (size_t x = 0; x < dst.Width; x++)
+                {
+                    dstRow[x] = Pixel{
+                        .R = StoreColor(acc[4 * x + 0]),
+                        .G = StoreColor(acc[4 * x + 1]),
+                        .B = StoreColor(acc[4 * x + 2]),
+                        .A = StoreAlpha(acc[4 * x + 3]),
+                    };
+                }
+            }
+        });
+    }
+}
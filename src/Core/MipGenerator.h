@@ -0,0 +1,39 @@
+#pragma once
+
+#include "ImageData.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+class ThreadPool;
+
+// Cpu generation of mip chains for 8-bit rgba images, so that textures
+// can be uploaded with all their levels at once
+namespace MipGenerator
+{
+enum class Filter
+{
+    Box,
+    // Kaiser-windowed sinc, keeps the mips sharper:
+    Kaiser,
+};
+
+struct Level {
+    uint32_t Width;
+    uint32_t Height;
+    // In pixels from the start of the chain:
+    size_t Offset;
+};
+
+// Layout of a full chain of tightly packed levels, down to 1x1.
+// Sizes are halved and rounded down, matching Vulkan mip sizes:
+std::vector<Level> GetChain(uint32_t width, uint32_t height);
+
+// Fills all levels after the first one, each computed from the previous one.
+// Color channels of srgb images are filtered in linear space. Rows of each
+// level are split across the thread pool:
+void Generate(std::span<Pixel> pixels, std::span<const Level> chain, bool srgb,
+              Filter filter, ThreadPool &pool);
+} // namespace MipGenerator
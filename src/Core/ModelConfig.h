@@ -4,13 +4,50 @@
 
 #include <filesystem>
 
+enum class TangentMethod
+{
+    // Batched and threaded, close to mikktspace (see TangentsGenerator.h):
+    Fast,
+    MikkTSpace,
+};
+
 struct ModelConfig {
     std::filesystem::path Filepath;
 
     // Vertex loading:
     Vertex::Layout VertexLayout = Vertex::PullLayout::Compressed;
 
+    // Generator of tangents for primitives that don't provide them:
+    TangentMethod Tangents = TangentMethod::MikkTSpace;
+
+    // Run both tangent generators and report how they compare
+    // (only when importing, cooked models skip the generation):
+    bool BenchmarkTangents = false;
+
     // Material loading:
     bool FetchRoughness = true;
     bool FetchNormal    = true;
+
+    // Block-compress textures (BC7/BC5/BC4) with full mip chains,
+    // results are cached on disk:
+    bool CompressTextures = false;
+
+    // Weld vertices and reorder primitives for vertex cache,
+    // overdraw and vertex fetch efficiency:
+    bool OptimizeMeshes = false;
+
+    // Simplify primitives into a chain of coarser levels of detail,
+    // which renderers pick from based on the projected size:
+    bool GenerateLods = false;
+
+    // Split primitives into meshlets with their own bounds,
+    // so that renderers can cull parts of large primitives:
+    bool BuildMeshlets = false;
+
+    // Reuse/produce cooked file with already imported data:
+    bool UseCache = true;
+
+    // Make the model usable right after parsing, committing
+    // primitives and textures to the scene as they are loaded:
+    bool Progressive = false;
 };
\ No newline at end of file
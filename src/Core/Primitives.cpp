@@ -55,7 +55,7 @@ GeometryData primitive::TexturedCubeWithTangent()
         {-1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}
     };
 
-    primData.Indices = {
+    const std::array<uint32_t, idxCount> indices{
         0,1,2, 2,3,0, 
         4,6,5, 6,4,7,
         8,10,9, 10,8,11,
@@ -66,6 +66,11 @@ GeometryData primitive::TexturedCubeWithTangent()
 
     // clang-format on
 
+    primData.AllocateIndices();
+
+    for (size_t i = 0; i < indices.size(); i++)
+        primData.SetIndex(i, indices[i]);
+
     tangen::GenerateTangents(primData);
 
     // Vertex::Layout layout = Vertex::PullLayout::Naive;
@@ -156,16 +161,16 @@ GeometryData primitive::TexturedSphereWithTangent(float radius, uint32_t subdivi
     }
 
     // Generate index data:
-    primData.Indices.resize(numIndices);
+    primData.AllocateIndices();
 
     size_t indexIdx = 0;
 
     // North pole cap:
     for (uint32_t i = 0; i < numLongitudeLines; i++)
     {
-        primData.Indices[indexIdx++] = 0;
-        primData.Indices[indexIdx++] = i + 2;
-        primData.Indices[indexIdx++] = i + 1;
+        primData.SetIndex(indexIdx++, 0);
+        primData.SetIndex(indexIdx++, i + 2);
+        primData.SetIndex(indexIdx++, i + 1);
     }
 
     // Middle:
@@ -183,14 +188,14 @@ GeometryData primitive::TexturedSphereWithTangent(float radius, uint32_t subdivi
             uint32_t firstCorner = rowStart + longitude;
 
             // First triangle of quad: Top-Left, Bottom-Left, Bottom-Right
-            primData.Indices[indexIdx++] = firstCorner;
-            primData.Indices[indexIdx++] = firstCorner + rowLength + 1;
-            primData.Indices[indexIdx++] = firstCorner + rowLength;
+            primData.SetIndex(indexIdx++, firstCorner);
+            primData.SetIndex(indexIdx++, firstCorner + rowLength + 1);
+            primData.SetIndex(indexIdx++, firstCorner + rowLength);
 
             // Second triangle of quad: Top-Left, Bottom-Right, Top-Right
-            primData.Indices[indexIdx++] = firstCorner;
-            primData.Indices[indexIdx++] = firstCorner + 1;
-            primData.Indices[indexIdx++] = firstCorner + rowLength + 1;
+            primData.SetIndex(indexIdx++, firstCorner);
+            primData.SetIndex(indexIdx++, firstCorner + 1);
+            primData.SetIndex(indexIdx++, firstCorner + rowLength + 1);
         }
     }
 
@@ -200,9 +205,9 @@ GeometryData primitive::TexturedSphereWithTangent(float radius, uint32_t subdivi
 
     for (uint32_t i = 0; i < numLongitudeLines; i++)
     {
-        primData.Indices[indexIdx++] = pole;
-        primData.Indices[indexIdx++] = bottomRow + i;
-        primData.Indices[indexIdx++] = bottomRow + i + 1;
+        primData.SetIndex(indexIdx++, pole);
+        primData.SetIndex(indexIdx++, bottomRow + i);
+        primData.SetIndex(indexIdx++, bottomRow + i + 1);
     }
 
     // Generate tangent vectors:
@@ -312,7 +312,14 @@ void RenderContext::ResizeSwapchain()
 
 void RenderContext::LoadScene(Scene &scene)
 {
-    vkDeviceWaitIdle(mCtx.Device);
+    // Object changes alone only patch host side instance data,
+    // which is read when recording the next frame:
+    if (scene.UpdateRequested())
+        vkDeviceWaitIdle(mCtx.Device);
+
+    // Asset workers keep emplacing meshes, materials and images
+    // while loading, so the scene can't change during the upload:
+    auto lock = scene.Lock();
 
     mRenderer->LoadScene(scene);
     scene.ClearUpdateFlags();
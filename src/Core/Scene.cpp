@@ -2,96 +2,181 @@
 #include "Pch.h"
 
 #include "GeometryData.h"
-#include "Vassert.h"
 
-void Scene::RecalculateAABB()
+const DynamicBvh &Scene::GetObjectTree() const
 {
-    bool firstIteration = true;
-    AABB bbox{};
+    return mObjectTree;
+}
+
+std::optional<AABB> Scene::ComputeObjectBounds(const SceneObject &obj) const
+{
+    if (!obj.Mesh.has_value())
+        return std::nullopt;
+
+    const auto *mesh = Meshes.Find(*obj.Mesh);
+
+    if (mesh == nullptr)
+        return std::nullopt;
 
-    for (auto &[_, obj] : Objects)
+    std::optional<AABB> res;
+
+    for (auto &prim : mesh->Primitives)
     {
-        if (!obj.Mesh.has_value())
+        // Still being loaded:
+        if (prim.Data.VertexCount == 0)
             continue;
 
-        auto &mesh      = Meshes[*obj.Mesh];
-        auto &transform = obj.Transform;
-
-        for (auto &prim : mesh.Primitives)
-        {
-            auto srcBBox         = prim.Data.BBox;
-            auto transformedBBox = srcBBox.GetConservativeTransformedAABB(transform);
-
-            if (firstIteration)
-            {
-                bbox           = transformedBBox;
-                firstIteration = false;
-            }
-
-            else
-            {
-                bbox = bbox.MaxWith(transformedBBox);
-            }
-        }
+        auto bbox = prim.Data.BBox.GetConservativeTransformedAABB(obj.Transform);
+
+        res = res.has_value() ? res->MaxWith(bbox) : bbox;
     }
 
-    TotalAABB = bbox;
+    return res;
 }
 
-std::pair<SceneKey, SceneMesh &> Scene::EmplaceMesh()
+void Scene::UpdateObjectBounds(SceneKey key)
 {
-    std::unique_lock lock(mMutex);
+    const uint32_t slot   = SlotKeys::Index(key);
+    const auto     bounds = ComputeObjectBounds(Objects[key]);
 
-    auto key = mMeshKeyGenerator.Get();
-    vassert(Meshes.count(key) == 0);
+    if (bounds)
+        mObjectBounds.Set(slot, *bounds);
+    else
+        mObjectBounds.Reset(slot);
 
-    Meshes[key] = SceneMesh{};
+    UpdateObjectLeaf(key, bounds);
 
-    return {key, Meshes[key]};
+    TotalAABB = mObjectBounds.GetTotal().value_or(AABB{});
 }
 
-std::pair<SceneKey, ImageData &> Scene::EmplaceImage()
+void Scene::UpdateObjectLeaf(SceneKey key, const std::optional<AABB> &bounds)
 {
-    std::unique_lock lock(mMutex);
+    auto *leaf = mObjectLeaves.Find(key);
 
-    auto key = mImageKeyGenerator.Get();
-    vassert(Images.count(key) == 0);
+    if (leaf == nullptr)
+    {
+        if (bounds)
+            mObjectLeaves.Emplace(key, mObjectTree.Insert(*bounds, key));
+
+        return;
+    }
+
+    if (bounds)
+        mObjectTree.Update(*leaf, *bounds);
+    else
+    {
+        mObjectTree.Remove(*leaf);
+        mObjectLeaves.Erase(key);
+    }
+}
 
-    Images[key] = ImageData{};
+std::pair<SceneKey, SceneMesh &> Scene::EmplaceMesh(SceneMesh mesh)
+{
+    std::unique_lock lock(mMutex);
 
-    return {key, Images[key]};
+    return Meshes.Emplace(std::move(mesh));
 }
 
-std::pair<SceneKey, SceneMaterial &> Scene::EmplaceMaterial()
+std::pair<SceneKey, ImageData &> Scene::EmplaceImage(ImageData image)
 {
     std::unique_lock lock(mMutex);
 
-    auto key = mMaterialKeyGenerator.Get();
-    vassert(Materials.count(key) == 0);
+    return Images.Emplace(std::move(image));
+}
 
-    Materials[key] = SceneMaterial{};
+std::pair<SceneKey, SceneMaterial &> Scene::EmplaceMaterial(SceneMaterial material)
+{
+    std::unique_lock lock(mMutex);
 
-    return {key, Materials[key]};
+    return Materials.Emplace(std::move(material));
 }
 
-std::pair<SceneKey, SceneObject &> Scene::EmplaceObject()
+std::pair<SceneKey, SceneObject &> Scene::EmplaceObject(SceneObject object)
 {
     std::unique_lock lock(mMutex);
 
-    auto key = mObjectKeyGenerator.Get();
-    vassert(Objects.count(key) == 0);
+    auto res = Objects.Emplace(std::move(object));
+
+    if (auto mesh = res.second.Mesh)
+        mMeshObjects.FindOrEmplace(*mesh).push_back(res.first);
 
-    Objects[key] = SceneObject{};
+    UpdateObjectBounds(res.first);
+    RecordObjectChange(res.first, ObjectEvent::Added);
 
-    return {key, Objects[key]};
+    return res;
 }
 
-std::pair<SceneKey, SceneObject &> Scene::EmplaceObject(const SceneObject &existing)
+void Scene::EraseObject(SceneKey key)
 {
-    auto [key, obj] = EmplaceObject();
-    obj             = existing;
+    const auto *obj = Objects.Find(key);
+
+    if (obj == nullptr)
+        return;
+
+    if (obj->Mesh.has_value())
+    {
+        if (auto *meshObjects = mMeshObjects.Find(*obj->Mesh))
+            std::erase(*meshObjects, key);
+    }
 
-    return {key, obj};
+    Objects.Erase(key);
+
+    mObjectBounds.Reset(SlotKeys::Index(key));
+    UpdateObjectLeaf(key, std::nullopt);
+
+    TotalAABB = mObjectBounds.GetTotal().value_or(AABB{});
+
+    RecordObjectChange(key, ObjectEvent::Removed);
+}
+
+void Scene::MarkObjectModified(SceneKey key)
+{
+    UpdateObjectBounds(key);
+    RecordObjectChange(key, ObjectEvent::Modified);
+}
+
+void Scene::MarkMeshModified(SceneKey key)
+{
+    if (!mMeshChangeIds.Contains(key))
+    {
+        mMeshChangeIds.Emplace(key, static_cast<uint32_t>(mMeshChanges.size()));
+        mMeshChanges.push_back(key);
+    }
+
+    for (auto objKey : GetMeshObjects(key))
+        MarkObjectModified(objKey);
+}
+
+std::span<const SceneKey> Scene::GetMeshObjects(SceneKey mesh) const
+{
+    const auto *objects = mMeshObjects.Find(mesh);
+
+    if (objects == nullptr)
+        return {};
+
+    return *objects;
+}
+
+void Scene::RecordObjectChange(SceneKey key, ObjectEvent event)
+{
+    // Keys are never reused, so later changes of the same object only
+    // matter if it got removed. An object added and modified since
+    // is read in its current state anyway:
+    if (auto *id = mObjectChangeIds.Find(key))
+    {
+        if (event == ObjectEvent::Removed)
+            mObjectChanges[*id].Event = ObjectEvent::Removed;
+
+        return;
+    }
+
+    mObjectChangeIds.Emplace(key, static_cast<uint32_t>(mObjectChanges.size()));
+    mObjectChanges.push_back(ObjectChange{.Key = key, .Event = event});
+}
+
+std::unique_lock<std::mutex> Scene::Lock()
+{
+    return std::unique_lock(mMutex);
 }
 
 void Scene::RequestFullReload()
@@ -150,8 +235,34 @@ bool Scene::UpdateRequested() const
     return mUpdateFlags.Any();
 }
 
+bool Scene::ObjectsChanged() const
+{
+    return !mObjectChanges.empty();
+}
+
+std::span<const Scene::ObjectChange> Scene::GetObjectChanges() const
+{
+    return mObjectChanges;
+}
+
+bool Scene::MeshesChanged() const
+{
+    return !mMeshChanges.empty();
+}
+
+std::span<const SceneKey> Scene::GetMeshChanges() const
+{
+    return mMeshChanges;
+}
+
 void Scene::ClearUpdateFlags()
 {
     mFullReload = false;
     mUpdateFlags.Clear();
+
+    mObjectChanges.clear();
+    mObjectChangeIds.Clear();
+
+    mMeshChanges.clear();
+    mMeshChangeIds.Clear();
 }
\ No newline at end of file
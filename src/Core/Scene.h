@@ -1,18 +1,23 @@
 #pragma once
 
 #include "Bitflags.h"
+#include "BoundsTree.h"
+#include "DynamicBvh.h"
 #include "GeometryData.h"
 #include "ImageData.h"
+#include "SlotMap.h"
 
 #include <glm/glm.hpp>
 
-#include <map>
 #include <mutex>
 #include <optional>
+#include <span>
 
-// TODO: replace with a more legit unqiue ID setup:
-using SceneKey = uint32_t;
+// Scene elements are addressed by generational slot map keys, which fit
+// in 32 bits, so object keys can be written to the object id buffer:
+using SceneKey = SlotKey;
 
+// Plain counter for keys of containers which aren't slot maps:
 class SceneKeyGenerator {
   public:
     SceneKey Get()
@@ -76,11 +81,12 @@ struct SceneObject {
 
 class Scene {
   public:
-    std::map<SceneKey, ImageData>     Images;
-    std::map<SceneKey, SceneMesh>     Meshes;
-    std::map<SceneKey, SceneMaterial> Materials;
-    std::map<SceneKey, SceneObject>   Objects;
+    SlotMap<ImageData>     Images;
+    SlotMap<SceneMesh>     Meshes;
+    SlotMap<SceneMaterial> Materials;
+    SlotMap<SceneObject>   Objects;
 
+    // Union of all object bounds, kept up to date as objects change:
     AABB TotalAABB;
 
     struct Environment {
@@ -93,13 +99,34 @@ class Scene {
     } Env;
 
   public:
-    void RecalculateAABB();
-
-    std::pair<SceneKey, SceneMesh &>     EmplaceMesh();
-    std::pair<SceneKey, ImageData &>     EmplaceImage();
-    std::pair<SceneKey, SceneMaterial &> EmplaceMaterial();
-    std::pair<SceneKey, SceneObject &>   EmplaceObject();
-    std::pair<SceneKey, SceneObject &>   EmplaceObject(const SceneObject &existing);
+    // Hierarchy over world space object bounds, with object keys as leaf values.
+    // The one tree for box and ray queries of other subsystems, e.g. picking
+    // or proximity checks. Read it while holding the lock:
+    [[nodiscard]] const DynamicBvh &GetObjectTree() const;
+
+    // Erasing any element may move the others, so loaders fill elements
+    // before emplacing them instead of holding on to the returned references:
+    std::pair<SceneKey, SceneMesh &>     EmplaceMesh(SceneMesh mesh = {});
+    std::pair<SceneKey, ImageData &>     EmplaceImage(ImageData image = {});
+    std::pair<SceneKey, SceneMaterial &> EmplaceMaterial(SceneMaterial material = {});
+    std::pair<SceneKey, SceneObject &>   EmplaceObject(SceneObject object = {});
+
+    void EraseObject(SceneKey key);
+    // Has to be called after the object is changed in place, its mesh
+    // is expected to stay the one it was emplaced with:
+    void MarkObjectModified(SceneKey key);
+    // Has to be called after primitives of the mesh get new geometry.
+    // Bounds of the objects using it are updated, in O(log n) each:
+    void MarkMeshModified(SceneKey key);
+
+    // Objects emplaced with the given mesh:
+    [[nodiscard]] std::span<const SceneKey> GetMeshObjects(SceneKey mesh) const;
+
+    // Guards lookups, iteration and erasure done while other threads may be
+    // emplacing elements (i.e. during asset loading), renderers load with it.
+    // Emplace functions take the lock themselves, so they must not be called
+    // while holding it:
+    [[nodiscard]] std::unique_lock<std::mutex> Lock();
 
     enum class UpdateFlag
     {
@@ -111,6 +138,18 @@ class Scene {
         Environment,
     };
 
+    enum class ObjectEvent : uint8_t
+    {
+        Added,
+        Removed,
+        Modified,
+    };
+
+    struct ObjectChange {
+        SceneKey    Key;
+        ObjectEvent Event;
+    };
+
     // Ask for update/reload:
     void RequestFullReload();
     void RequestUpdate(UpdateFlag flag);
@@ -127,14 +166,45 @@ class Scene {
     [[nodiscard]] bool UpdateObjectsRequested() const;
     [[nodiscard]] bool UpdateEnvironmentRequested() const;
 
+    // Objects added, removed or modified since update flags were last cleared,
+    // one change per object. Unlike UpdateFlag::Objects, which reloads all
+    // of them, these let renderers patch only the affected instances:
+    [[nodiscard]] bool                         ObjectsChanged() const;
+    [[nodiscard]] std::span<const ObjectChange> GetObjectChanges() const;
+
+    // Meshes marked as modified since update flags were last cleared. Their
+    // objects are reported as modified too, renderers only need to upload
+    // the new primitives and recreate instances of these objects:
+    [[nodiscard]] bool                     MeshesChanged() const;
+    [[nodiscard]] std::span<const SceneKey> GetMeshChanges() const;
+
+  private:
+    void RecordObjectChange(SceneKey key, ObjectEvent event);
+
+    [[nodiscard]] std::optional<AABB> ComputeObjectBounds(const SceneObject &obj) const;
+    void                              UpdateObjectBounds(SceneKey key);
+    void UpdateObjectLeaf(SceneKey key, const std::optional<AABB> &bounds);
+
   private:
     bool                 mFullReload = false;
     Bitflags<UpdateFlag> mUpdateFlags;
 
-    SceneKeyGenerator mImageKeyGenerator;
-    SceneKeyGenerator mMeshKeyGenerator;
-    SceneKeyGenerator mMaterialKeyGenerator;
-    SceneKeyGenerator mObjectKeyGenerator;
+    std::vector<ObjectChange> mObjectChanges;
+    // Position of the object in the changes above:
+    SecondaryMap<uint32_t> mObjectChangeIds;
+
+    std::vector<SceneKey>  mMeshChanges;
+    SecondaryMap<uint32_t> mMeshChangeIds;
+
+    // Objects of each mesh, in no particular order:
+    SecondaryMap<std::vector<SceneKey>> mMeshObjects;
+
+    // World space object bounds, indexed by slot of the object key:
+    BoundsTree mObjectBounds;
+
+    // Objects without bounds have no leaf:
+    DynamicBvh                       mObjectTree;
+    SecondaryMap<DynamicBvh::NodeId> mObjectLeaves;
 
     std::mutex mMutex;
 };
\ No newline at end of file
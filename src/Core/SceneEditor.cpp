@@ -84,33 +84,40 @@ void SceneEditor::OnUpdate()
     HandleNodeOp();
 
     mAssetManager.OnUpdate();
+
+    // Forget finished loads, remove prefabs of the cancelled ones:
+    std::erase_if(mPrefabLoads, [&](const auto &item) {
+        const auto &[prefabId, jobId] = item;
+
+        if (mAssetManager.IsModelActive(jobId))
+            return false;
+
+        auto it = mPrefabs.find(prefabId);
+
+        if (it != mPrefabs.end() && !it->second.IsReady)
+            mPrefabs.erase(it);
+
+        return true;
+    });
 }
 
 SceneMesh &SceneEditor::GetMesh(SceneKey key)
 {
-    vassert(mScene.Meshes.count(key) != 0);
-
     return mScene.Meshes[key];
 }
 
 SceneMaterial &SceneEditor::GetMaterial(SceneKey key)
 {
-    vassert(mScene.Materials.count(key) != 0);
-
     return mScene.Materials[key];
 }
 
 ImageData &SceneEditor::GetImage(SceneKey key)
 {
-    vassert(mScene.Images.count(key) != 0);
-
     return mScene.Images[key];
 }
 
 SceneObject &SceneEditor::GetObject(SceneKey key)
 {
-    vassert(mScene.Objects.count(key) != 0);
-
     return mScene.Objects[key];
 }
 
@@ -121,8 +128,14 @@ Scene::Environment &SceneEditor::GetEnv()
 
 void SceneEditor::EraseMesh(SceneKey mesh)
 {
-    mScene.Meshes.erase(mesh);
+    // Erasure moves other meshes, which may be filled by loading models:
+    {
+        auto lock = mScene.Lock();
+        mScene.Meshes.Erase(mesh);
+    }
+
     GraphRoot.RemoveChildrenWithMesh(mScene, mesh);
+    RebuildTransforms();
 
     // TODO: Instead of outright removing this prefab
     // it should probably only remove the nodes associaded
@@ -139,14 +152,19 @@ void SceneEditor::EraseMesh(SceneKey mesh)
 
 void SceneEditor::EraseImage(SceneKey img)
 {
-    mScene.Images.erase(img);
+    {
+        auto lock = mScene.Lock();
+        mScene.Images.Erase(img);
+    }
+
+    mAssetManager.ForgetImage(img);
 
     auto ResetImageRef = [img](std::optional<SceneKey> &opt) {
         if (opt == img)
             opt = std::nullopt;
     };
 
-    for (auto &[_, mat] : mScene.Materials)
+    for (auto [_, mat] : mScene.Materials)
     {
         ResetImageRef(mat.Albedo);
         ResetImageRef(mat.Roughness);
@@ -165,11 +183,10 @@ void SceneEditor::ClearCachedHDRI()
 SceneKey SceneEditor::EmplaceObject(std::optional<SceneKey> mesh)
 {
     if (mesh)
-        vassert(mScene.Meshes.count(*mesh) != 0);
+        vassert(mScene.Meshes.Contains(*mesh));
 
-    auto [key, obj] = mScene.EmplaceObject();
-
-    obj.Mesh = mesh;
+    // Bounds of the object are computed on emplacement:
+    auto [key, _] = mScene.EmplaceObject(SceneObject{.Mesh = mesh});
 
     return key;
 }
@@ -181,24 +198,55 @@ SceneKey SceneEditor::DuplicateObject(SceneKey obj)
     return key;
 }
 
-void SceneEditor::UpdateTransforms(SceneGraphNode *rootNode)
+void SceneEditor::UpdateTransforms(SceneGraphNode *node)
 {
-    vassert(rootNode != nullptr);
+    vassert(node != nullptr);
 
-    rootNode->UpdateTransforms(mScene);
+    // Nodes missing from the hierarchy were added since it was flattened:
+    if (!mTransforms.MarkDirty(*node))
+        mTransforms.Rebuild(GraphRoot);
 
-    mScene.RequestUpdate(Scene::UpdateFlag::Objects);
+    ApplyTransforms();
+}
+
+glm::mat4 SceneEditor::GetWorldTransform(const SceneGraphNode &node) const
+{
+    if (auto world = mTransforms.FindWorld(node))
+        return *world;
+
+    return node.GetAggregateTransform();
 }
 
-void SceneEditor::LoadModel(const ModelConfig &config)
+void SceneEditor::RebuildTransforms()
+{
+    mTransforms.Rebuild(GraphRoot);
+    ApplyTransforms();
+}
+
+void SceneEditor::ApplyTransforms()
+{
+    // Objects are marked as modified, which also updates the scene bounds.
+    // Renderers patch just their instances:
+    mTransforms.Update(mScene, &mAssetManager.GetThreadPool());
+}
+
+void SceneEditor::LoadModel(const ModelConfig &config, int32_t priority)
 {
     // Append root of the hierarchy to scene editor prefabs:
-    auto [_, prefab] = EmplacePrefab();
+    auto [prefabId, prefab] = EmplacePrefab();
 
     auto &root = prefab.Root;
     root.Name  = config.Filepath.stem().string();
 
-    mAssetManager.LoadModel(config, root, prefab.IsReady);
+    mPrefabLoads[prefabId] = mAssetManager.LoadModel(config, root, prefab.IsReady,
+                                                     prefab.Diagnostics, priority);
+}
+
+void SceneEditor::CancelModelLoad(SceneKey prefabId)
+{
+    // Prefab itself is removed once the asset manager lets go of it:
+    if (auto it = mPrefabLoads.find(prefabId); it != mPrefabLoads.end())
+        mAssetManager.CancelModel(it->second);
 }
 
 void SceneEditor::SetHdri(const std::filesystem::path &path)
@@ -240,19 +288,17 @@ void SceneEditor::HandleNodeOp()
     {
     case NodeOp::Move: {
         HandleNodeMove();
-        // TODO: this can be optimized to only update
-        // affected nodes:
-        UpdateTransforms(&GraphRoot);
+        RebuildTransforms();
         break;
     }
     case NodeOp::Delete: {
         HandleNodeDelete();
-        mScene.RequestUpdate(Scene::UpdateFlag::Objects);
+        RebuildTransforms();
         break;
     }
     case NodeOp::Copy: {
         HandleNodeCopy();
-        mScene.RequestUpdate(Scene::UpdateFlag::Objects);
+        RebuildTransforms();
         break;
     }
     case NodeOp::None: {
@@ -329,15 +375,17 @@ std::pair<SceneKey, SceneEditor::Prefab &> SceneEditor::EmplacePrefab(
     if (meshKey)
     {
         mPrefabs.emplace(key, SceneEditor::Prefab{
-                                  .Root    = SceneGraphNode(*meshKey),
-                                  .IsReady = false,
+                                  .Root        = SceneGraphNode(*meshKey),
+                                  .IsReady     = false,
+                                  .Diagnostics = {},
                               });
     }
     else
     {
         mPrefabs.emplace(key, SceneEditor::Prefab{
-                                  .Root    = SceneGraphNode(),
-                                  .IsReady = false,
+                                  .Root        = SceneGraphNode(),
+                                  .IsReady     = false,
+                                  .Diagnostics = {},
                               });
     }
 
@@ -378,5 +426,5 @@ void SceneEditor::InstancePrefab(SceneKey prefabId)
     auto &prefab = mPrefabs.at(prefabId);
 
     InstancePrefabImpl(prefab.Root, GraphRoot);
-    UpdateTransforms(&GraphRoot);
+    RebuildTransforms();
 }
\ No newline at end of file
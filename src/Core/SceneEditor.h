@@ -2,8 +2,10 @@
 
 #include "AssetManager.h"
 #include "SceneGraph.h"
+#include "TransformHierarchy.h"
 
 #include <filesystem>
+#include <map>
 #include <ranges>
 
 class SceneEditor {
@@ -20,6 +22,8 @@ class SceneEditor {
     struct Prefab {
         SceneGraphNode Root;
         bool           IsReady = false;
+        // Issues found in the source file, filled out while loading:
+        std::vector<PrimitiveDiagnostics> Diagnostics;
     };
 
   public:
@@ -38,7 +42,10 @@ class SceneEditor {
     void EraseImage(SceneKey img);
     void ClearCachedHDRI();
 
-    void LoadModel(const ModelConfig &config);
+    // Loads are asynchronous, prefab becomes ready once the model is loaded.
+    // Cancelled loads have their prefab removed:
+    void LoadModel(const ModelConfig &config, int32_t priority = 0);
+    void CancelModelLoad(SceneKey prefabId);
     void SetHdri(const std::filesystem::path &path);
     void RequestFullReload();
     void RequestUpdate(Scene::UpdateFlag flag);
@@ -48,7 +55,11 @@ class SceneEditor {
     void ScheduleNodeCopy(NodeOpData data);
     void ScheduleNodeDeletion(NodeOpData data);
 
-    void UpdateTransforms(SceneGraphNode *rootNode);
+    // Recomputes transforms of the subtree rooted at the node,
+    // has to be called after its local transform is changed:
+    void UpdateTransforms(SceneGraphNode *node);
+    // World transform as of the last update:
+    [[nodiscard]] glm::mat4 GetWorldTransform(const SceneGraphNode &node) const;
 
     std::pair<SceneKey, Prefab &> EmplacePrefab(
         std::optional<SceneKey> meshKey = std::nullopt);
@@ -90,14 +101,24 @@ class SceneEditor {
     void CopyNodeTree(SceneGraphNode &source, SceneGraphNode &target);
     void InstancePrefabImpl(SceneGraphNode &source, SceneGraphNode &target);
 
+    // Has to be called after structure of the scene-graph changes:
+    void RebuildTransforms();
+    void ApplyTransforms();
+
   private:
     Scene       &mScene;
     AssetManager mAssetManager;
 
+    // Flattened scene-graph, propagates transforms of the edited subtrees:
+    TransformHierarchy mTransforms;
+
     // Trees representing mesh hierarchies of imported gltf scenes.
     // They are grafted onto the main scene-graph when instancing the gltf.
     std::map<SceneKey, Prefab> mPrefabs;
 
+    // Prefabs which are still being filled out by the asset manager:
+    std::map<SceneKey, AssetManager::ModelJobId> mPrefabLoads;
+
     enum class NodeOp
     {
         None,
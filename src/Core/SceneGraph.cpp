@@ -1,10 +1,8 @@
 #include "SceneGraph.h"
 
+#include "TransformHierarchy.h"
 #include "Vassert.h"
 
-#define GLM_ENABLE_EXPERIMENTAL
-#include <glm/gtx/quaternion.hpp>
-
 SceneGraphNode::SceneGraphNode(Scene *scene) : mScene(scene)
 {
     mPayload = ChildrenArray{};
@@ -32,7 +30,7 @@ SceneGraphNode::~SceneGraphNode()
     if (mScene && IsLeaf())
     {
         // Remove object, the node pointed to:
-        mScene->Objects.erase(GetObjectKey());
+        mScene->EraseObject(GetObjectKey());
     }
 }
 
@@ -124,16 +122,12 @@ void SceneGraphNode::RemoveChildrenWithMesh(Scene &scene, SceneKey mesh)
     }
 }
 
-glm::mat4 SceneGraphNode::GetTransform()
+glm::mat4 SceneGraphNode::GetTransform() const
 {
-    auto translation = glm::translate(glm::mat4(1.0f), Translation);
-    auto rotation    = glm::toMat4(glm::quat(Rotation));
-    auto scale       = glm::scale(glm::mat4(1.0f), Scale);
-
-    return translation * rotation * scale;
+    return TransformHierarchy::Compose(Translation, Rotation, Scale);
 }
 
-glm::mat4 SceneGraphNode::GetAggregateTransform(glm::mat4 current)
+glm::mat4 SceneGraphNode::GetAggregateTransform(glm::mat4 current) const
 {
     if (Parent)
     {
@@ -144,27 +138,3 @@ glm::mat4 SceneGraphNode::GetAggregateTransform(glm::mat4 current)
         return GetTransform() * current;
     }
 }
-
-void SceneGraphNode::UpdateTransforms(Scene &scene, glm::mat4 current)
-{
-    UpdateTransformsImpl(scene, current);
-    scene.RecalculateAABB();
-}
-
-void SceneGraphNode::UpdateTransformsImpl(Scene &scene, glm::mat4 current)
-{
-    if (IsLeaf())
-    {
-        auto &obj = scene.Objects[GetObjectKey()];
-
-        obj.Transform = current * GetTransform();
-    }
-
-    else
-    {
-        for (auto &child : GetChildren())
-        {
-            child->UpdateTransformsImpl(scene, current * GetTransform());
-        }
-    }
-}
\ No newline at end of file
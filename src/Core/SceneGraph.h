@@ -43,10 +43,11 @@ class SceneGraphNode {
     [[nodiscard]] bool SubTreeContains(SceneKey key) const;
     void               RemoveChildrenWithMesh(Scene &scene, SceneKey mesh);
 
-    glm::mat4 GetTransform();
-    glm::mat4 GetAggregateTransform(glm::mat4 current = glm::mat4(1.0f));
-
-    void UpdateTransforms(Scene &scene, glm::mat4 current = 1.0f);
+    [[nodiscard]] glm::mat4 GetTransform() const;
+    // Walks up to the root. World transforms of the nodes in the scene
+    // graph are cached by the transform hierarchy of the scene editor:
+    [[nodiscard]] glm::mat4 GetAggregateTransform(
+        glm::mat4 current = glm::mat4(1.0f)) const;
 
   public:
     SceneGraphNode *Parent = nullptr;
@@ -58,8 +59,12 @@ class SceneGraphNode {
     std::string Name;
 
   private:
-    void UpdateTransformsImpl(Scene &scene, glm::mat4 current);
+    friend class TransformHierarchy;
 
     Scene                                *mScene = nullptr;
     std::variant<ChildrenArray, SceneKey> mPayload;
+
+    // Position in the flattened hierarchy, only valid
+    // if the hierarchy points back at this node:
+    uint32_t mHierarchyIndex = UINT32_MAX;
 };
\ No newline at end of file
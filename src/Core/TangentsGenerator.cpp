@@ -1,10 +1,28 @@
 #include "TangentsGenerator.h"
 #include "Pch.h"
 
+#include "ThreadPool.h"
+#include "Timer.h"
 #include "Vassert.h"
 
 #include "mikktspace.h"
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <numbers>
+
+// Faces evaluated together by the fast generator. Its per-face math is
+// written over fixed-width lanes, which the compiler turns into simd code:
+static constexpr size_t FaceBatch = 8;
+
+// Faces (and vertices) per task of the fast generator:
+static constexpr size_t FastGrainSize = 16 * 1024;
+
+// Same threshold as mikktspace uses to tell degenerate vectors apart:
+static constexpr float NonZero = std::numeric_limits<float>::min();
+
 struct TgtData {
     PrimitiveData *Prim;
 };
@@ -15,15 +33,15 @@ static PrimitiveData *GetDataPointer(const SMikkTSpaceContext *ctx)
     return data->Prim;
 }
 
-static int GetVertexId(std::vector<uint32_t> &indices, int32_t iVert, int32_t iFace)
+static int GetVertexId(const PrimitiveData *prim, int32_t iVert, int32_t iFace)
 {
     auto indexId = 3 * iFace + iVert;
-    auto index   = static_cast<int>(indices[indexId]);
+    auto index   = static_cast<int>(prim->GetIndex(indexId));
 
     return index;
 };
 
-void tangen::GenerateTangents(PrimitiveData &prim)
+static void ValidatePrimitive(PrimitiveData &prim)
 {
     // Make sure primitive is valid:
     vassert(prim.VertexCount > 0, "Vertex count is zero!");
@@ -34,11 +52,17 @@ void tangen::GenerateTangents(PrimitiveData &prim)
     vassert(prim.Normals.size() == prim.VertexCount, "Missing normals!");
 
     vassert(prim.Tangents.empty(), "Tangents already present!");
+}
+
+void tangen::GenerateTangents(PrimitiveData &prim)
+{
+    ValidatePrimitive(prim);
 
     // Allocate space for tangents:
     prim.Tangents.resize(prim.VertexCount);
 
-    // Run MikktSpace algorithm:
+    // Run MikktSpace algorithm. It welds vertices by value across the whole
+    // primitive, so it isn't split into face ranges:
     SMikkTSpaceContext ctx;
 
     SMikkTSpaceInterface interface;
@@ -62,7 +86,7 @@ void tangen::GenerateTangents(PrimitiveData &prim)
     interface.m_getPosition = [](const SMikkTSpaceContext *pContext, float fvPosOut[],
                                  const int iFace, const int iVert) {
         auto prim  = GetDataPointer(pContext);
-        auto index = GetVertexId(prim->Indices, iVert, iFace);
+        auto index = GetVertexId(prim, iVert, iFace);
 
         auto pos = prim->Positions[index];
 
@@ -74,7 +98,7 @@ void tangen::GenerateTangents(PrimitiveData &prim)
     interface.m_getTexCoord = [](const SMikkTSpaceContext *pContext, float fvTexcOut[],
                                  const int iFace, const int iVert) {
         auto prim  = GetDataPointer(pContext);
-        auto index = GetVertexId(prim->Indices, iVert, iFace);
+        auto index = GetVertexId(prim, iVert, iFace);
 
         auto texcoord = prim->TexCoords[index];
 
@@ -85,7 +109,7 @@ void tangen::GenerateTangents(PrimitiveData &prim)
     interface.m_getNormal = [](const SMikkTSpaceContext *pContext, float fvNormOut[],
                                const int iFace, const int iVert) {
         auto prim  = GetDataPointer(pContext);
-        auto index = GetVertexId(prim->Indices, iVert, iFace);
+        auto index = GetVertexId(prim, iVert, iFace);
 
         auto normal = prim->Normals[index];
 
@@ -98,7 +122,7 @@ void tangen::GenerateTangents(PrimitiveData &prim)
                                     const float fvTangent[], const float fSign,
                                     const int iFace, const int iVert) {
         auto prim  = GetDataPointer(pContext);
-        auto index = GetVertexId(prim->Indices, iVert, iFace);
+        auto index = GetVertexId(prim, iVert, iFace);
 
         glm::vec4 tangent{fvTangent[0], fvTangent[1], fvTangent[2], fSign};
 
@@ -114,7 +138,7 @@ void tangen::GenerateTangents(PrimitiveData &prim)
             (void)fMagT;
 
             auto prim  = GetDataPointer(pContext);
-            auto index = GetVertexId(prim->Indices, iVert, iFace);
+            auto index = GetVertexId(prim, iVert, iFace);
 
             auto sign = bIsOrientationPreserving ? 1.0f : (-1.0f);
 
@@ -138,4 +162,322 @@ void tangen::GenerateTangents(PrimitiveData &prim)
         };
 
     genTangSpaceDefault(&ctx);
-}
\ No newline at end of file
+}
+
+// Per-face flags of the fast generator, mirroring the mikktspace ones:
+static constexpr uint8_t OrientPreserving = 1 << 0;
+// Face with degenerate uv mapping or positions, which doesn't contribute:
+static constexpr uint8_t GroupWithAny = 1 << 1;
+
+// Contributions of face corners to their vertex tangents, one flat array
+// per component, indexed like the index buffer:
+struct CornerData {
+    std::vector<float>   X, Y, Z;
+    std::vector<uint8_t> FaceFlags;
+};
+
+using Lanes = std::array<float, FaceBatch>;
+
+// Polynomial acos (Abramowitz & Stegun 4.4.45), error below 7e-5 rad.
+// Branch free, so that the batch loops using it stay vectorized:
+static float FastAcos(float x)
+{
+    const float ax   = std::min(std::abs(x), 1.0f);
+    const float poly =
+        ((-0.0187293f * ax + 0.0742610f) * ax - 0.2121144f) * ax + 1.5707288f;
+    const float res  = std::sqrt(std::max(1.0f - ax, 0.0f)) * poly;
+
+    return x < 0.0f ? std::numbers::pi_v<float> - res : res;
+}
+
+// Scale which normalizes a vector, degenerate vectors are kept as they are:
+static float InvLength(float x, float y, float z)
+{
+    const float len2 = x * x + y * y + z * z;
+
+    return len2 > NonZero ? 1.0f / std::sqrt(len2) : 1.0f;
+}
+
+static void EvalFaceBatch(const PrimitiveData &prim, size_t firstFace, size_t count,
+                          CornerData &out)
+{
+    // Attributes of the three corners of each face in the batch:
+    std::array<Lanes, 3> px, py, pz, nx, ny, nz, u, v;
+
+    for (size_t l = 0; l < FaceBatch; l++)
+    {
+        // Tail lanes repeat the last face, their results are dropped:
+        const size_t face = firstFace + std::min(l, count - 1);
+
+        for (size_t c = 0; c < 3; c++)
+        {
+            const auto index = prim.GetIndex(3 * face + c);
+
+            const auto &pos    = prim.Positions[index];
+            const auto &normal = prim.Normals[index];
+            const auto &uv     = prim.TexCoords[index];
+
+            px[c][l] = pos.x, py[c][l] = pos.y, pz[c][l] = pos.z;
+            nx[c][l] = normal.x, ny[c][l] = normal.y, nz[c][l] = normal.z;
+            u[c][l] = uv.x, v[c][l] = uv.y;
+        }
+    }
+
+    // First order derivative of positions along u (eq. 18 of mikktspace):
+    // Flags use lanes as wide as the floats, so that they share vector width:
+    Lanes                           ox, oy, oz;
+    std::array<uint32_t, FaceBatch> flags;
+
+    for (size_t l = 0; l < FaceBatch; l++)
+    {
+        const float d1x = px[1][l] - px[0][l];
+        const float d1y = py[1][l] - py[0][l];
+        const float d1z = pz[1][l] - pz[0][l];
+        const float d2x = px[2][l] - px[0][l];
+        const float d2y = py[2][l] - py[0][l];
+        const float d2z = pz[2][l] - pz[0][l];
+
+        const float t21x = u[1][l] - u[0][l];
+        const float t21y = v[1][l] - v[0][l];
+        const float t31x = u[2][l] - u[0][l];
+        const float t31y = v[2][l] - v[0][l];
+
+        const float area = t21x * t31y - t21y * t31x;
+
+        const float sx = t31y * d1x - t21y * d2x;
+        const float sy = t31y * d1y - t21y * d2y;
+        const float sz = t31y * d1z - t21y * d2z;
+
+        const float tx = t21x * d2x - t31x * d1x;
+        const float ty = t21x * d2y - t31x * d1y;
+        const float tz = t21x * d2z - t31x * d1z;
+
+        const float lenS2   = sx * sx + sy * sy + sz * sz;
+        const float lenT2   = tx * tx + ty * ty + tz * tz;
+        const float absArea = std::abs(area);
+
+        // Faces with coinciding corners are skipped by mikktspace. Bitwise
+        // operators keep the lanes free of branches:
+        const bool degenerate = ((d1x == 0.0f) & (d1y == 0.0f) & (d1z == 0.0f)) |
+                                ((d2x == 0.0f) & (d2y == 0.0f) & (d2z == 0.0f)) |
+                                ((d1x == d2x) & (d1y == d2y) & (d1z == d2z));
+
+        const bool good = (absArea > NonZero) & (lenS2 > 0.0f) & (lenT2 > 0.0f) &
+                          !degenerate;
+
+        const float sign  = area > 0.0f ? 1.0f : -1.0f;
+        const float scale = good ? sign * InvLength(sx, sy, sz) : 0.0f;
+
+        ox[l] = scale * sx;
+        oy[l] = scale * sy;
+        oz[l] = scale * sz;
+
+        flags[l] = (area > 0.0f ? OrientPreserving : 0u) | (good ? 0u : GroupWithAny);
+    }
+
+    // Corner contributions, projected onto the plane of the vertex normal and
+    // weighted by the corner angle in that plane:
+    std::array<Lanes, 3> cx, cy, cz;
+
+    for (size_t c = 0; c < 3; c++)
+    {
+        const size_t prev = (c + 2) % 3;
+        const size_t next = (c + 1) % 3;
+
+        for (size_t l = 0; l < FaceBatch; l++)
+        {
+            const float n0 = nx[c][l], n1 = ny[c][l], n2 = nz[c][l];
+
+            const float dotS = n0 * ox[l] + n1 * oy[l] + n2 * oz[l];
+
+            float sx = ox[l] - dotS * n0;
+            float sy = oy[l] - dotS * n1;
+            float sz = oz[l] - dotS * n2;
+
+            const float invS = InvLength(sx, sy, sz);
+            sx *= invS, sy *= invS, sz *= invS;
+
+            float e1x = px[prev][l] - px[c][l];
+            float e1y = py[prev][l] - py[c][l];
+            float e1z = pz[prev][l] - pz[c][l];
+            float e2x = px[next][l] - px[c][l];
+            float e2y = py[next][l] - py[c][l];
+            float e2z = pz[next][l] - pz[c][l];
+
+            const float dot1 = n0 * e1x + n1 * e1y + n2 * e1z;
+            const float dot2 = n0 * e2x + n1 * e2y + n2 * e2z;
+
+            e1x -= dot1 * n0, e1y -= dot1 * n1, e1z -= dot1 * n2;
+            e2x -= dot2 * n0, e2y -= dot2 * n1, e2z -= dot2 * n2;
+
+            const float inv1 = InvLength(e1x, e1y, e1z);
+            const float inv2 = InvLength(e2x, e2y, e2z);
+
+            const float cos = (e1x * e2x + e1y * e2y + e1z * e2z) * inv1 * inv2;
+
+            // Out of range values are clamped inside:
+            const float angle = FastAcos(cos);
+
+            cx[c][l] = angle * sx;
+            cy[c][l] = angle * sy;
+            cz[c][l] = angle * sz;
+        }
+    }
+
+    for (size_t l = 0; l < count; l++)
+    {
+        const size_t face = firstFace + l;
+
+        out.FaceFlags[face] = static_cast<uint8_t>(flags[l]);
+
+        for (size_t c = 0; c < 3; c++)
+        {
+            out.X[3 * face + c] = cx[c][l];
+            out.Y[3 * face + c] = cy[c][l];
+            out.Z[3 * face + c] = cz[c][l];
+        }
+    }
+}
+
+void tangen::GenerateTangentsFast(PrimitiveData &prim, ThreadPool &pool)
+{
+    ValidatePrimitive(prim);
+
+    const size_t faceCount   = prim.IndexCount / 3;
+    const size_t cornerCount = 3 * faceCount;
+
+    CornerData corners{
+        .X         = std::vector<float>(cornerCount),
+        .Y         = std::vector<float>(cornerCount),
+        .Z         = std::vector<float>(cornerCount),
+        .FaceFlags = std::vector<uint8_t>(faceCount),
+    };
+
+    pool.ParallelFor(faceCount, FastGrainSize, [&](size_t begin, size_t end) {
+        for (size_t face = begin; face < end; face += FaceBatch)
+            EvalFaceBatch(prim, face, std::min(FaceBatch, end - face), corners);
+    });
+
+    // Corners of each vertex in index buffer order (compressed sparse rows):
+    std::vector<uint32_t> offsets(prim.VertexCount + 1, 0);
+    std::vector<uint32_t> vertexCorners(cornerCount);
+
+    for (size_t corner = 0; corner < cornerCount; corner++)
+        offsets[prim.GetIndex(corner) + 1]++;
+
+    for (size_t vert = 0; vert < prim.VertexCount; vert++)
+        offsets[vert + 1] += offsets[vert];
+
+    {
+        std::vector<uint32_t> cursor(offsets.begin(), offsets.end() - 1);
+
+        for (size_t corner = 0; corner < cornerCount; corner++)
+        {
+            const auto vert = prim.GetIndex(corner);
+
+            vertexCorners[cursor[vert]++] = static_cast<uint32_t>(corner);
+        }
+    }
+
+    prim.Tangents.resize(prim.VertexCount);
+
+    pool.ParallelFor(prim.VertexCount, FastGrainSize, [&](size_t begin, size_t end) {
+        for (size_t vert = begin; vert < end; vert++)
+        {
+            const uint32_t first = offsets[vert];
+            const uint32_t last  = offsets[vert + 1];
+
+            if (first == last)
+                continue;
+
+            // MikkTSpace computes one tangent per orientation group and the
+            // last face (in index order) touching the vertex overwrites the
+            // others, so only the group of that face is kept:
+            uint8_t orient = corners.FaceFlags[vertexCorners[last - 1] / 3];
+
+            for (uint32_t i = last; i > first; i--)
+            {
+                const uint8_t flags = corners.FaceFlags[vertexCorners[i - 1] / 3];
+
+                if ((flags & GroupWithAny) == 0)
+                {
+                    orient = flags;
+                    break;
+                }
+            }
+
+            orient &= OrientPreserving;
+
+            glm::vec3 sum(0.0f);
+
+            for (uint32_t i = first; i < last; i++)
+            {
+                const uint32_t corner = vertexCorners[i];
+                const uint8_t  flags  = corners.FaceFlags[corner / 3];
+
+                if ((flags & OrientPreserving) != orient && (flags & GroupWithAny) == 0)
+                    continue;
+
+                sum += glm::vec3(corners.X[corner], corners.Y[corner], corners.Z[corner]);
+            }
+
+            // Same fallback for degenerate tangents as in the mikktspace path:
+            const float len = glm::length(sum);
+            const auto  tan = len < 0.01f ? glm::vec3(1, 0, 0) : sum / len;
+
+            prim.Tangents[vert] = glm::vec4(tan, orient ? 1.0f : -1.0f);
+        }
+    });
+}
+
+void tangen::GenerateTangents(PrimitiveData &prim, TangentMethod method, ThreadPool &pool)
+{
+    if (method == TangentMethod::Fast)
+        GenerateTangentsFast(prim, pool);
+    else
+        GenerateTangents(prim);
+}
+
+TangentBenchmark tangen::Benchmark(PrimitiveData &prim, TangentMethod method,
+                                   ThreadPool &pool)
+{
+    TangentBenchmark res{};
+
+    auto start = Timer::Now();
+    GenerateTangentsFast(prim, pool);
+    res.FastSeconds = Timer::GetDiffSeconds(Timer::Now(), start);
+
+    auto fast = std::move(prim.Tangents);
+    prim.Tangents.clear();
+
+    start = Timer::Now();
+    GenerateTangents(prim);
+    res.MikkSeconds = Timer::GetDiffSeconds(Timer::Now(), start);
+
+    for (size_t vert = 0; vert < prim.VertexCount; vert++)
+    {
+        const auto &a = fast[vert];
+        const auto &b = prim.Tangents[vert];
+
+        // Vertices not referenced by any face have no tangent:
+        if (a.w == 0.0f || b.w == 0.0f)
+            continue;
+
+        // More precise than acos for nearly parallel vectors:
+        const float sin   = glm::length(glm::cross(glm::vec3(a), glm::vec3(b)));
+        const float cos   = glm::dot(glm::vec3(a), glm::vec3(b));
+        const float angle = std::atan2(sin, cos) * 180.0f / std::numbers::pi_v<float>;
+
+        res.Vertices++;
+        res.MaxAngle = std::max(res.MaxAngle, angle);
+        res.AngleSum += angle;
+
+        if (a.w != b.w)
+            res.SignMismatches++;
+    }
+
+    if (method == TangentMethod::Fast)
+        prim.Tangents = std::move(fast);
+
+    return res;
+}
@@ -2,7 +2,22 @@
 
 #include "GltfImporter.h"
 
+class ThreadPool;
+
 namespace tangen
 {
 void GenerateTangents(PrimitiveData &prim);
-} // namespace tangen
\ No newline at end of file
+
+// Alternative to mikktspace, which evaluates faces in simd-friendly batches
+// and accumulates vertices in parallel. Orientation groups are resolved per
+// vertex, so results match mikktspace to within the polynomial acos error
+// (about 0.01 degrees) on meshes whose vertices are already welded. Vertices
+// that mikktspace would weld by value, or that sit between two disconnected
+// fans of the same orientation, may differ more:
+void GenerateTangentsFast(PrimitiveData &prim, ThreadPool &pool);
+
+void GenerateTangents(PrimitiveData &prim, TangentMethod method, ThreadPool &pool);
+
+// Runs both generators, keeps the results of the given method:
+TangentBenchmark Benchmark(PrimitiveData &prim, TangentMethod method, ThreadPool &pool);
+} // namespace tangen
@@ -0,0 +1,697 @@
+#include "TextureCompressor.h"
+#include "Pch.h"
+
+#include "Hash.h"
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "Vassert.h"
+
+#define KHRONOS_STATIC
+#include "ktx.h"
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <format>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Bump the version whenever the compressed output changes:
+static constexpr uint32_t CompressorVersion = 2;
+
+static const std::filesystem::path CacheDirectory = "cache/textures";
+
+using Block = std::array<Pixel, 16>;
+
+// View of a single mip level:
+struct Level {
+    uint32_t               Width;
+    uint32_t               Height;
+    std::span<const Pixel> Pixels;
+};
+
+// Sequentially fills bits of a block, starting from the least significant:
+class BitWriter {
+  public:
+    BitWriter(uint8_t *out, size_t size) : mOut(out)
+    {
+        std::memset(out, 0, size);
+    }
+
+    void Write(uint32_t value, uint32_t bits)
+    {
+        for (uint32_t i = 0; i < bits; i++, mPos++)
+            mOut[mPos / 8] |= static_cast<uint8_t>(((value >> i) & 1) << (mPos % 8));
+    }
+
+  private:
+    uint8_t *mOut;
+    size_t   mPos = 0;
+};
+
+// BC4 stores two endpoints and 3-bit indices. With e0 > e1 the endpoints
+// are interpolated into 8 values, otherwise into 6 values plus 0 and 255.
+// Returns squared error, indices are written out:
+static uint32_t FitBC4(uint8_t e0, uint8_t e1, const std::array<uint8_t, 16> &values,
+                       std::array<uint8_t, 16> &indices)
+{
+    std::array<int32_t, 8> palette{e0, e1};
+
+    if (e0 > e1)
+    {
+        for (int32_t i = 1; i < 7; i++)
+            palette[i + 1] = ((7 - i) * e0 + i * e1 + 3) / 7;
+    }
+    else
+    {
+        for (int32_t i = 1; i < 5; i++)
+            palette[i + 1] = ((5 - i) * e0 + i * e1 + 2) / 5;
+
+        palette[6] = 0;
+        palette[7] = 255;
+    }
+
+    uint32_t error = 0;
+
+    for (size_t i = 0; i < values.size(); i++)
+    {
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+
+        for (size_t k = 0; k < palette.size(); k++)
+        {
+            const int32_t  diff = palette[k] - values[i];
+            const uint32_t err  = static_cast<uint32_t>(diff * diff);
+
+            if (err < bestError)
+            {
+                bestError  = err;
+                indices[i] = static_cast<uint8_t>(k);
+            }
+        }
+
+        error += bestError;
+    }
+
+    return error;
+}
+
+static void EncodeBC4(const std::array<uint8_t, 16> &values, uint8_t *out)
+{
+    const auto [lo, hi] = std::ranges::minmax(values);
+
+    std::array<uint8_t, 16> indices;
+
+    uint8_t  e0    = hi;
+    uint8_t  e1    = lo;
+    uint32_t error = FitBC4(e0, e1, values, indices);
+
+    // Blocks touching the extremes may do better with 0 and 255
+    // taken from the fixed palette entries:
+    if (error > 0 && (lo == 0 || hi == 255))
+    {
+        uint8_t innerLo = 255;
+        uint8_t innerHi = 0;
+
+        for (auto v : values)
+        {
+            if (v != 0 && v != 255)
+            {
+                innerLo = std::min(innerLo, v);
+                innerHi = std::max(innerHi, v);
+            }
+        }
+
+        if (innerLo > innerHi)
+            innerLo = innerHi = 0;
+
+        std::array<uint8_t, 16> altIndices;
+
+        const auto altError = FitBC4(innerLo, innerHi, values, altIndices);
+
+        if (altError < error)
+        {
+            e0      = innerLo;
+            e1      = innerHi;
+            indices = altIndices;
+        }
+    }
+
+    BitWriter writer(out, 8);
+    writer.Write(e0, 8);
+    writer.Write(e1, 8);
+
+    for (auto idx : indices)
+        writer.Write(idx, 3);
+}
+
+// BC7 mode 6: single subset, RGBA endpoints with 7 bits per channel
+// plus a unique p-bit per endpoint, and 4-bit indices:
+static constexpr std::array<int32_t, 16> BC7Weights = {0,  4,  9,  13, 17, 21, 26, 30,
+                                                       34, 38, 43, 47, 51, 55, 60, 64};
+
+using Color = std::array<float, 4>;
+
+struct BC7Endpoint {
+    std::array<uint8_t, 4> Quantized;
+    uint8_t                PBit;
+
+    [[nodiscard]] int32_t Value(size_t channel) const
+    {
+        return (Quantized[channel] << 1) | PBit;
+    }
+};
+
+static BC7Endpoint QuantizeBC7(const Color &color)
+{
+    BC7Endpoint best{};
+    float       bestError = std::numeric_limits<float>::max();
+
+    for (uint8_t pbit = 0; pbit < 2; pbit++)
+    {
+        BC7Endpoint candidate{.Quantized = {}, .PBit = pbit};
+        float       error = 0.0f;
+
+        for (size_t c = 0; c < 4; c++)
+        {
+            const float q = std::round((std::clamp(color[c], 0.0f, 255.0f) - pbit) / 2.0f);
+
+            candidate.Quantized[c] = static_cast<uint8_t>(std::clamp(q, 0.0f, 127.0f));
+
+            const float diff = static_cast<float>(candidate.Value(c)) - color[c];
+            error += diff * diff;
+        }
+
+        if (error < bestError)
+        {
+            best      = candidate;
+            bestError = error;
+        }
+    }
+
+    return best;
+}
+
+// Picks the closest palette entry for every pixel, returns squared error:
+static uint32_t AssignBC7(const Block &block, const BC7Endpoint &e0, const BC7Endpoint &e1,
+                          std::array<uint8_t, 16> &indices)
+{
+    std::array<std::array<int32_t, 4>, 16> palette;
+
+    for (size_t k = 0; k < palette.size(); k++)
+    {
+        for (size_t c = 0; c < 4; c++)
+        {
+            const int32_t w = BC7Weights[k];
+            palette[k][c]   = ((64 - w) * e0.Value(c) + w * e1.Value(c) + 32) >> 6;
+        }
+    }
+
+    uint32_t error = 0;
+
+    for (size_t i = 0; i < block.size(); i++)
+    {
+        const std::array<int32_t, 4> px{block[i].R, block[i].G, block[i].B, block[i].A};
+
+        uint32_t bestError = std::numeric_limits<uint32_t>::max();
+
+        for (size_t k = 0; k < palette.size(); k++)
+        {
+            uint32_t err = 0;
+
+            for (size_t c = 0; c < 4; c++)
+            {
+                const int32_t diff = palette[k][c] - px[c];
+                err += static_cast<uint32_t>(diff * diff);
+            }
+
+            if (err < bestError)
+            {
+                bestError  = err;
+                indices[i] = static_cast<uint8_t>(k);
+            }
+        }
+
+        error += bestError;
+    }
+
+    return error;
+}
+
+// Endpoints minimizing squared error for fixed interpolation weights:
+static bool SolveBC7Endpoints(const Block &block, const std::array<uint8_t, 16> &indices,
+                              Color &e0, Color &e1)
+{
+    float a = 0.0f, b = 0.0f, c = 0.0f;
+
+    Color rhs0{}, rhs1{};
+
+    for (size_t i = 0; i < block.size(); i++)
+    {
+        const float w = static_cast<float>(BC7Weights[indices[i]]) / 64.0f;
+
+        const Color px{
+            static_cast<float>(block[i].R),
+            static_cast<float>(block[i].G),
+            static_cast<float>(block[i].B),
+            static_cast<float>(block[i].A),
+        };
+
+        a += (1.0f - w) * (1.0f - w);
+        b += (1.0f - w) * w;
+        c += w * w;
+
+        for (size_t ch = 0; ch < 4; ch++)
+        {
+            rhs0[ch] += (1.0f - w) * px[ch];
+            rhs1[ch] += w * px[ch];
+        }
+    }
+
+    const float det = a * c - b * b;
+
+    if (std::abs(det) < 1e-6f)
+        return false;
+
+    for (size_t ch = 0; ch < 4; ch++)
+    {
+        e0[ch] = (c * rhs0[ch] - b * rhs1[ch]) / det;
+        e1[ch] = (a * rhs1[ch] - b * rhs0[ch]) / det;
+    }
+
+    return true;
+}
+
+static void EncodeBC7(const Block &block, uint8_t *out)
+{
+    // Initial endpoints span the block along its principal axis:
+    Color mean{};
+
+    for (const auto &p : block)
+    {
+        mean[0] += p.R;
+        mean[1] += p.G;
+        mean[2] += p.B;
+        mean[3] += p.A;
+    }
+
+    for (auto &m : mean)
+        m /= static_cast<float>(block.size());
+
+    std::array<Color, 16> centered;
+    std::array<Color, 4>  covariance{};
+
+    for (size_t i = 0; i < block.size(); i++)
+    {
+        centered[i] = Color{
+            block[i].R - mean[0],
+            block[i].G - mean[1],
+            block[i].B - mean[2],
+            block[i].A - mean[3],
+        };
+
+        for (size_t r = 0; r < 4; r++)
+        {
+            for (size_t c = 0; c < 4; c++)
+                covariance[r][c] += centered[i][r] * centered[i][c];
+        }
+    }
+
+    Color axis{1.0f, 1.0f, 1.0f, 1.0f};
+
+    for (size_t iter = 0; iter < 8; iter++)
+    {
+        Color next{};
+
+        for (size_t r = 0; r < 4; r++)
+        {
+            for (size_t c = 0; c < 4; c++)
+                next[r] += covariance[r][c] * axis[c];
+        }
+
+        const float len = std::sqrt(next[0] * next[0] + next[1] * next[1] +
+                                    next[2] * next[2] + next[3] * next[3]);
+
+        if (len < 1e-6f)
+            break;
+
+        for (size_t c = 0; c < 4; c++)
+            axis[c] = next[c] / len;
+    }
+
+    float tmin = 0.0f, tmax = 0.0f;
+
+    for (const auto &p : centered)
+    {
+        const float t = p[0] * axis[0] + p[1] * axis[1] + p[2] * axis[2] + p[3] * axis[3];
+
+        tmin = std::min(tmin, t);
+        tmax = std::max(tmax, t);
+    }
+
+    Color c0, c1;
+
+    for (size_t c = 0; c < 4; c++)
+    {
+        c0[c] = mean[c] + tmin * axis[c];
+        c1[c] = mean[c] + tmax * axis[c];
+    }
+
+    auto e0 = QuantizeBC7(c0);
+    auto e1 = QuantizeBC7(c1);
+
+    std::array<uint8_t, 16> indices;
+    uint32_t                error = AssignBC7(block, e0, e1, indices);
+
+    // Refine endpoints with least squares fits to the chosen indices:
+    for (size_t iter = 0; iter < 2 && error > 0; iter++)
+    {
+        if (!SolveBC7Endpoints(block, indices, c0, c1))
+            break;
+
+        const auto q0 = QuantizeBC7(c0);
+        const auto q1 = QuantizeBC7(c1);
+
+        std::array<uint8_t, 16> newIndices;
+        const uint32_t          newError = AssignBC7(block, q0, q1, newIndices);
+
+        if (newError >= error)
+            break;
+
+        e0      = q0;
+        e1      = q1;
+        indices = newIndices;
+        error   = newError;
+    }
+
+    // Most significant bit of the first index is implicitly zero:
+    if (indices[0] >= 8)
+    {
+        std::swap(e0, e1);
+
+        for (auto &idx : indices)
+            idx = static_cast<uint8_t>(15 - idx);
+    }
+
+    BitWriter writer(out, 16);
+    writer.Write(1 << 6, 7);
+
+    for (size_t c = 0; c < 4; c++)
+    {
+        writer.Write(e0.Quantized[c], 7);
+        writer.Write(e1.Quantized[c], 7);
+    }
+
+    writer.Write(e0.PBit, 1);
+    writer.Write(e1.PBit, 1);
+
+    for (size_t i = 0; i < indices.size(); i++)
+        writer.Write(indices[i], i == 0 ? 3 : 4);
+}
+
+struct Encoding {
+    VkFormat Format;
+    size_t   BlockSize;
+    // Ktx swizzle string:
+    const char *Swizzle;
+    // Encodes one 4x4 block:
+    void (*Encode)(const Block &block, uint8_t *out);
+};
+
+static std::array<uint8_t, 16> Channel(const Block &block, uint8_t Pixel::*channel)
+{
+    std::array<uint8_t, 16> res;
+
+    for (size_t i = 0; i < block.size(); i++)
+        res[i] = block[i].*channel;
+
+    return res;
+}
+
+static Encoding ChooseEncoding(const Level &base, TextureUsage usage, bool unorm)
+{
+    switch (usage)
+    {
+    case TextureUsage::Color:
+        return Encoding{
+            .Format    = unorm ? VK_FORMAT_BC7_UNORM_BLOCK : VK_FORMAT_BC7_SRGB_BLOCK,
+            .BlockSize = 16,
+            .Swizzle   = "rgba",
+            .Encode    = EncodeBC7,
+        };
+    case TextureUsage::Normal:
+        return Encoding{
+            .Format    = VK_FORMAT_BC5_UNORM_BLOCK,
+            .BlockSize = 16,
+            .Swizzle   = "rg01",
+            .Encode =
+                [](const Block &block, uint8_t *out) {
+                    EncodeBC4(Channel(block, &Pixel::R), out);
+                    EncodeBC4(Channel(block, &Pixel::G), out + 8);
+                },
+        };
+    case TextureUsage::RoughnessMetallic:
+        break;
+    }
+
+    // Roughness is in green and metallic in blue. Constant metallic
+    // of 0 or 1 is provided by the swizzle, so only roughness is stored:
+    const auto metallic = base.Pixels.front().B;
+
+    const bool constantMetallic =
+        (metallic == 0 || metallic == 255) &&
+        std::ranges::all_of(base.Pixels, [&](Pixel p) { return p.B == metallic; });
+
+    if (constantMetallic)
+    {
+        return Encoding{
+            .Format    = VK_FORMAT_BC4_UNORM_BLOCK,
+            .BlockSize = 8,
+            .Swizzle   = metallic == 0 ? "0r01" : "0r11",
+            .Encode =
+                [](const Block &block, uint8_t *out) {
+                    EncodeBC4(Channel(block, &Pixel::G), out);
+                },
+        };
+    }
+
+    return Encoding{
+        .Format    = VK_FORMAT_BC5_UNORM_BLOCK,
+        .BlockSize = 16,
+        .Swizzle   = "0rg1",
+        .Encode =
+            [](const Block &block, uint8_t *out) {
+                EncodeBC4(Channel(block, &Pixel::G), out);
+                EncodeBC4(Channel(block, &Pixel::B), out + 8);
+            },
+    };
+}
+
+// Rows of blocks are compressed in parallel:
+static std::vector<uint8_t> CompressLevel(const Level &level, const Encoding &encoding,
+                                          ThreadPool &pool)
+{
+    const uint32_t blocksX = (level.Width + 3) / 4;
+    const uint32_t blocksY = (level.Height + 3) / 4;
+
+    std::vector<uint8_t> res(blocksX * blocksY * encoding.BlockSize);
+
+    const size_t grainSize = std::max<size_t>(1, 1024 / blocksX);
+
+    pool.ParallelFor(blocksY, grainSize, [&](size_t first, size_t last) {
+        for (size_t by = first; by < last; by++)
+        {
+            for (uint32_t bx = 0; bx < blocksX; bx++)
+            {
+                // Edge blocks repeat the last row/column:
+                Block block;
+
+                for (uint32_t i = 0; i < 16; i++)
+                {
+                    const auto x = std::min<uint32_t>(4 * bx + i % 4, level.Width - 1);
+                    const auto y = std::min<uint32_t>(4 * by + i / 4, level.Height - 1);
+
+                    block[i] = level.Pixels[y * level.Width + x];
+                }
+
+                const size_t offset = (by * blocksX + bx) * encoding.BlockSize;
+                encoding.Encode(block, res.data() + offset);
+            }
+        }
+    });
+
+    return res;
+}
+
+// Packs compressed levels into a ktx2 container, returns its bytes:
+static std::vector<uint8_t> WriteKtx2(const std::vector<Level>                &levels,
+                                      const std::vector<std::vector<uint8_t>> &data,
+                                      const Encoding                          &encoding)
+{
+    ktxTextureCreateInfo info{};
+    info.vkFormat        = encoding.Format;
+    info.baseWidth       = levels.front().Width;
+    info.baseHeight      = levels.front().Height;
+    info.baseDepth       = 1;
+    info.numDimensions   = 2;
+    info.numLevels       = static_cast<ktx_uint32_t>(levels.size());
+    info.numLayers       = 1;
+    info.numFaces        = 1;
+    info.isArray         = KTX_FALSE;
+    info.generateMipmaps = KTX_FALSE;
+
+    ktxTexture2 *texture;
+
+    auto ret = ktxTexture2_Create(&info, KTX_TEXTURE_CREATE_ALLOC_STORAGE, &texture);
+    vassert(ret == KTX_SUCCESS, "Failed to create a ktx2 texture!");
+
+    for (size_t lvl = 0; lvl < data.size(); lvl++)
+    {
+        ret = ktxTexture_SetImageFromMemory(ktxTexture(texture),
+                                            static_cast<ktx_uint32_t>(lvl), 0, 0,
+                                            data[lvl].data(), data[lvl].size());
+        vassert(ret == KTX_SUCCESS, "Failed to fill a ktx2 texture!");
+    }
+
+    const std::string swizzle = encoding.Swizzle;
+
+    ktxHashList_AddKVPair(&texture->kvDataHead, KTX_SWIZZLE_KEY,
+                          static_cast<unsigned int>(swizzle.size() + 1), swizzle.c_str());
+
+    ktx_uint8_t *bytes = nullptr;
+    ktx_size_t   size  = 0;
+
+    ret = ktxTexture_WriteToMemory(ktxTexture(texture), &bytes, &size);
+    vassert(ret == KTX_SUCCESS, "Failed to write a ktx2 texture!");
+
+    std::vector<uint8_t> res(bytes, bytes + size);
+
+    free(bytes);
+    ktxTexture_Destroy(ktxTexture(texture));
+
+    return res;
+}
+
+// Neutral value of a missing image, same as the renderers' default textures:
+static Pixel PlaceholderPixel(TextureUsage usage)
+{
+    switch (usage)
+    {
+    case TextureUsage::Normal:
+        return Pixel{128, 128, 255, 0};
+    case TextureUsage::RoughnessMetallic:
+        return Pixel{0, 255, 255, 0};
+    default:
+        return Pixel{255, 255, 255, 255};
+    }
+}
+
+static void StoreCached(const std::filesystem::path &path, std::span<const uint8_t> bytes)
+{
+    std::error_code ec;
+    std::filesystem::create_directories(path.parent_path(), ec);
+
+    // Written to a temporary path, so that interrupted imports never leave
+    // a partial file behind. It's unique to the thread, as several models
+    // may compress the same image concurrently:
+    const auto threadId = std::hash<std::thread::id>{}(std::this_thread::get_id());
+
+    auto tmpPath = path;
+    tmpPath += std::format(".{:016x}.tmp", threadId);
+
+    {
+        std::ofstream out(tmpPath, std::ios::binary);
+        out.write(reinterpret_cast<const char *>(bytes.data()),
+                  static_cast<std::streamsize>(bytes.size()));
+
+        if (!out.good())
+        {
+            std::cerr << "Failed to write compressed texture: " << tmpPath.string() << '\n';
+            return;
+        }
+    }
+
+    std::filesystem::rename(tmpPath, path, ec);
+
+    if (ec)
+        std::filesystem::remove(tmpPath, ec);
+}
+
+ImageData TextureCompressor::Import(std::span<const uint8_t> encoded, TextureUsage usage,
+                                    bool unorm, ThreadPool &pool)
+{
+    Hasher hasher;
+    hasher.Value(CompressorVersion);
+    hasher.Value(usage);
+    hasher.Value(unorm);
+    hasher.Bytes(encoded);
+
+    const auto cachePath = CacheDirectory / std::format("{:016x}.ktx2", hasher.Get());
+
+    if (std::filesystem::exists(cachePath))
+        return ImageData::ImportImage(cachePath.string().c_str(), unorm);
+
+    auto img = ImageData::ImportImage(encoded, unorm);
+
+    // Already compressed or otherwise not decoded by stb:
+    if (img.Format != VK_FORMAT_R8G8B8A8_UNORM && img.Format != VK_FORMAT_R8G8B8A8_SRGB)
+        return img;
+
+    img.GenerateMips(pool);
+
+    std::vector<Level> levels;
+
+    for (size_t lvl = 0; lvl < img.NumMips; lvl++)
+    {
+        const uint32_t width  = std::max(img.Width >> lvl, 1u);
+        const uint32_t height = std::max(img.Height >> lvl, 1u);
+
+        auto *pixels = static_cast<const uint8_t *>(img.Data) + img.MipOffsets[lvl];
+
+        levels.push_back(Level{
+            .Width  = width,
+            .Height = height,
+            .Pixels = std::span(reinterpret_cast<const Pixel *>(pixels), width * height),
+        });
+    }
+
+    auto encoding = ChooseEncoding(levels.front(), usage, unorm);
+
+    std::vector<std::vector<uint8_t>> data;
+
+    for (const auto &level : levels)
+        data.push_back(CompressLevel(level, encoding, pool));
+
+    auto ktx = WriteKtx2(levels, data, encoding);
+
+    StoreCached(cachePath, ktx);
+
+    return ImageData::ImportImage(ktx, unorm);
+}
+
+ImageData TextureCompressor::Import(const char *path, TextureUsage usage, bool unorm,
+                                    ThreadPool &pool)
+{
+    std::filesystem::path pathObj(path);
+
+    const auto ext = pathObj.extension().string();
+
+    if (ext == ".ktx" || ext == ".ktx2")
+        return ImageData::ImportImage(path, unorm);
+
+    MappedFile file(pathObj);
+
+    if (!file.IsValid())
+    {
+        std::cerr << "Failed to load texture image. Filepath: " << path << '\n';
+        return ImageData::SinglePixel(PlaceholderPixel(usage), unorm);
+    }
+
+    return Import(file.Bytes(), usage, unorm, pool);
+}
@@ -0,0 +1,23 @@
+#pragma once
+
+#include "ImageData.h"
+
+#include <cstdint>
+#include <span>
+
+class ThreadPool;
+
+// Import-time block compression of material textures. Color is compressed
+// to BC7, normal maps to BC5 (z is reconstructed in the shader) and
+// roughness/metallic to BC5, or BC4 when metallic is constant. Levels are
+// compressed in parallel on the thread pool together with a full mip chain.
+// Results are cached on disk as ktx2 files keyed by the hash of the encoded
+// source, so the compression cost is only paid once.
+namespace TextureCompressor
+{
+// Decodes and compresses an encoded image (anything stb_image handles).
+// Images that are already in ktx containers are returned as they are:
+ImageData Import(std::span<const uint8_t> encoded, TextureUsage usage, bool unorm,
+                 ThreadPool &pool);
+ImageData Import(const char *path, TextureUsage usage, bool unorm, ThreadPool &pool);
+} // namespace TextureCompressor
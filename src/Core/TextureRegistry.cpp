@@ -0,0 +1,81 @@
+#include "TextureRegistry.h"
+#include "Pch.h"
+
+#include "Vassert.h"
+
+#include <cstring>
+
+TextureRegistry::TextureRegistry(Scene &scene) : mScene(scene)
+{
+}
+
+TextureRegistry::Handle TextureRegistry::Acquire(
+    const std::optional<std::filesystem::path> &path, Pixel pixel, bool unorm,
+    TextureUsage usage, bool compress)
+{
+    Source src{
+        .Path       = "",
+        .PixelValue = 0,
+        .Unorm      = unorm,
+        .Usage      = usage,
+        .Compress   = compress,
+    };
+
+    if (path)
+    {
+        // Different relative paths may lead to the same file:
+        std::error_code ec;
+        auto            canonical = std::filesystem::weakly_canonical(*path, ec);
+
+        src.Path = ec ? path->generic_string() : canonical.generic_string();
+    }
+    else
+        std::memcpy(&src.PixelValue, &pixel, sizeof(pixel));
+
+    std::lock_guard lock(mMutex);
+
+    if (auto it = mKeys.find(src); it != mKeys.end())
+    {
+        mEntries.at(it->second).RefCount++;
+        return Handle{.Key = it->second, .IsNew = false};
+    }
+
+    auto [key, _] = mScene.EmplaceImage();
+
+    mKeys[src]    = key;
+    mEntries[key] = Entry{.Src = src, .RefCount = 1};
+
+    return Handle{.Key = key, .IsNew = true};
+}
+
+bool TextureRegistry::Release(SceneKey key)
+{
+    std::lock_guard lock(mMutex);
+
+    auto it = mEntries.find(key);
+
+    // Not tracked (anymore), nobody else can be using it:
+    if (it == mEntries.end())
+        return true;
+
+    vassert(it->second.RefCount > 0);
+
+    if (--it->second.RefCount > 0)
+        return false;
+
+    mKeys.erase(it->second.Src);
+    mEntries.erase(it);
+
+    return true;
+}
+
+void TextureRegistry::Forget(SceneKey key)
+{
+    std::lock_guard lock(mMutex);
+
+    if (auto it = mEntries.find(key); it != mEntries.end())
+    {
+        mKeys.erase(it->second.Src);
+        mEntries.erase(it);
+    }
+}
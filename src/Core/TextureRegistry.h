@@ -0,0 +1,66 @@
+#pragma once
+
+#include "ImageData.h"
+#include "Scene.h"
+
+#include <compare>
+#include <filesystem>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+
+// Shares scene images between all materials (also across models) that
+// reference the same source - resolved file path, or the pixel value of
+// generated single-pixel images - and decode it the same way. Images are
+// reference counted, so that they are only removed from the scene with
+// their last user.
+// Safe to use from multiple loading threads.
+class TextureRegistry {
+  public:
+    struct Handle {
+        SceneKey Key;
+        // First reference - the image was just emplaced
+        // and the caller is responsible for decoding it:
+        bool IsNew;
+    };
+
+  public:
+    TextureRegistry(Scene &scene);
+
+    // Usage and compression are part of the key, as they decide the format.
+    // New images are emplaced with the registry locked, so the scene
+    // lock must not be held when calling any of these:
+    Handle Acquire(const std::optional<std::filesystem::path> &path, Pixel pixel,
+                   bool unorm, TextureUsage usage, bool compress);
+
+    // Returns true if this was the last reference,
+    // in which case the image should be erased from the scene:
+    bool Release(SceneKey key);
+
+    // Drops the entry of an image erased from the scene by other means:
+    void Forget(SceneKey key);
+
+  private:
+    struct Source {
+        std::string  Path;
+        uint32_t     PixelValue;
+        bool         Unorm;
+        TextureUsage Usage;
+        bool         Compress;
+
+        auto operator<=>(const Source &) const = default;
+    };
+
+    struct Entry {
+        Source   Src;
+        uint32_t RefCount;
+    };
+
+    Scene &mScene;
+
+    std::map<Source, SceneKey> mKeys;
+    std::map<SceneKey, Entry>  mEntries;
+
+    std::mutex mMutex;
+};
@@ -0,0 +1,220 @@
+#include "TransformHierarchy.h"
+#include "Pch.h"
+
+#include "SceneGraph.h"
+#include "ThreadPool.h"
+
+#include <glm/gtc/quaternion.hpp>
+
+#include <algorithm>
+
+void TransformHierarchy::Rebuild(SceneGraphNode &root)
+{
+    mNodes.clear();
+    mParents.clear();
+    mSubtreeSizes.clear();
+    mObjects.clear();
+    mTranslations.clear();
+    mRotations.clear();
+    mScales.clear();
+
+    Append(root, NoParent);
+
+    const size_t count = mNodes.size();
+
+    mLocals.resize(count);
+    mWorlds.resize(count);
+
+    // Everything is recomputed starting from the root:
+    mDirty.assign(count, 1);
+    mDirtyNodes.resize(count);
+
+    for (size_t i = 0; i < count; i++)
+        mDirtyNodes[i] = static_cast<uint32_t>(i);
+}
+
+void TransformHierarchy::Append(SceneGraphNode &node, uint32_t parent)
+{
+    const auto idx = static_cast<uint32_t>(mNodes.size());
+
+    node.mHierarchyIndex = idx;
+
+    mNodes.push_back(&node);
+    mParents.push_back(parent);
+    mSubtreeSizes.push_back(1);
+    mObjects.push_back(node.IsLeaf() ? node.GetObjectKey() : NoObject);
+    mTranslations.push_back(node.Translation);
+    mRotations.push_back(node.Rotation);
+    mScales.push_back(node.Scale);
+
+    if (!node.IsLeaf())
+    {
+        for (auto &child : node.GetChildren())
+            Append(*child, idx);
+    }
+
+    mSubtreeSizes[idx] = static_cast<uint32_t>(mNodes.size()) - idx;
+}
+
+bool TransformHierarchy::MarkDirty(const SceneGraphNode &node)
+{
+    const uint32_t idx = node.mHierarchyIndex;
+
+    if (idx >= mNodes.size() || mNodes[idx] != &node)
+        return false;
+
+    mTranslations[idx] = node.Translation;
+    mRotations[idx]    = node.Rotation;
+    mScales[idx]       = node.Scale;
+
+    if (!mDirty[idx])
+    {
+        mDirty[idx] = 1;
+        mDirtyNodes.push_back(idx);
+    }
+
+    return true;
+}
+
+bool TransformHierarchy::Update(Scene &scene, ThreadPool *pool)
+{
+    if (mDirtyNodes.empty())
+        return false;
+
+    for (const uint32_t idx : mDirtyNodes)
+    {
+        mLocals[idx] = Compose(mTranslations[idx], mRotations[idx], mScales[idx]);
+        mDirty[idx]  = 0;
+    }
+
+    // Subtrees nested in other dirty ones are covered by their range:
+    std::ranges::sort(mDirtyNodes);
+
+    uint32_t coveredEnd = 0;
+
+    for (const uint32_t idx : mDirtyNodes)
+    {
+        if (idx < coveredEnd)
+            continue;
+
+        coveredEnd = idx + mSubtreeSizes[idx];
+
+        UpdateSubtree(scene, idx, pool);
+
+        for (uint32_t i = idx; i < coveredEnd; i++)
+        {
+            if (mObjects[i] != NoObject)
+                scene.MarkObjectModified(mObjects[i]);
+        }
+    }
+
+    mDirtyNodes.clear();
+
+    return true;
+}
+
+const glm::mat4 *TransformHierarchy::FindWorld(const SceneGraphNode &node) const
+{
+    const uint32_t idx = node.mHierarchyIndex;
+
+    if (idx >= mNodes.size() || mNodes[idx] != &node)
+        return nullptr;
+
+    return &mWorlds[idx];
+}
+
+size_t TransformHierarchy::Size() const
+{
+    return mNodes.size();
+}
+
+glm::mat4 TransformHierarchy::Compose(const glm::vec3 &translation,
+                                      const glm::vec3 &rotation, const glm::vec3 &scale)
+{
+    // Scaling the rotation columns avoids two full matrix products:
+    const glm::mat3 rot = glm::mat3_cast(glm::quat(rotation));
+
+    return glm::mat4(glm::vec4(rot[0] * scale.x, 0.0f), glm::vec4(rot[1] * scale.y, 0.0f),
+                     glm::vec4(rot[2] * scale.z, 0.0f), glm::vec4(translation, 1.0f));
+}
+
+void TransformHierarchy::UpdateRange(Scene &scene, uint32_t first, uint32_t last)
+{
+    for (uint32_t i = first; i < last; i++)
+    {
+        const uint32_t parent = mParents[i];
+
+        if (parent == NoParent)
+            mWorlds[i] = mLocals[i];
+        else
+            mWorlds[i] = mWorlds[parent] * mLocals[i];
+    }
+
+    for (uint32_t i = first; i < last; i++)
+    {
+        if (mObjects[i] != NoObject)
+            scene.Objects[mObjects[i]].Transform = mWorlds[i];
+    }
+}
+
+void TransformHierarchy::UpdateSubtree(Scene &scene, uint32_t root, ThreadPool *pool)
+{
+    const uint32_t subtreeEnd = root + mSubtreeSizes[root];
+
+    if (pool == nullptr || subtreeEnd - root <= GrainSize)
+    {
+        UpdateRange(scene, root, subtreeEnd);
+        return;
+    }
+
+    // Children of a computed node are independent of each other, so runs of
+    // sibling subtrees make up the parallel ranges. Roots of subtrees too
+    // large for a single range are computed first and split further:
+    mRanges.clear();
+
+    std::vector<uint32_t> splitNodes{root};
+
+    while (!splitNodes.empty())
+    {
+        const uint32_t node = splitNodes.back();
+        splitNodes.pop_back();
+
+        UpdateRange(scene, node, node + 1);
+
+        const uint32_t end = node + mSubtreeSizes[node];
+
+        Range range{.First = node + 1, .Last = node + 1};
+
+        for (uint32_t child = node + 1; child < end; child += mSubtreeSizes[child])
+        {
+            const uint32_t childEnd = child + mSubtreeSizes[child];
+
+            if (childEnd - child > GrainSize)
+            {
+                splitNodes.push_back(child);
+
+                if (range.Last > range.First)
+                    mRanges.push_back(range);
+
+                range = Range{.First = childEnd, .Last = childEnd};
+                continue;
+            }
+
+            range.Last = childEnd;
+
+            if (range.Last - range.First >= GrainSize)
+            {
+                mRanges.push_back(range);
+                range = Range{.First = childEnd, .Last = childEnd};
+            }
+        }
+
+        if (range.Last > range.First)
+            mRanges.push_back(range);
+    }
+
+    pool->ParallelFor(mRanges.size(), 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            UpdateRange(scene, mRanges[i].First, mRanges[i].Last);
+    });
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "Scene.h"
+
+#include <glm/glm.hpp>
+
+#include <cstdint>
+#include <vector>
+
+class SceneGraphNode;
+class ThreadPool;
+
+// Flattened copy of the scene graph, used to propagate transforms.
+// Nodes are stored in depth-first order, so each parent precedes its
+// children and a subtree occupies the contiguous range [i, i + size).
+// Recomputing a subtree is then a linear pass, where world matrix of
+// every node only depends on the already computed one of its parent.
+// The graph nodes stay the authoring side: their local transforms are
+// copied over when marked dirty, and world matrices are written to the
+// objects of the leaves on update.
+class TransformHierarchy {
+  public:
+    // Flattens the tree, all of it is recomputed on next update.
+    // Has to be called after each structural change of the graph:
+    void Rebuild(SceneGraphNode &root);
+
+    // Copies local transform of the node, its subtree is recomputed
+    // on next update. Returns false if the node is not part of the
+    // hierarchy, meaning the structure changed since last rebuild:
+    bool MarkDirty(const SceneGraphNode &node);
+
+    // Recomputes world matrices of the dirty subtrees and stores them in the
+    // leaf objects, which are marked as modified in the scene. With a pool,
+    // large subtrees are split into independent ranges of siblings.
+    // Returns true if anything was recomputed:
+    bool Update(Scene &scene, ThreadPool *pool = nullptr);
+
+    // Null if the node is not part of the hierarchy:
+    [[nodiscard]] const glm::mat4 *FindWorld(const SceneGraphNode &node) const;
+
+    [[nodiscard]] size_t Size() const;
+
+    // Same as translation * rotation * scale matrices multiplied
+    // together, with rotation given as euler angles:
+    static glm::mat4 Compose(const glm::vec3 &translation, const glm::vec3 &rotation,
+                             const glm::vec3 &scale);
+
+  private:
+    void Append(SceneGraphNode &node, uint32_t parent);
+
+    // Parents of the nodes in range are either in it, or already computed:
+    void UpdateRange(Scene &scene, uint32_t first, uint32_t last);
+
+    void UpdateSubtree(Scene &scene, uint32_t root, ThreadPool *pool);
+
+  private:
+    static constexpr uint32_t NoParent = UINT32_MAX;
+    // Valid keys are never 0, so it marks nodes without an object:
+    static constexpr SceneKey NoObject = 0;
+
+    // Nodes per range processed by a single worker:
+    static constexpr uint32_t GrainSize = 4096;
+
+    std::vector<const SceneGraphNode *> mNodes;
+    std::vector<uint32_t>               mParents;
+    std::vector<uint32_t>               mSubtreeSizes;
+    std::vector<SceneKey>               mObjects;
+
+    std::vector<glm::vec3> mTranslations;
+    std::vector<glm::vec3> mRotations;
+    std::vector<glm::vec3> mScales;
+
+    std::vector<glm::mat4> mLocals;
+    std::vector<glm::mat4> mWorlds;
+
+    // Nodes whose local transform changed since last update:
+    std::vector<uint8_t>  mDirty;
+    std::vector<uint32_t> mDirtyNodes;
+
+    // Ranges of siblings processed in parallel, kept to avoid reallocations:
+    struct Range {
+        uint32_t First;
+        uint32_t Last;
+    };
+
+    std::vector<Range> mRanges;
+};
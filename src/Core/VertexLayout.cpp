@@ -41,21 +41,7 @@ uint32_t Vertex::GetSize(const Vertex::Layout &vLayout)
 {
     if (auto *layout = std::get_if<PushLayout>(&vLayout))
     {
-        uint32_t res = 3 * sizeof(float);
-
-        if (layout->HasTexCoord)
-            res += 2 * sizeof(float);
-
-        if (layout->HasNormal)
-            res += 3 * sizeof(float);
-
-        if (layout->HasTangent)
-            res += 4 * sizeof(float);
-
-        if (layout->HasColor)
-            res += 4 * sizeof(float);
-
-        return res;
+        return GetPushOffsets(*layout).Stride * sizeof(float);
     }
 
     else if (auto *layout = std::get_if<PullLayout>(&vLayout))
@@ -75,44 +61,21 @@ uint32_t Vertex::GetSize(const Vertex::Layout &vLayout)
 Vertex::AttributeDescriptions Vertex::GetAttributeDescriptions(const PushLayout &layout)
 {
     AttributeDescriptions res;
-    uint32_t              offset = 0;
-
-    auto NewDescription = [&res, &offset](VkFormat format) {
-        return VkVertexInputAttributeDescription{
-            .location = static_cast<uint32_t>(res.size()),
-            .binding  = 0,
-            .format   = format,
-            .offset   = offset,
-        };
-    };
-
-    // Add position:
-    res.push_back(NewDescription(VK_FORMAT_R32G32B32_SFLOAT));
-    offset += 3 * sizeof(float);
 
-    // Conditionally add other attributes:
-    if (layout.HasTexCoord)
-    {
-        res.push_back(NewDescription(VK_FORMAT_R32G32_SFLOAT));
-        offset += 2 * sizeof(float);
-    }
+    const auto offsets = GetPushOffsets(layout);
 
-    if (layout.HasNormal)
+    // Locations are consecutive, skipping attributes missing from the layout:
+    for (uint32_t i = 0; i < PushAttributeCount; i++)
     {
-        res.push_back(NewDescription(VK_FORMAT_R32G32B32_SFLOAT));
-        offset += 3 * sizeof(float);
-    }
+        if (!HasAttribute(layout, static_cast<PushAttribute>(i)))
+            continue;
 
-    if (layout.HasTangent)
-    {
-        res.push_back(NewDescription(VK_FORMAT_R32G32B32A32_SFLOAT));
-        offset += 4 * sizeof(float);
-    }
-
-    if (layout.HasColor)
-    {
-        res.push_back(NewDescription(VK_FORMAT_R32G32B32A32_SFLOAT));
-        offset += 4 * sizeof(float);
+        res.push_back(VkVertexInputAttributeDescription{
+            .location = static_cast<uint32_t>(res.size()),
+            .binding  = 0,
+            .format   = PushAttributes[i].Format,
+            .offset   = static_cast<uint32_t>(offsets.Offsets[i] * sizeof(float)),
+        });
     }
 
     return res;
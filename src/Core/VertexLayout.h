@@ -3,6 +3,7 @@
 #include "volk.h"
 #include <glm/glm.hpp>
 
+#include <array>
 #include <variant>
 #include <vector>
 
@@ -20,6 +21,99 @@ struct PushLayout {
     bool HasColor    = false;
 };
 
+// Attributes of push layouts, in the order they are stored in:
+enum class PushAttribute : uint32_t
+{
+    Position,
+    TexCoord,
+    Normal,
+    Tangent,
+    Color,
+};
+
+inline constexpr uint32_t PushAttributeCount = 5;
+
+struct PushAttributeInfo {
+    uint32_t Components;
+    VkFormat Format;
+};
+
+inline constexpr std::array<PushAttributeInfo, PushAttributeCount> PushAttributes{{
+    {3, VK_FORMAT_R32G32B32_SFLOAT},
+    {2, VK_FORMAT_R32G32_SFLOAT},
+    {3, VK_FORMAT_R32G32B32_SFLOAT},
+    {4, VK_FORMAT_R32G32B32A32_SFLOAT},
+    {4, VK_FORMAT_R32G32B32A32_SFLOAT},
+}};
+
+constexpr bool HasAttribute(const PushLayout &layout, PushAttribute attrib)
+{
+    switch (attrib)
+    {
+    case PushAttribute::Position:
+        return true;
+    case PushAttribute::TexCoord:
+        return layout.HasTexCoord;
+    case PushAttribute::Normal:
+        return layout.HasNormal;
+    case PushAttribute::Tangent:
+        return layout.HasTangent;
+    case PushAttribute::Color:
+        return layout.HasColor;
+    }
+
+    return false;
+}
+
+// Placement of attributes within a push vertex, in floats. Attributes missing
+// from the layout get the offset they would have, but take no space. Shared
+// by the vertex encoders and the pipeline input descriptions, so they can't
+// disagree on the layout:
+struct PushOffsets {
+    std::array<uint32_t, PushAttributeCount> Offsets;
+    uint32_t                                 Stride;
+
+    [[nodiscard]] constexpr uint32_t operator[](PushAttribute attrib) const
+    {
+        return Offsets[static_cast<uint32_t>(attrib)];
+    }
+};
+
+constexpr PushOffsets GetPushOffsets(const PushLayout &layout)
+{
+    PushOffsets res{};
+
+    for (uint32_t i = 0; i < PushAttributeCount; i++)
+    {
+        res.Offsets[i] = res.Stride;
+
+        if (HasAttribute(layout, static_cast<PushAttribute>(i)))
+            res.Stride += PushAttributes[i].Components;
+    }
+
+    return res;
+}
+
+// Every combination of the optional attributes has an id,
+// so that code can be specialized for each of them:
+inline constexpr uint32_t PushLayoutCount = 16;
+
+constexpr uint32_t GetPushLayoutId(const PushLayout &layout)
+{
+    return (layout.HasTexCoord ? 1u : 0u) | (layout.HasNormal ? 2u : 0u) |
+           (layout.HasTangent ? 4u : 0u) | (layout.HasColor ? 8u : 0u);
+}
+
+constexpr PushLayout GetPushLayout(uint32_t id)
+{
+    return PushLayout{
+        .HasTexCoord = (id & 1u) != 0,
+        .HasNormal   = (id & 2u) != 0,
+        .HasTangent  = (id & 4u) != 0,
+        .HasColor    = (id & 8u) != 0,
+    };
+}
+
 // Enum defining supported vertex types to be used with
 // programmatic vertex pulling:
 enum class PullLayout
@@ -1,63 +1,88 @@
 #include "VertexPacking.h"
 #include "Pch.h"
 
+#include "Float8.h"
+#include "ThreadPool.h"
 #include "Vassert.h"
 #include "VertexLayout.h"
 
 #include "glm/vector_relational.hpp"
 
-#include <cstring>
+#include <numbers>
+#include <utility>
 
-struct PushVertexOffsets {
-    uint32_t                  ComponentStride;
-    static constexpr uint32_t OffsetPos      = 0;
-    static constexpr uint32_t OffsetTexCoord = 3;
-    uint32_t                  OffsetNormal;
-    uint32_t                  OffsetTangent;
-    uint32_t                  OffsetColor;
-};
-
-static PushVertexOffsets GetOffsets(const Vertex::PushLayout &layout)
+// Encodes a vertex range in the push layout with given id. Offsets and
+// stride are compile time constants, so each combination of attributes
+// gets its own unrolled loop:
+template <uint32_t LayoutId>
+static void EncodePush(const PrimitiveData &prim, float *data, size_t begin, size_t end)
 {
-    uint32_t stride        = 3;
-    uint32_t offsetNormal  = 3;
-    uint32_t offsetTangent = 3;
-    uint32_t offsetColor   = 3;
+    using enum Vertex::PushAttribute;
 
-    if (layout.HasTexCoord)
-    {
-        stride += 2;
-        offsetNormal += 2;
-        offsetTangent += 2;
-        offsetColor += 2;
-    }
+    static constexpr auto layout  = Vertex::GetPushLayout(LayoutId);
+    static constexpr auto offsets = Vertex::GetPushOffsets(layout);
 
-    if (layout.HasNormal)
+    for (size_t vertIdx = begin; vertIdx < end; vertIdx++)
     {
-        stride += 3;
-        offsetTangent += 3;
-        offsetColor += 3;
-    }
+        float *dst = data + offsets.Stride * vertIdx;
 
-    if (layout.HasTangent)
-    {
-        stride += 4;
-        offsetColor += 4;
-    }
+        const auto &pos = prim.Positions[vertIdx];
 
-    if (layout.HasColor)
-    {
-        stride += 4;
+        dst[offsets[Position] + 0] = pos.x;
+        dst[offsets[Position] + 1] = pos.y;
+        dst[offsets[Position] + 2] = pos.z;
+
+        if constexpr (layout.HasTexCoord)
+        {
+            const auto &texcoord = prim.TexCoords[vertIdx];
+
+            dst[offsets[TexCoord] + 0] = texcoord.x;
+            dst[offsets[TexCoord] + 1] = texcoord.y;
+        }
+
+        if constexpr (layout.HasNormal)
+        {
+            const auto &normal = prim.Normals[vertIdx];
+
+            dst[offsets[Normal] + 0] = normal.x;
+            dst[offsets[Normal] + 1] = normal.y;
+            dst[offsets[Normal] + 2] = normal.z;
+        }
+
+        if constexpr (layout.HasTangent)
+        {
+            const auto &tangent = prim.Tangents[vertIdx];
+
+            dst[offsets[Tangent] + 0] = tangent.x;
+            dst[offsets[Tangent] + 1] = tangent.y;
+            dst[offsets[Tangent] + 2] = tangent.z;
+            dst[offsets[Tangent] + 3] = tangent.w;
+        }
+
+        if constexpr (layout.HasColor)
+        {
+            const auto &color = prim.Colors[vertIdx];
+
+            dst[offsets[Color] + 0] = color.x;
+            dst[offsets[Color] + 1] = color.y;
+            dst[offsets[Color] + 2] = color.z;
+            dst[offsets[Color] + 3] = color.w;
+        }
     }
+}
 
-    return PushVertexOffsets{
-        .ComponentStride = stride,
-        .OffsetNormal    = offsetNormal,
-        .OffsetTangent   = offsetTangent,
-        .OffsetColor     = offsetColor,
-    };
+using PushEncoder = void (*)(const PrimitiveData &, float *, size_t, size_t);
+
+template <uint32_t... Ids>
+static constexpr auto MakePushEncoders(std::integer_sequence<uint32_t, Ids...>)
+{
+    return std::array<PushEncoder, sizeof...(Ids)>{&EncodePush<Ids>...};
 }
 
+// Indexed by Vertex::GetPushLayoutId:
+static constexpr auto PushEncoders =
+    MakePushEncoders(std::make_integer_sequence<uint32_t, Vertex::PushLayoutCount>{});
+
 template <std::unsigned_integral T>
 static uint16_t QuantizeNormalized(float value)
 {
@@ -181,74 +206,367 @@ static uint16_t PackUint8sToUint16(uint8_t high, uint8_t low)
     return (high << 8) | low;
 }
 
-GeometryData VertexPacking::Encode(PrimitiveData &prim, Vertex::Layout vLayout)
+Vertex::PullCompressed VertexPacking::CompressVertex(glm::vec3 pos, glm::vec2 texcoord,
+                                                     glm::vec3 normal, glm::vec4 tangent,
+                                                     const AABB          &bbox,
+                                                     const TextureBounds &texBounds)
+{
+    // Normalize position to [0,1]^3:
+    // TODO: Think if there is a better way to prevent division by zero:
+    pos = pos - bbox.Center;
+    pos = pos / (bbox.Extent + 0.001f);
+    pos = 0.5f * pos + 0.5f;
+
+    // Normalize texcoords to [0,1]^2:
+    texcoord = texcoord - texBounds.Center;
+    texcoord = texcoord / (texBounds.Extent);
+    texcoord = 0.5f * texcoord + 0.5f;
+
+    // Make sure normal and tangent are not ill-defined:
+    // TODO: This should be already caught by logic in the importer,
+    // not sure how this keeps slipping through...
+    glm::vec3 tan3{tangent};
+
+    if (glm::length(normal) < 1e-6)
+        normal = glm::vec3(0, -1, 0);
+
+    if (glm::length(tan3) < 1e-6)
+        tan3 = glm::vec3(1, 0, 0);
+
+    // Compress normal  with octahedral mapping,
+    // encode tangent with Rodriguez angle:
+    glm::vec2 normal2 = OctahedralMap(normal);
+    float tanAngle    = RodriguezAngleNormalized(normal, tan3);
+
+    // Do clamp to catch small numerical inaccuracies:
+    pos      = glm::clamp(pos, 0.0f, 1.0f);
+    texcoord = glm::clamp(texcoord, 0.0f, 1.0f);
+    normal2  = glm::clamp(normal2, 0.0f, 1.0f);
+    tanAngle = glm::clamp(tanAngle, 0.0f, 1.0f);
+
+    // Sanity check - is everything normalized?
+    vassert(IsNormalized(pos));
+    vassert(IsNormalized(texcoord));
+    vassert(IsNormalized(normal2));
+    vassert(IsNormalized(tanAngle));
+
+    // Quantize to uint16/uint8 and store:
+    auto qPos      = QuantizeVec3<uint16_t>(pos);
+    auto qTexCoord = QuantizeVec2<uint16_t>(texcoord);
+
+    auto normalU8 = QuantizeVec2<uint8_t>(normal2);
+    auto qNormal = PackUint8sToUint16(normalU8[0], normalU8[1]);
+
+    auto tangentU8 = QuantizeNormalized<uint8_t>(tanAngle);
+    auto signU8    = static_cast<uint16_t>(tangent.w > 0.0f);
+
+    auto qTangent = PackUint8sToUint16(tangentU8, signU8);
+
+    return Vertex::PullCompressed{
+        .Pos      = qPos,
+        .TexCoord = qTexCoord,
+        .Normal   = qNormal,
+        .Tangent  = qTangent,
+    };
+}
+
+// Inputs of a batch, one float array per component:
+struct CompressLanes {
+    alignas(32) std::array<float, Float8::Width> Px, Py, Pz;
+    alignas(32) std::array<float, Float8::Width> U, V;
+    alignas(32) std::array<float, Float8::Width> Nx, Ny, Nz;
+    alignas(32) std::array<float, Float8::Width> Tx, Ty, Tz, Tw;
+};
+
+// Quantizes values in [0,1] to [0, maximum], truncating like QuantizeNormalized:
+static std::array<int32_t, Float8::Width> Quantize(Float8 v, float maximum)
+{
+    std::array<int32_t, Float8::Width> res;
+
+    (Clamp(v, 0.0f, 1.0f) * Float8::Splat(maximum)).StoreInt(res.data());
+
+    return res;
+}
+
+// Polynomial atan2 (range reduction by tan(pi/8) as in cephes atanf), within a
+// few ulp of std::atan2. Returns angles in (-pi, pi], like std::atan2:
+static Float8 Atan2(Float8 y, Float8 x)
+{
+    const auto zero = Float8::Splat(0.0f);
+    const auto one  = Float8::Splat(1.0f);
+
+    const auto ax = Abs(x);
+    const auto ay = Abs(y);
+
+    const auto hi = Max(ax, ay);
+    const auto lo = Min(ax, ay);
+
+    // Ratio in [0,1], zero vectors give zero:
+    auto t = Select(hi > zero, lo / hi, zero);
+
+    // Reduce to [-tan(pi/8), tan(pi/8)]:
+    const auto reduce = t > Float8::Splat(0.41421356f);
+
+    t = Select(reduce, (t - one) / (t + one), t);
+
+    const auto z = t * t;
+
+    auto poly = Float8::Splat(8.05374449538e-2f);
+    poly      = poly * z - Float8::Splat(1.38776856032e-1f);
+    poly      = poly * z + Float8::Splat(1.99777106478e-1f);
+    poly      = poly * z - Float8::Splat(3.33329491539e-1f);
+
+    constexpr float pi = std::numbers::pi_v<float>;
+
+    auto res = poly * z * t + t;
+    res      = res + Select(reduce, Float8::Splat(0.25f * pi), zero);
+
+    // Undo the octant folding:
+    res = Select(ay > ax, Float8::Splat(0.5f * pi) - res, res);
+    res = Select(x < zero, Float8::Splat(pi) - res, res);
+    res = Select(y < zero, zero - res, res);
+
+    return res;
+}
+
+static void CompressBatch(const CompressLanes &in, const AABB &bbox,
+                          const TextureBounds &texBounds, size_t count,
+                          Vertex::PullCompressed *out)
+{
+    const auto zero = Float8::Splat(0.0f);
+    const auto half = Float8::Splat(0.5f);
+    const auto one  = Float8::Splat(1.0f);
+
+    // Normalize positions and texcoords to [0,1], same as CompressVertex:
+    auto NormalizeCoord = [&](const auto &lane, float center, float extent) {
+        auto v = Float8::Load(lane.data()) - Float8::Splat(center);
+        return half * (v / Float8::Splat(extent)) + half;
+    };
+
+    const auto px = NormalizeCoord(in.Px, bbox.Center.x, bbox.Extent.x + 0.001f);
+    const auto py = NormalizeCoord(in.Py, bbox.Center.y, bbox.Extent.y + 0.001f);
+    const auto pz = NormalizeCoord(in.Pz, bbox.Center.z, bbox.Extent.z + 0.001f);
+
+    const auto u = NormalizeCoord(in.U, texBounds.Center.x, texBounds.Extent.x);
+    const auto v = NormalizeCoord(in.V, texBounds.Center.y, texBounds.Extent.y);
+
+    // Degenerate normals and tangents get the same defaults as in CompressVertex:
+    const auto eps2 = Float8::Splat(1e-12f);
+
+    auto nx = Float8::Load(in.Nx.data());
+    auto ny = Float8::Load(in.Ny.data());
+    auto nz = Float8::Load(in.Nz.data());
+
+    const auto badNormal = nx * nx + ny * ny + nz * nz < eps2;
+
+    nx = Select(badNormal, zero, nx);
+    ny = Select(badNormal, Float8::Splat(-1.0f), ny);
+    nz = Select(badNormal, zero, nz);
+
+    auto tx = Float8::Load(in.Tx.data());
+    auto ty = Float8::Load(in.Ty.data());
+    auto tz = Float8::Load(in.Tz.data());
+
+    const auto badTangent = tx * tx + ty * ty + tz * tz < eps2;
+
+    tx = Select(badTangent, one, tx);
+    ty = Select(badTangent, zero, ty);
+    tz = Select(badTangent, zero, tz);
+
+    // Octahedral map. Division by the L1 norm makes the normalization
+    // done by OctahedralMap unnecessary:
+    const auto l1 = Abs(nx) + Abs(ny) + Abs(nz);
+
+    auto ox = nx / l1;
+    auto oy = ny / l1;
+
+    const auto sgnX = Select(ox > zero, one, Float8::Splat(-1.0f));
+    const auto sgnY = Select(oy > zero, one, Float8::Splat(-1.0f));
+
+    const auto below = nz < zero;
+
+    const auto wx = sgnX * (one - Abs(oy));
+    const auto wy = sgnY * (one - Abs(ox));
+
+    ox = half * Select(below, wx, ox) + half;
+    oy = half * Select(below, wy, oy) + half;
+
+    // Rodriguez angle, reference tangent is cross(n, x) or cross(n, z):
+    const auto nearZ = Abs(nz) > Abs(nx);
+
+    const auto rx = Select(nearZ, zero, ny);
+    const auto ry = Select(nearZ, nz, zero - nx);
+    const auto rz = Select(nearZ, zero - ny, zero);
+
+    const auto qx = ny * rz - nz * ry;
+    const auto qy = nz * rx - nx * rz;
+    const auto qz = nx * ry - ny * rx;
+
+    const auto alongRef  = rx * tx + ry * ty + rz * tz;
+    const auto alongPerp = qx * tx + qy * ty + qz * tz;
+
+    constexpr float twoPi = 2.0f * std::numbers::pi_v<float>;
+
+    auto angle = Atan2(alongPerp, alongRef);
+    angle      = Select(angle <= zero, angle + Float8::Splat(twoPi), angle);
+    angle      = angle * Float8::Splat(1.0f / twoPi);
+
+    const auto qPx = Quantize(px, std::numeric_limits<uint16_t>::max());
+    const auto qPy = Quantize(py, std::numeric_limits<uint16_t>::max());
+    const auto qPz = Quantize(pz, std::numeric_limits<uint16_t>::max());
+    const auto qU  = Quantize(u, std::numeric_limits<uint16_t>::max());
+    const auto qV  = Quantize(v, std::numeric_limits<uint16_t>::max());
+    const auto qOx = Quantize(ox, std::numeric_limits<uint8_t>::max());
+    const auto qOy = Quantize(oy, std::numeric_limits<uint8_t>::max());
+    const auto qTa = Quantize(angle, std::numeric_limits<uint8_t>::max());
+
+    for (size_t i = 0; i < count; i++)
+    {
+        const auto sign = static_cast<uint8_t>(in.Tw[i] > 0.0f);
+
+        out[i] = Vertex::PullCompressed{
+            .Pos =
+                {
+                    static_cast<uint16_t>(qPx[i]),
+                    static_cast<uint16_t>(qPy[i]),
+                    static_cast<uint16_t>(qPz[i]),
+                },
+            .TexCoord =
+                {
+                    static_cast<uint16_t>(qU[i]),
+                    static_cast<uint16_t>(qV[i]),
+                },
+            .Normal  = PackUint8sToUint16(static_cast<uint8_t>(qOx[i]),
+                                          static_cast<uint8_t>(qOy[i])),
+            .Tangent = PackUint8sToUint16(static_cast<uint8_t>(qTa[i]), sign),
+        };
+    }
+}
+
+// Checks done by CompressVertex per vertex, kept out of the batch kernel:
+static void ValidateCompressInput(std::span<const glm::vec3> normals)
+{
+    for (const auto &normal : normals)
+    {
+        const float len = glm::length(normal);
+
+        if (len >= 1e-6f && std::abs(len - 1.0f) > 0.01f)
+        {
+            auto message =
+                std::format("Provided vector should be normalized! Instead got: {} {} {}",
+                            normal.x, normal.y, normal.z);
+            vpanic(message);
+        }
+    }
+}
+
+void VertexPacking::CompressVertices(std::span<const glm::vec3> positions,
+                                     std::span<const glm::vec2> texcoords,
+                                     std::span<const glm::vec3> normals,
+                                     std::span<const glm::vec4> tangents,
+                                     const AABB &bbox, const TextureBounds &texBounds,
+                                     std::span<Vertex::PullCompressed> out)
+{
+    const size_t count = out.size();
+
+    vassert(positions.size() == count && texcoords.size() == count &&
+                normals.size() == count && tangents.size() == count,
+            "Attribute counts don't match the output!");
+
+#ifndef NDEBUG
+    ValidateCompressInput(normals);
+#endif
+
+    CompressLanes lanes;
+
+    for (size_t first = 0; first < count; first += Float8::Width)
+    {
+        const size_t batch = std::min(Float8::Width, count - first);
+
+        // Tail lanes repeat the last vertex, their results are dropped:
+        for (size_t l = 0; l < Float8::Width; l++)
+        {
+            const size_t i = first + std::min(l, batch - 1);
+
+            lanes.Px[l] = positions[i].x;
+            lanes.Py[l] = positions[i].y;
+            lanes.Pz[l] = positions[i].z;
+            lanes.U[l]  = texcoords[i].x;
+            lanes.V[l]  = texcoords[i].y;
+            lanes.Nx[l] = normals[i].x;
+            lanes.Ny[l] = normals[i].y;
+            lanes.Nz[l] = normals[i].z;
+            lanes.Tx[l] = tangents[i].x;
+            lanes.Ty[l] = tangents[i].y;
+            lanes.Tz[l] = tangents[i].z;
+            lanes.Tw[l] = tangents[i].w;
+        }
+
+        CompressBatch(lanes, bbox, texBounds, batch, out.data() + first);
+    }
+}
+
+GeometryData VertexPacking::Allocate(PrimitiveData &prim, Vertex::Layout vLayout)
 {
-    // Allocate memory:
-    auto       vertSize = Vertex::GetSize(vLayout);
-    const auto spec =
-        GeometrySpec::BuildS<uint32_t>(vertSize, prim.VertexCount, prim.IndexCount);
+    // Allocate vertex memory, index buffer is taken over from the primitive:
+    auto vertSize = Vertex::GetSize(vLayout);
 
-    auto geo = GeometryData(spec);
+    GeometryData geo;
+    geo.VertexData  = OpaqueBuffer(vertSize * prim.VertexCount, 4);
+    geo.IndexData   = std::move(prim.Indices);
+    geo.VertexCount = prim.VertexCount;
+    geo.IndexCount  = prim.IndexCount;
+    geo.Lods        = std::move(prim.Lods);
+    geo.Meshlets    = std::move(prim.Meshlets);
 
     // Store metadata:
     geo.Layout = GeometryLayout{
         .VertexLayout = vLayout,
-        .IndexType    = VK_INDEX_TYPE_UINT32,
+        .IndexType    = prim.IndexType,
     };
 
     // Store bounding box - this is kept the same even for
     // compressed layouts that normalzie coords:
     geo.BBox = prim.BBox;
 
-    // Retrieve indices:
-    std::memcpy(geo.IndexData.Data, prim.Indices.data(),
-                prim.Indices.size() * sizeof(uint32_t));
+    return geo;
+}
+
+// Vertices handled by a single sub-task when encoding with a thread pool:
+static constexpr size_t EncodeGrainSize = 64 * 1024;
+
+GeometryData VertexPacking::Encode(PrimitiveData &prim, Vertex::Layout vLayout,
+                                   ThreadPool *pool)
+{
+    auto geo = Allocate(prim, vLayout);
+
+    // Every vertex is encoded independently, so ranges can run in parallel:
+    auto forEachRange = [&](auto &&encodeRange) {
+        if (pool)
+            pool->ParallelFor(prim.VertexCount, EncodeGrainSize, encodeRange);
+        else
+            encodeRange(0, prim.VertexCount);
+    };
+
+    auto forEachVertex = [&](auto &&func) {
+        forEachRange([&](size_t begin, size_t end) {
+            for (size_t vertIdx = begin; vertIdx < end; vertIdx++)
+                func(vertIdx);
+        });
+    };
 
     // Repackage vertices based on layout:
     if (auto *layout = std::get_if<Vertex::PushLayout>(&vLayout))
     {
-        auto         offsets   = GetOffsets(*layout);
-        const size_t compCount = offsets.ComponentStride * prim.VertexCount;
+        const auto   stride    = Vertex::GetPushOffsets(*layout).Stride;
+        const size_t compCount = stride * prim.VertexCount;
 
         auto data = new (geo.VertexData.Data) float[compCount];
 
-        for (size_t vertIdx = 0; vertIdx < prim.VertexCount; vertIdx++)
-        {
-            auto i = offsets.ComponentStride * vertIdx;
-
-            data[i + offsets.OffsetPos + 0] = prim.Positions[vertIdx].x;
-            data[i + offsets.OffsetPos + 1] = prim.Positions[vertIdx].y;
-            data[i + offsets.OffsetPos + 2] = prim.Positions[vertIdx].z;
-
-            if (layout->HasTexCoord)
-            {
-                data[i + offsets.OffsetTexCoord + 0] = prim.TexCoords[vertIdx].x;
-                data[i + offsets.OffsetTexCoord + 1] = prim.TexCoords[vertIdx].y;
-            }
-
-            if (layout->HasNormal)
-            {
-                data[i + offsets.OffsetNormal + 0] = prim.Normals[vertIdx].x;
-                data[i + offsets.OffsetNormal + 1] = prim.Normals[vertIdx].y;
-                data[i + offsets.OffsetNormal + 2] = prim.Normals[vertIdx].z;
-            }
-
-            if (layout->HasTangent)
-            {
-                data[i + offsets.OffsetTangent + 0] = prim.Tangents[vertIdx].x;
-                data[i + offsets.OffsetTangent + 1] = prim.Tangents[vertIdx].y;
-                data[i + offsets.OffsetTangent + 2] = prim.Tangents[vertIdx].z;
-                data[i + offsets.OffsetTangent + 3] = prim.Tangents[vertIdx].w;
-            }
-
-            if (layout->HasColor)
-            {
-                data[i + offsets.OffsetColor + 0] = prim.Colors[vertIdx].x;
-                data[i + offsets.OffsetColor + 1] = prim.Colors[vertIdx].y;
-                data[i + offsets.OffsetColor + 2] = prim.Colors[vertIdx].z;
-                data[i + offsets.OffsetColor + 3] = prim.Colors[vertIdx].w;
-            }
-        }
+        // Layout is dispatched once, not per vertex:
+        auto encoder = PushEncoders[Vertex::GetPushLayoutId(*layout)];
+
+        forEachRange([&](size_t begin, size_t end) { encoder(prim, data, begin, end); });
     }
 
     else if (auto *layout = std::get_if<Vertex::PullLayout>(&vLayout))
@@ -258,8 +576,7 @@ GeometryData VertexPacking::Encode(PrimitiveData &prim, Vertex::Layout vLayout)
         case Vertex::PullLayout::Naive: {
             auto data = new (geo.VertexData.Data) Vertex::PullNaive[prim.VertexCount];
 
-            for (size_t vertIdx = 0; vertIdx < prim.VertexCount; vertIdx++)
-            {
+            forEachVertex([&](size_t vertIdx) {
                 data[vertIdx] = Vertex::PullNaive{
                     .Position  = prim.Positions[vertIdx],
                     .TexCoordX = prim.TexCoords[vertIdx].x,
@@ -267,7 +584,7 @@ GeometryData VertexPacking::Encode(PrimitiveData &prim, Vertex::Layout vLayout)
                     .TexCoordY = prim.TexCoords[vertIdx].y,
                     .Tangent   = prim.Tangents[vertIdx],
                 };
-            }
+            });
 
             break;
         }
@@ -275,71 +592,16 @@ GeometryData VertexPacking::Encode(PrimitiveData &prim, Vertex::Layout vLayout)
             auto data =
                 new (geo.VertexData.Data) Vertex::PullCompressed[prim.VertexCount];
 
-            for (size_t vertIdx = 0; vertIdx < prim.VertexCount; vertIdx++)
-            {
-                glm::vec3 pos      = prim.Positions[vertIdx];
-                glm::vec2 texcoord = prim.TexCoords[vertIdx];
-                glm::vec3 normal   = prim.Normals[vertIdx];
-                glm::vec4 tangent  = prim.Tangents[vertIdx];
-
-                // Normalize position to [0,1]^3:
-                // TODO: Think if there is a better way to prevent division by zero:
-                pos = pos - prim.BBox.Center;
-                pos = pos / (prim.BBox.Extent + 0.001f);
-                pos = 0.5f * pos + 0.5f;
-
-                // Normalize texcoords to [0,1]^2:
-                texcoord = texcoord - prim.TexBounds.Center;
-                texcoord = texcoord / (prim.TexBounds.Extent);
-                texcoord = 0.5f * texcoord + 0.5f;
-
-                // Make sure normal and tangent are not ill-defined:
-                // TODO: This should be already caught by logic in the importer,
-                // not sure how this keeps slipping through...
-                glm::vec3 tan3{tangent};
-
-                if (glm::length(normal) < 1e-6)
-                    normal = glm::vec3(0, -1, 0);
-
-                if (glm::length(tan3) < 1e-6)
-                    tan3 = glm::vec3(1, 0, 0);
-
-                // Compress normal  with octahedral mapping,
-                // encode tangent with Rodriguez angle:
-                glm::vec2 normal2 = OctahedralMap(normal);
-                float tanAngle    = RodriguezAngleNormalized(normal, tan3);
-
-                // Do clamp to catch small numerical inaccuracies:
-                pos      = glm::clamp(pos, 0.0f, 1.0f);
-                texcoord = glm::clamp(texcoord, 0.0f, 1.0f);
-                normal2  = glm::clamp(normal2, 0.0f, 1.0f);
-                tanAngle = glm::clamp(tanAngle, 0.0f, 1.0f);
-
-                // Sanity check - is everything normalized?
-                vassert(IsNormalized(pos));
-                vassert(IsNormalized(texcoord));
-                vassert(IsNormalized(normal2));
-                vassert(IsNormalized(tanAngle));
-
-                // Quantize to uint16/uint8 and store:
-                auto qPos      = QuantizeVec3<uint16_t>(pos);
-                auto qTexCoord = QuantizeVec2<uint16_t>(texcoord);
-
-                auto normalU8 = QuantizeVec2<uint8_t>(normal2);
-                auto qNormal = PackUint8sToUint16(normalU8[0], normalU8[1]);
-
-                auto tangentU8 = QuantizeNormalized<uint8_t>(tanAngle);
-                auto signU8    = static_cast<uint16_t>(tangent.w > 0.0f);
-
-                auto qTangent = PackUint8sToUint16(tangentU8, signU8);
-
-                data[vertIdx] = Vertex::PullCompressed{
-                    .Pos      = qPos,
-                    .TexCoord = qTexCoord,
-                    .Normal   = qNormal,
-                    .Tangent  = qTangent,
-                };
-            }
+            forEachRange([&](size_t begin, size_t end) {
+                const size_t count = end - begin;
+
+                CompressVertices(std::span(prim.Positions).subspan(begin, count),
+                                 std::span(prim.TexCoords).subspan(begin, count),
+                                 std::span(prim.Normals).subspan(begin, count),
+                                 std::span(prim.Tangents).subspan(begin, count),
+                                 prim.BBox, prim.TexBounds,
+                                 std::span(data + begin, count));
+            });
 
             break;
         }
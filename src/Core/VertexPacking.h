@@ -4,7 +4,32 @@
 #include "GltfImporter.h"
 #include "VertexLayout.h"
 
+class ThreadPool;
+
 namespace VertexPacking
 {
-GeometryData Encode(PrimitiveData &prim, Vertex::Layout layout);
+// Allocates vertex buffer for given layout and takes over primitive
+// indices and bounding box. Vertex data is left uninitialized:
+GeometryData Allocate(PrimitiveData &prim, Vertex::Layout layout);
+
+// Allocates and fills vertex buffer with primitive data in the given layout.
+// If a pool is provided, large primitives are encoded in parallel ranges:
+GeometryData Encode(PrimitiveData &prim, Vertex::Layout layout,
+                    ThreadPool *pool = nullptr);
+
+// Compresses a single vertex. Position and texcoord are normalized
+// using bounds of the whole primitive:
+Vertex::PullCompressed CompressVertex(glm::vec3 pos, glm::vec2 texcoord, glm::vec3 normal,
+                                      glm::vec4 tangent, const AABB &bbox,
+                                      const TextureBounds &texBounds);
+
+// Batched CompressVertex, eight vertices at a time (in a single register with
+// AVX2). Results match up to one quantization step of the normal and tangent
+// angle. Normalization of the normals is only checked in debug builds:
+void CompressVertices(std::span<const glm::vec3> positions,
+                      std::span<const glm::vec2> texcoords,
+                      std::span<const glm::vec3> normals,
+                      std::span<const glm::vec4> tangents, const AABB &bbox,
+                      const TextureBounds               &texBounds,
+                      std::span<Vertex::PullCompressed> out);
 } // namespace VertexPacking
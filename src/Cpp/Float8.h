@@ -0,0 +1,222 @@
+#pragma once
+
+#include <array>
+#include <cmath>
+#include <cstdint>
+
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
+
+// Eight floats processed together. Maps to a single AVX2 register when
+// compiled with AVX2 support (see USE_AVX2 in CMakeLists), otherwise to
+// plain loops, which the compiler may still vectorize with narrower units.
+// Comparisons return masks consumed by Select:
+struct Float8 {
+    static constexpr size_t Width = 8;
+
+#ifdef __AVX2__
+    __m256 V;
+
+    static Float8 Load(const float *src)
+    {
+        return {_mm256_loadu_ps(src)};
+    }
+
+    static Float8 Splat(float x)
+    {
+        return {_mm256_set1_ps(x)};
+    }
+
+    void Store(float *dst) const
+    {
+        _mm256_storeu_ps(dst, V);
+    }
+
+    // Converts with truncation towards zero:
+    void StoreInt(int32_t *dst) const
+    {
+        auto res = _mm256_cvttps_epi32(V);
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(dst), res);
+    }
+
+    friend Float8 operator+(Float8 a, Float8 b)
+    {
+        return {_mm256_add_ps(a.V, b.V)};
+    }
+
+    friend Float8 operator-(Float8 a, Float8 b)
+    {
+        return {_mm256_sub_ps(a.V, b.V)};
+    }
+
+    friend Float8 operator*(Float8 a, Float8 b)
+    {
+        return {_mm256_mul_ps(a.V, b.V)};
+    }
+
+    friend Float8 operator/(Float8 a, Float8 b)
+    {
+        return {_mm256_div_ps(a.V, b.V)};
+    }
+
+    friend Float8 operator<(Float8 a, Float8 b)
+    {
+        return {_mm256_cmp_ps(a.V, b.V, _CMP_LT_OQ)};
+    }
+
+    friend Float8 operator>(Float8 a, Float8 b)
+    {
+        return {_mm256_cmp_ps(a.V, b.V, _CMP_GT_OQ)};
+    }
+
+    friend Float8 operator<=(Float8 a, Float8 b)
+    {
+        return {_mm256_cmp_ps(a.V, b.V, _CMP_LE_OQ)};
+    }
+
+    friend Float8 Min(Float8 a, Float8 b)
+    {
+        return {_mm256_min_ps(a.V, b.V)};
+    }
+
+    friend Float8 Max(Float8 a, Float8 b)
+    {
+        return {_mm256_max_ps(a.V, b.V)};
+    }
+
+    friend Float8 Abs(Float8 a)
+    {
+        return {_mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.V)};
+    }
+
+    friend Float8 Sqrt(Float8 a)
+    {
+        return {_mm256_sqrt_ps(a.V)};
+    }
+
+    // Picks a where the mask is set and b elsewhere:
+    friend Float8 Select(Float8 mask, Float8 a, Float8 b)
+    {
+        return {_mm256_blendv_ps(b.V, a.V, mask.V)};
+    }
+#else
+    std::array<float, Width> V;
+
+    static Float8 Load(const float *src)
+    {
+        Float8 res;
+
+        for (size_t i = 0; i < Width; i++)
+            res.V[i] = src[i];
+
+        return res;
+    }
+
+    static Float8 Splat(float x)
+    {
+        Float8 res;
+        res.V.fill(x);
+        return res;
+    }
+
+    void Store(float *dst) const
+    {
+        for (size_t i = 0; i < Width; i++)
+            dst[i] = V[i];
+    }
+
+    void StoreInt(int32_t *dst) const
+    {
+        for (size_t i = 0; i < Width; i++)
+            dst[i] = static_cast<int32_t>(V[i]);
+    }
+
+    template <typename Func>
+    static Float8 Map(Float8 a, Float8 b, Func func)
+    {
+        Float8 res;
+
+        for (size_t i = 0; i < Width; i++)
+            res.V[i] = func(a.V[i], b.V[i]);
+
+        return res;
+    }
+
+    // Masks are stored as 0 or 1 per lane:
+    static float Mask(bool x)
+    {
+        return x ? 1.0f : 0.0f;
+    }
+
+    friend Float8 operator+(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return x + y; });
+    }
+
+    friend Float8 operator-(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return x - y; });
+    }
+
+    friend Float8 operator*(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return x * y; });
+    }
+
+    friend Float8 operator/(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return x / y; });
+    }
+
+    friend Float8 operator<(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return Mask(x < y); });
+    }
+
+    friend Float8 operator>(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return Mask(x > y); });
+    }
+
+    friend Float8 operator<=(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return Mask(x <= y); });
+    }
+
+    friend Float8 Min(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return x < y ? x : y; });
+    }
+
+    friend Float8 Max(Float8 a, Float8 b)
+    {
+        return Map(a, b, [](float x, float y) { return x > y ? x : y; });
+    }
+
+    friend Float8 Abs(Float8 a)
+    {
+        return Map(a, a, [](float x, float) { return std::abs(x); });
+    }
+
+    friend Float8 Sqrt(Float8 a)
+    {
+        return Map(a, a, [](float x, float) { return std::sqrt(x); });
+    }
+
+    friend Float8 Select(Float8 mask, Float8 a, Float8 b)
+    {
+        Float8 res;
+
+        for (size_t i = 0; i < Width; i++)
+            res.V[i] = mask.V[i] != 0.0f ? a.V[i] : b.V[i];
+
+        return res;
+    }
+#endif
+
+    friend Float8 Clamp(Float8 a, float lo, float hi)
+    {
+        return Min(Max(a, Splat(lo)), Splat(hi));
+    }
+};
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+/// Simple incremental 64-bit FNV-1a hasher. Not cryptographic,
+/// meant for content-addressed cache keys.
+class Hasher {
+  public:
+    void Bytes(std::span<const uint8_t> bytes)
+    {
+        for (auto b : bytes)
+        {
+            mState ^= static_cast<uint64_t>(b);
+            mState *= Prime;
+        }
+    }
+
+    void String(std::string_view str)
+    {
+        Bytes({reinterpret_cast<const uint8_t *>(str.data()), str.size()});
+        // Terminator, so that ("ab", "c") and ("a", "bc") differ:
+        Value(uint8_t(0));
+    }
+
+    template <typename T>
+    void Value(const T &value)
+    {
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        Bytes({reinterpret_cast<const uint8_t *>(&value), sizeof(T)});
+    }
+
+    [[nodiscard]] uint64_t Get() const
+    {
+        return mState;
+    }
+
+  private:
+    static constexpr uint64_t Offset = 0xcbf29ce484222325ull;
+    static constexpr uint64_t Prime  = 0x100000001b3ull;
+
+    uint64_t mState = Offset;
+};
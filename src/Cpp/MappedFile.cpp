@@ -0,0 +1,145 @@
+#include "MappedFile.h"
+#include "Pch.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <utility>
+
+MappedFile::MappedFile(const std::filesystem::path &path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+    if (file == INVALID_HANDLE_VALUE)
+        return;
+
+    LARGE_INTEGER size;
+
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+    {
+        CloseHandle(file);
+        return;
+    }
+
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+
+    // The mapping object keeps its own reference to the file:
+    CloseHandle(file);
+
+    if (mapping == nullptr)
+        return;
+
+    void *view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+
+    if (view == nullptr)
+    {
+        CloseHandle(mapping);
+        return;
+    }
+
+    mData   = static_cast<const uint8_t *>(view);
+    mSize   = static_cast<size_t>(size.QuadPart);
+    mHandle = mapping;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+
+    if (fd == -1)
+        return;
+
+    struct stat info{};
+
+    if (fstat(fd, &info) != 0 || info.st_size == 0)
+    {
+        close(fd);
+        return;
+    }
+
+    auto  size = static_cast<size_t>(info.st_size);
+    void *view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+    // Mapping stays valid after the descriptor is closed:
+    close(fd);
+
+    if (view == MAP_FAILED)
+        return;
+
+    mData = static_cast<const uint8_t *>(view);
+    mSize = size;
+#endif
+}
+
+MappedFile::~MappedFile()
+{
+    Unmap();
+}
+
+MappedFile::MappedFile(MappedFile &&other) noexcept
+    : mData(other.mData), mSize(other.mSize), mHandle(other.mHandle)
+{
+    other.mData   = nullptr;
+    other.mSize   = 0;
+    other.mHandle = nullptr;
+}
+
+MappedFile &MappedFile::operator=(MappedFile &&other) noexcept
+{
+    if (this != &other)
+    {
+        Unmap();
+
+        mData   = std::exchange(other.mData, nullptr);
+        mSize   = std::exchange(other.mSize, 0);
+        mHandle = std::exchange(other.mHandle, nullptr);
+    }
+
+    return *this;
+}
+
+void MappedFile::Evict(std::span<const uint8_t> range) const
+{
+    if (mData == nullptr || range.empty())
+        return;
+
+#ifdef _WIN32
+    // Unlocking pages which are not locked removes them from the working set:
+    VirtualUnlock(const_cast<uint8_t *>(range.data()), range.size());
+#else
+    // Range has to start at a page boundary:
+    const auto pageSize = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+
+    auto begin = reinterpret_cast<uintptr_t>(range.data());
+    auto end   = begin + range.size();
+
+    begin = std::max(begin & ~(pageSize - 1), reinterpret_cast<uintptr_t>(mData));
+
+    madvise(reinterpret_cast<void *>(begin), end - begin, MADV_DONTNEED);
+#endif
+}
+
+void MappedFile::Unmap()
+{
+    if (mData == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(mData);
+    CloseHandle(static_cast<HANDLE>(mHandle));
+#else
+    munmap(const_cast<uint8_t *>(mData), mSize);
+#endif
+
+    mData   = nullptr;
+    mSize   = 0;
+    mHandle = nullptr;
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <span>
+
+/// Read-only memory mapping of a whole file. Pages are only brought
+/// in by the OS when they are actually touched.
+class MappedFile {
+  public:
+    MappedFile() = default;
+    MappedFile(const std::filesystem::path &path);
+    ~MappedFile();
+
+    MappedFile(const MappedFile &)            = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+
+    MappedFile(MappedFile &&other) noexcept;
+    MappedFile &operator=(MappedFile &&other) noexcept;
+
+    [[nodiscard]] bool IsValid() const
+    {
+        return mData != nullptr;
+    }
+
+    [[nodiscard]] std::span<const uint8_t> Bytes() const
+    {
+        return {mData, mSize};
+    }
+
+    [[nodiscard]] size_t Size() const
+    {
+        return mSize;
+    }
+
+    // Hints the OS that pages of the range won't be needed soon, so they can
+    // be dropped from the working set. They are read again if touched:
+    void Evict(std::span<const uint8_t> range) const;
+
+  private:
+    void Unmap();
+
+  private:
+    const uint8_t *mData = nullptr;
+    size_t         mSize = 0;
+
+    // Platform-specific handles (file mapping object on Windows):
+    void *mHandle = nullptr;
+};
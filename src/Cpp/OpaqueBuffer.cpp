@@ -13,12 +13,19 @@ OpaqueBuffer::OpaqueBuffer(size_t size, size_t alignment) : Size(size)
 }
 
 OpaqueBuffer::~OpaqueBuffer()
+{
+    Release();
+}
+
+void OpaqueBuffer::Release()
 {
 #ifdef _MSC_VER
     _aligned_free(Data);
 #else
     delete[] Data;
 #endif
+    Data = nullptr;
+    Size = 0;
 }
 
 OpaqueBuffer::OpaqueBuffer(OpaqueBuffer &&other) noexcept
@@ -29,6 +36,11 @@ OpaqueBuffer::OpaqueBuffer(OpaqueBuffer &&other) noexcept
 
 OpaqueBuffer &OpaqueBuffer::operator=(OpaqueBuffer &&other) noexcept
 {
+    if (this == &other)
+        return *this;
+
+    Release();
+
     Size = other.Size;
     Data = other.Data;
 
@@ -17,4 +17,7 @@ struct OpaqueBuffer {
 
     size_t   Size = 0;
     uint8_t *Data = nullptr;
+
+  private:
+    void Release();
 };
\ No newline at end of file
@@ -0,0 +1,551 @@
+#pragma once
+
+#include "Vassert.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Keys of slot map elements. Low bits index a slot, high bits hold the
+// generation of that slot, which is bumped each time its element is erased.
+// Generations start at 1, so a valid key is never 0. Slots whose generation
+// runs out are retired, so a key is never handed out twice by the same map:
+using SlotKey = uint32_t;
+
+namespace SlotKeys
+{
+inline constexpr uint32_t IndexBits     = 22;
+inline constexpr uint32_t MaxSlots      = 1u << IndexBits;
+inline constexpr uint32_t MaxGeneration = (1u << (32 - IndexBits)) - 1;
+
+inline constexpr uint32_t Index(SlotKey key)
+{
+    return key & (MaxSlots - 1);
+}
+
+inline constexpr uint32_t Generation(SlotKey key)
+{
+    return key >> IndexBits;
+}
+
+inline constexpr SlotKey Make(uint32_t index, uint32_t generation)
+{
+    return (generation << IndexBits) | index;
+}
+} // namespace SlotKeys
+
+// Iterates dense (key, value) storage of the maps below. Dereferencing
+// yields the pair by value, so loops bind it as `auto [key, value]`:
+template <typename Map, typename Value>
+class SlotMapIterator {
+  public:
+    using value_type      = std::pair<SlotKey, Value &>;
+    using reference       = value_type;
+    using difference_type = std::ptrdiff_t;
+
+    SlotMapIterator() = default;
+
+    SlotMapIterator(Map *map, size_t pos) : mMap(map), mPos(pos)
+    {
+    }
+
+    reference operator*() const
+    {
+        return {mMap->KeyAt(mPos), mMap->ValueAt(mPos)};
+    }
+
+    SlotMapIterator &operator++()
+    {
+        mPos++;
+        return *this;
+    }
+
+    SlotMapIterator operator++(int)
+    {
+        auto res = *this;
+        mPos++;
+        return res;
+    }
+
+    bool operator==(const SlotMapIterator &other) const
+    {
+        return mPos == other.mPos;
+    }
+
+  private:
+    Map   *mMap = nullptr;
+    size_t mPos = 0;
+};
+
+// Densely stored elements addressed by generational keys. Lookups are O(1),
+// erasure moves the last element into the freed place, so iteration always
+// walks a contiguous range. Storage is paged and the page table is reserved
+// up front, so emplacing never moves existing elements. References stay
+// valid until an element is erased, which may relocate any other one.
+// The map has no locking of its own, see Scene::Lock:
+template <typename T>
+class SlotMap {
+  public:
+    using Key = SlotKey;
+
+    using iterator       = SlotMapIterator<SlotMap, T>;
+    using const_iterator = SlotMapIterator<const SlotMap, const T>;
+
+    std::pair<Key, T &> Emplace(T value = {})
+    {
+        uint32_t index;
+
+        // Reusing the oldest free slot first spreads generations evenly:
+        if (!mFreeSlots.empty() && (mFreeSlots.size() >= MinFreeSlots ||
+                                    mSlots.Size() == SlotKeys::MaxSlots))
+        {
+            index = mFreeSlots.front();
+            mFreeSlots.pop_front();
+        }
+        else
+        {
+            vassert(mSlots.Size() < SlotKeys::MaxSlots, "Slot map is out of keys!");
+
+            index = static_cast<uint32_t>(mSlots.Size());
+            mSlots.PushBack(Slot{.Generation = 1});
+        }
+
+        auto &slot = mSlots[index];
+        slot.Dense = static_cast<uint32_t>(mValues.Size());
+
+        const Key key = SlotKeys::Make(index, slot.Generation);
+
+        mKeys.PushBack(key);
+        auto &res = mValues.PushBack(std::move(value));
+
+        return {key, res};
+    }
+
+    [[nodiscard]] bool Contains(Key key) const
+    {
+        return FindDense(key) != Invalid;
+    }
+
+    [[nodiscard]] T *Find(Key key)
+    {
+        const uint32_t dense = FindDense(key);
+        return dense != Invalid ? &mValues[dense] : nullptr;
+    }
+
+    [[nodiscard]] const T *Find(Key key) const
+    {
+        const uint32_t dense = FindDense(key);
+        return dense != Invalid ? &mValues[dense] : nullptr;
+    }
+
+    T &operator[](Key key)
+    {
+        const uint32_t dense = FindDense(key);
+        vassert(dense != Invalid, "Invalid slot map key!");
+        return mValues[dense];
+    }
+
+    const T &operator[](Key key) const
+    {
+        const uint32_t dense = FindDense(key);
+        vassert(dense != Invalid, "Invalid slot map key!");
+        return mValues[dense];
+    }
+
+    bool Erase(Key key)
+    {
+        const uint32_t dense = FindDense(key);
+
+        if (dense == Invalid)
+            return false;
+
+        EraseDense(dense);
+        return true;
+    }
+
+    // Erases elements for which pred(key, value) returns true:
+    template <typename Pred>
+    size_t EraseIf(Pred pred)
+    {
+        size_t erased = 0;
+
+        // Backwards, so that elements moved into erased places were already visited:
+        for (size_t i = mValues.Size(); i-- > 0;)
+        {
+            if (pred(mKeys[i], mValues[i]))
+            {
+                EraseDense(static_cast<uint32_t>(i));
+                erased++;
+            }
+        }
+
+        return erased;
+    }
+
+    // Keys of erased elements stay invalid, slots are not reset:
+    void Clear()
+    {
+        EraseIf([](Key, const T &) { return true; });
+    }
+
+    [[nodiscard]] size_t Size() const
+    {
+        return mValues.Size();
+    }
+
+    [[nodiscard]] bool Empty() const
+    {
+        return mValues.Size() == 0;
+    }
+
+    // Dense access, positions change when elements are erased:
+    [[nodiscard]] Key KeyAt(size_t pos) const
+    {
+        return mKeys[pos];
+    }
+
+    T &ValueAt(size_t pos)
+    {
+        return mValues[pos];
+    }
+
+    const T &ValueAt(size_t pos) const
+    {
+        return mValues[pos];
+    }
+
+    iterator begin()
+    {
+        return iterator(this, 0);
+    }
+
+    iterator end()
+    {
+        return iterator(this, Size());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, Size());
+    }
+
+  private:
+    static constexpr uint32_t Invalid = std::numeric_limits<uint32_t>::max();
+
+    // Free slots kept back before reuse, so that erasing and emplacing
+    // in a loop doesn't burn through generations of a single slot:
+    static constexpr size_t MinFreeSlots = 64;
+
+    struct Slot {
+        // Generation of the current (or next) element in the slot,
+        // past MaxGeneration for retired slots:
+        uint32_t Generation = 0;
+        uint32_t Dense      = Invalid;
+    };
+
+    // Growable array of fixed size pages with stable element addresses:
+    template <typename U>
+    class Pages {
+      public:
+        static constexpr size_t PageSize =
+            std::bit_floor(std::max<size_t>(64 * 1024 / sizeof(U), 16));
+
+        Pages()
+        {
+            mPages.reserve((SlotKeys::MaxSlots + PageSize - 1) / PageSize);
+        }
+
+        U &operator[](size_t i)
+        {
+            return mPages[i / PageSize][i % PageSize];
+        }
+
+        const U &operator[](size_t i) const
+        {
+            return mPages[i / PageSize][i % PageSize];
+        }
+
+        U &PushBack(U value)
+        {
+            if (mSize == mPages.size() * PageSize)
+                mPages.push_back(std::make_unique<U[]>(PageSize));
+
+            // Size is bumped only after the element is written:
+            auto &res = (*this)[mSize];
+            res       = std::move(value);
+            mSize++;
+
+            return res;
+        }
+
+        // Resets the element, so that it doesn't hold on to its resources:
+        void PopBack()
+        {
+            (*this)[--mSize] = U{};
+        }
+
+        [[nodiscard]] size_t Size() const
+        {
+            return mSize;
+        }
+
+      private:
+        std::vector<std::unique_ptr<U[]>> mPages;
+        size_t                            mSize = 0;
+    };
+
+    uint32_t FindDense(Key key) const
+    {
+        const uint32_t index = SlotKeys::Index(key);
+
+        if (index >= mSlots.Size())
+            return Invalid;
+
+        const auto &slot = mSlots[index];
+
+        if (slot.Generation != SlotKeys::Generation(key))
+            return Invalid;
+
+        return slot.Dense;
+    }
+
+    void EraseDense(uint32_t dense)
+    {
+        const uint32_t index = SlotKeys::Index(mKeys[dense]);
+        const size_t   last  = mValues.Size() - 1;
+
+        if (dense != last)
+        {
+            mValues[dense] = std::move(mValues[last]);
+            mKeys[dense]   = mKeys[last];
+
+            mSlots[SlotKeys::Index(mKeys[dense])].Dense = dense;
+        }
+
+        mValues.PopBack();
+        mKeys.PopBack();
+
+        auto &slot = mSlots[index];
+        slot.Dense = Invalid;
+
+        if (++slot.Generation <= SlotKeys::MaxGeneration)
+            mFreeSlots.push_back(index);
+    }
+
+    Pages<Slot> mSlots;
+    Pages<Key>  mKeys;
+    Pages<T>    mValues;
+
+    std::deque<uint32_t> mFreeSlots;
+};
+
+// Values attached to elements of another slot map, e.g. renderer resources
+// created for scene elements. Indexed by slot like the primary map, entries
+// are only found with the exact key they were emplaced with. An entry left
+// behind by an erased element is replaced when its slot is reused:
+template <typename T>
+class SecondaryMap {
+  public:
+    using Key = SlotKey;
+
+    using iterator       = SlotMapIterator<SecondaryMap, T>;
+    using const_iterator = SlotMapIterator<const SecondaryMap, const T>;
+
+    T &Emplace(Key key, T value = {})
+    {
+        const uint32_t index = SlotKeys::Index(key);
+
+        if (index >= mSparse.size())
+            mSparse.resize(index + 1, Invalid);
+
+        auto &dense = mSparse[index];
+
+        if (dense != Invalid)
+        {
+            vassert(mKeys[dense] != key, "Key is already in the secondary map!");
+
+            mKeys[dense]   = key;
+            mValues[dense] = std::move(value);
+
+            return mValues[dense];
+        }
+
+        dense = static_cast<uint32_t>(mValues.size());
+
+        mKeys.push_back(key);
+        return mValues.emplace_back(std::move(value));
+    }
+
+    T &FindOrEmplace(Key key)
+    {
+        if (auto *res = Find(key))
+            return *res;
+
+        return Emplace(key);
+    }
+
+    [[nodiscard]] bool Contains(Key key) const
+    {
+        return FindDense(key) != Invalid;
+    }
+
+    [[nodiscard]] T *Find(Key key)
+    {
+        const uint32_t dense = FindDense(key);
+        return dense != Invalid ? &mValues[dense] : nullptr;
+    }
+
+    [[nodiscard]] const T *Find(Key key) const
+    {
+        const uint32_t dense = FindDense(key);
+        return dense != Invalid ? &mValues[dense] : nullptr;
+    }
+
+    T &operator[](Key key)
+    {
+        const uint32_t dense = FindDense(key);
+        vassert(dense != Invalid, "Invalid secondary map key!");
+        return mValues[dense];
+    }
+
+    const T &operator[](Key key) const
+    {
+        const uint32_t dense = FindDense(key);
+        vassert(dense != Invalid, "Invalid secondary map key!");
+        return mValues[dense];
+    }
+
+    bool Erase(Key key)
+    {
+        const uint32_t dense = FindDense(key);
+
+        if (dense == Invalid)
+            return false;
+
+        EraseDense(dense);
+        return true;
+    }
+
+    // Erases entries for which pred(key, value) returns true:
+    template <typename Pred>
+    size_t EraseIf(Pred pred)
+    {
+        size_t erased = 0;
+
+        for (size_t i = mValues.size(); i-- > 0;)
+        {
+            if (pred(mKeys[i], mValues[i]))
+            {
+                EraseDense(static_cast<uint32_t>(i));
+                erased++;
+            }
+        }
+
+        return erased;
+    }
+
+    void Clear()
+    {
+        mSparse.clear();
+        mKeys.clear();
+        mValues.clear();
+    }
+
+    [[nodiscard]] size_t Size() const
+    {
+        return mValues.size();
+    }
+
+    [[nodiscard]] bool Empty() const
+    {
+        return mValues.empty();
+    }
+
+    [[nodiscard]] Key KeyAt(size_t pos) const
+    {
+        return mKeys[pos];
+    }
+
+    T &ValueAt(size_t pos)
+    {
+        return mValues[pos];
+    }
+
+    const T &ValueAt(size_t pos) const
+    {
+        return mValues[pos];
+    }
+
+    iterator begin()
+    {
+        return iterator(this, 0);
+    }
+
+    iterator end()
+    {
+        return iterator(this, Size());
+    }
+
+    const_iterator begin() const
+    {
+        return const_iterator(this, 0);
+    }
+
+    const_iterator end() const
+    {
+        return const_iterator(this, Size());
+    }
+
+  private:
+    static constexpr uint32_t Invalid = std::numeric_limits<uint32_t>::max();
+
+    uint32_t FindDense(Key key) const
+    {
+        const uint32_t index = SlotKeys::Index(key);
+
+        if (index >= mSparse.size())
+            return Invalid;
+
+        const uint32_t dense = mSparse[index];
+
+        if (dense == Invalid || mKeys[dense] != key)
+            return Invalid;
+
+        return dense;
+    }
+
+    void EraseDense(uint32_t dense)
+    {
+        const uint32_t index = SlotKeys::Index(mKeys[dense]);
+
+        if (dense != mValues.size() - 1)
+        {
+            mValues[dense] = std::move(mValues.back());
+            mKeys[dense]   = mKeys.back();
+
+            mSparse[SlotKeys::Index(mKeys[dense])] = dense;
+        }
+
+        mValues.pop_back();
+        mKeys.pop_back();
+
+        mSparse[index] = Invalid;
+    }
+
+    std::vector<uint32_t> mSparse;
+    std::vector<Key>      mKeys;
+    std::vector<T>        mValues;
+};
@@ -2,7 +2,10 @@
 
 #include "SyncQueue.h"
 
+#include <algorithm>
+#include <atomic>
 #include <functional>
+#include <memory>
 #include <optional>
 #include <thread>
 
@@ -50,6 +53,66 @@ class ThreadPool {
         mTasks.Push(task);
     }
 
+    // Splits [0, count) into ranges of at most grainSize elements and calls
+    // func(begin, end) for each of them on the workers. The calling thread
+    // processes ranges too, so this is safe to call from inside a task -
+    // it never waits on a helper that didn't get to run yet.
+    // Returns once all the ranges are done:
+    template <typename F>
+    void ParallelFor(size_t count, size_t grainSize, F &&func)
+    {
+        const size_t rangeCount = (count + grainSize - 1) / grainSize;
+
+        if (rangeCount == 0)
+            return;
+
+        if (rangeCount == 1)
+        {
+            func(size_t(0), count);
+            return;
+        }
+
+        // Helpers may start after all the work is done, so the
+        // counters must outlive this call:
+        struct State {
+            std::atomic_size_t Next = 0;
+            std::atomic_size_t Done = 0;
+        };
+
+        auto state = std::make_shared<State>();
+
+        // Func is only touched after claiming a range, which means
+        // the caller is still waiting for it to finish:
+        auto work = [state, rangeCount, count, grainSize, fn = &func]() {
+            while (true)
+            {
+                const size_t idx = state->Next++;
+
+                if (idx >= rangeCount)
+                    return;
+
+                const size_t begin = idx * grainSize;
+                const size_t end   = std::min(begin + grainSize, count);
+
+                (*fn)(begin, end);
+
+                state->Done++;
+                state->Done.notify_all();
+            }
+        };
+
+        const size_t helperCount = std::min(mWorkers.size(), rangeCount - 1);
+
+        for (size_t i = 0; i < helperCount; i++)
+            Push(work);
+
+        work();
+
+        // Wait for ranges claimed by the helpers:
+        for (size_t done = state->Done; done != rangeCount; done = state->Done)
+            state->Done.wait(done);
+    }
+
   private:
     SyncQueue<OptTask> mTasks;
 
@@ -110,6 +110,26 @@ void ModelLoaderGui::ImportMenu()
         ImGui::Checkbox("Fetch Albedo", &v);
         ImGui::Checkbox("Fetch Normal", &mModelConfig.FetchNormal);
         ImGui::Checkbox("Fetch Roughness", &mModelConfig.FetchRoughness);
+        ImGui::Checkbox("Compress Textures", &mModelConfig.CompressTextures);
+
+        ImGui::Dummy(ImVec2(0.0f, 10.0f));
+
+        ImGui::Text("Import Options:");
+        ImGui::Separator();
+
+        static int32_t    tangentChoice = static_cast<int32_t>(mModelConfig.Tangents);
+        static std::array tangentOptions{"Fast", "MikkTSpace"};
+
+        if (imutils::Combo("Tangents", tangentChoice, tangentOptions))
+            mModelConfig.Tangents = static_cast<TangentMethod>(tangentChoice);
+
+        ImGui::Checkbox("Benchmark Tangents", &mModelConfig.BenchmarkTangents);
+        ImGui::Checkbox("Optimize Meshes", &mModelConfig.OptimizeMeshes);
+        ImGui::Checkbox("Generate LODs", &mModelConfig.GenerateLods);
+        ImGui::Checkbox("Build Meshlets", &mModelConfig.BuildMeshlets);
+        ImGui::Checkbox("Use Cooked Cache", &mModelConfig.UseCache);
+        ImGui::Checkbox("Progressive Loading", &mModelConfig.Progressive);
+        ImGui::InputInt("Load Priority", &mLoadPriority);
 
         ImGui::Dummy(ImVec2(0.0f, 10.0f));
 
@@ -131,5 +151,5 @@ void ModelLoaderGui::LoadModel()
 {
     mModelConfig.Filepath = mBrowser.ChosenFile;
 
-    mEditor.LoadModel(mModelConfig);
+    mEditor.LoadModel(mModelConfig, mLoadPriority);
 }
\ No newline at end of file
@@ -25,6 +25,7 @@ class ModelLoaderGui {
     bool mImportMenuOpen = true;
 
     ModelConfig mModelConfig;
+    int32_t     mLoadPriority = 0;
 
     FilesystemBrowser mBrowser;
 };
\ No newline at end of file
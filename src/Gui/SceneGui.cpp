@@ -18,6 +18,7 @@
 #include <glm/gtx/quaternion.hpp>
 
 #include <filesystem>
+#include <format>
 #include <optional>
 #include <ranges>
 #include <string>
@@ -321,6 +322,24 @@ void SceneGui::AddInstancePopup()
             }
         }
 
+        ImGui::Dummy(ImVec2(0.0f, 10.0f));
+        ImGui::Text("Loading:");
+        ImGui::Separator();
+
+        for (auto &[prefabId, prefab] : mEditor.Prefabs())
+        {
+            if (prefab.IsReady)
+                continue;
+
+            std::string name =
+                "Cancel " + prefab.Root.Name + "##" + std::to_string(prefabId);
+
+            if (ImGui::Selectable(name.c_str()))
+            {
+                mEditor.CancelModelLoad(prefabId);
+            }
+        }
+
         // TODO: maybe move this to the data menu
         ImGui::Dummy(ImVec2(0.0f, 10.0f));
 
@@ -363,6 +382,12 @@ void SceneGui::DataMenu()
         ImGui::EndTabItem();
     }
 
+    if (ImGui::BeginTabItem("Diagnostics"))
+    {
+        DiagnosticsTab();
+        ImGui::EndTabItem();
+    }
+
     if (ImGui::BeginTabItem("Environment"))
     {
         EnvironmentTab();
@@ -374,6 +399,54 @@ void SceneGui::DataMenu()
     ImGui::End();
 }
 
+void SceneGui::DiagnosticsTab()
+{
+    bool anyIssues = false;
+
+    for (auto &[prefabId, prefab] : mEditor.Prefabs())
+    {
+        if (prefab.Diagnostics.empty())
+            continue;
+
+        anyIssues = true;
+
+        const std::string prefabName =
+            std::format("{} ({} primitives)##diag{}", prefab.Root.Name,
+                        prefab.Diagnostics.size(), prefabId);
+
+        if (!ImGui::TreeNode(prefabName.c_str()))
+            continue;
+
+        for (const auto &diag : prefab.Diagnostics)
+        {
+            const std::string primName =
+                std::format("Mesh {}, primitive {}", diag.GltfMesh, diag.GltfPrim);
+
+            if (!ImGui::TreeNode(primName.c_str()))
+                continue;
+
+            for (size_t i = 0; i < ImportIssueCount; i++)
+            {
+                if (diag.Counts[i] == 0)
+                    continue;
+
+                ImGui::Text("%s: %zu", GetIssueName(static_cast<ImportIssue>(i)),
+                            diag.Counts[i]);
+
+                for (const auto &example : diag.Examples[i])
+                    ImGui::BulletText("%s", example.c_str());
+            }
+
+            ImGui::TreePop();
+        }
+
+        ImGui::TreePop();
+    }
+
+    if (!anyIssues)
+        ImGui::Text("No issues found in loaded models.");
+}
+
 void SceneGui::MeshesTab()
 {
     using namespace std::views;
@@ -385,7 +458,7 @@ void SceneGui::MeshesTab()
     uint32_t                counter     = 0;
     std::optional<SceneKey> keyToDelete = std::nullopt;
 
-    for (auto &[meshKey, mesh] : mEditor.Meshes())
+    for (auto [meshKey, mesh] : mEditor.Meshes())
     {
         std::string nodeName = std::to_string(counter++) + ". " + mesh.Name;
 
@@ -427,7 +500,7 @@ void SceneGui::MeshesTab()
                         static std::array<char, 255> filterBuf{};
                         ImGui::InputText("Filter", &filterBuf[0], 255);
 
-                        for (auto &[id, mat] : mEditor.Materials())
+                        for (auto [id, mat] : mEditor.Materials())
                         {
                             if (mat.Name.find(std::string(&filterBuf[0])) ==
                                 std::string::npos)
@@ -504,7 +577,7 @@ void SceneGui::MaterialsTab()
             static std::array<char, 255> filterBuf{};
             ImGui::InputText("Filter", &filterBuf[0], 255);
 
-            for (auto &[imgPick, _] : mEditor.Images())
+            for (auto [imgPick, _] : mEditor.Images())
             {
                 auto imgName =
                     std::format("({}) {}", imgPick, mEditor.GetImage(imgPick).Name);
@@ -527,7 +600,7 @@ void SceneGui::MaterialsTab()
     static std::array<char, 255> filterBuf{};
     ImGui::InputText("Filter", &filterBuf[0], 255);
 
-    for (auto &[key, mat] : mEditor.Materials())
+    for (auto [key, mat] : mEditor.Materials())
     {
         if (mat.Name.find(std::string(&filterBuf[0])) == std::string::npos)
             continue;
@@ -579,7 +652,7 @@ void SceneGui::ImagesTab()
 
     std::optional<SceneKey> imgToErase = std::nullopt;
 
-    for (auto &[imgKey, img] : mEditor.Images())
+    for (auto [imgKey, img] : mEditor.Images())
     {
         if (img.Name.find(std::string(&filterBuf[0])) == std::string::npos)
             continue;
@@ -771,13 +844,7 @@ void SceneGui::ObjectPropertiesMenu()
         if (ImGui::TreeNodeEx("Transform"))
         {
             if (TransformWidget(*mSelectedNode))
-            {
-                // TODO: this should only really update
-                // objects associated with subtree rooted at mSelectedNode
-                // This will require going along the path from root to
-                // mSelectedNode and then propagating as usual.
-                mEditor.UpdateTransforms(&mEditor.GraphRoot);
-            }
+                mEditor.UpdateTransforms(mSelectedNode);
 
             ImGui::TreePop();
         }
@@ -797,7 +864,7 @@ void SceneGui::ObjectPropertiesMenu()
             // the real translation axes etc.
 
             glm::mat4 currentNonAggregate = mSelectedNode->GetTransform();
-            glm::mat4 parentAggregate = mSelectedNode->Parent->GetAggregateTransform();
+            glm::mat4 parentAggregate = mEditor.GetWorldTransform(*mSelectedNode->Parent);
 
             glm::mat4 parentWithoutScale{};
 
@@ -846,8 +913,7 @@ void SceneGui::ObjectPropertiesMenu()
                 mSelectedNode->Rotation    = glm::eulerAngles(rotation);
                 mSelectedNode->Scale       = scale;
 
-                // TODO: optimization, same as above
-                mEditor.UpdateTransforms(&mEditor.GraphRoot);
+                mEditor.UpdateTransforms(mSelectedNode);
             }
         }
     }
@@ -34,6 +34,7 @@ class SceneGui {
     void MeshesTab();
     void MaterialsTab();
     void ImagesTab();
+    void DiagnosticsTab();
     void EnvironmentTab();
 
     void AddProviderPopup();
@@ -44,6 +44,54 @@ DynamicUniformBuffer::HandlesAndSizes DynamicUniformBuffer::GetBufferHandlesAndS
     return {handles, sizes};
 }
 
+DynamicIndirectBuffer::DynamicIndirectBuffer(VulkanContext &ctx, FrameInfo &frame,
+                                             VkDeviceSize bufferSize)
+    : mBufferSize(bufferSize), mCtx(ctx), mFrame(frame), mDeletionQueue(ctx)
+{
+    mIndirectBuffers.resize(mCtx.Swapchain.image_count);
+
+    for (auto &indirectBuffer : mIndirectBuffers)
+    {
+        indirectBuffer =
+            MakeBuffer::MappedIndirect(mCtx, "DynamicIndirectBuffer", bufferSize);
+        mDeletionQueue.push_back(indirectBuffer);
+    }
+}
+
+void DynamicIndirectBuffer::Reset()
+{
+    mUsedSize = 0;
+}
+
+std::optional<DynamicIndirectBuffer::Allocation> DynamicIndirectBuffer::Allocate(
+    VkDeviceSize size, VkDeviceSize alignment)
+{
+    const auto offset = (mUsedSize + alignment - 1) / alignment * alignment;
+
+    if (offset + size > mBufferSize)
+        return std::nullopt;
+
+    mUsedSize = offset + size;
+
+    auto &indirectBuffer = mIndirectBuffers[mFrame.ImageIndex];
+    auto *data           = static_cast<uint8_t *>(indirectBuffer.AllocInfo.pMappedData);
+
+    return Allocation{
+        .Data   = data + offset,
+        .Offset = offset,
+    };
+}
+
+VkBuffer DynamicIndirectBuffer::CurrentBuffer() const
+{
+    return mIndirectBuffers[mFrame.ImageIndex].Handle;
+}
+
+VkDeviceSize DynamicIndirectBuffer::UsedSize() const
+{
+    return mUsedSize;
+}
+
 DynamicDescriptorSet::DynamicDescriptorSet(VulkanContext &ctx, FrameInfo &frame)
     : mCtx(ctx), mFrame(frame), mDeletionQueue(ctx)
 {
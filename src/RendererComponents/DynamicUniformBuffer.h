@@ -6,6 +6,8 @@
 #include "Frame.h"
 #include "VulkanContext.h"
 
+#include <optional>
+
 // Class meant for uniform buffers with data updated each frame.
 // Behind the scenes it juggles several (swapchain image count) buffers
 // to avoid need for explicit synchronization.
@@ -32,6 +34,37 @@ class DynamicUniformBuffer {
     DeletionQueue  mDeletionQueue;
 };
 
+// Host-visible buffer of indirect draw commands rewritten each frame, juggling
+// buffers per swapchain image in the same way. Space is handed out
+// linearly and reclaimed with Reset at the start of each frame.
+class DynamicIndirectBuffer {
+  public:
+    DynamicIndirectBuffer(VulkanContext &ctx, FrameInfo &frame, VkDeviceSize bufSize);
+
+    void Reset();
+
+    struct Allocation {
+        void        *Data;
+        VkDeviceSize Offset;
+    };
+
+    // Returns nullopt if the current buffer is out of space:
+    [[nodiscard]] std::optional<Allocation> Allocate(VkDeviceSize size,
+                                                     VkDeviceSize alignment);
+
+    [[nodiscard]] VkBuffer     CurrentBuffer() const;
+    [[nodiscard]] VkDeviceSize UsedSize() const;
+
+  private:
+    VkDeviceSize        mBufferSize;
+    VkDeviceSize        mUsedSize = 0;
+    std::vector<Buffer> mIndirectBuffers;
+
+    VulkanContext &mCtx;
+    FrameInfo     &mFrame;
+    DeletionQueue  mDeletionQueue;
+};
+
 class DynamicDescriptorSet {
   public:
     DynamicDescriptorSet(VulkanContext &ctx, FrameInfo &frame);
@@ -25,7 +25,8 @@ struct ShadowVolume {
 
 class ShadowmapHandler {
   public:
-    static constexpr size_t NumCascades = 3;
+    static constexpr size_t   NumCascades         = 3;
+    static constexpr uint32_t ShadowmapResolution = 2048;
 
     using Matrices   = std::array<glm::mat4, NumCascades>;
     using Bounds     = std::array<float, NumCascades>;
@@ -112,8 +113,7 @@ class ShadowmapHandler {
                                                 glm::mat4 lightView) const;
 
   private:
-    static constexpr uint32_t ShadowmapResolution = 2048;
-    static constexpr VkFormat ShadowmapFormat     = VK_FORMAT_D32_SFLOAT;
+    static constexpr VkFormat ShadowmapFormat = VK_FORMAT_D32_SFLOAT;
 
     VulkanContext              &mCtx;
     std::optional<PipelineInfo> mPipelineInfo = std::nullopt;
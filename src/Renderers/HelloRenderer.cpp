@@ -47,7 +47,7 @@ void HelloRenderer::RebuildPipelines()
         PipelineBuilder("HelloRendererPipeline")
             .SetShaderPathVertex("assets/spirv/HelloTriangleVert.spv")
             .SetShaderPathFragment("assets/spirv/HelloTriangleFrag.spv")
-            .SetVertexInput(mGeometryLayout.VertexLayout, 0, VK_VERTEX_INPUT_RATE_VERTEX)
+            .SetVertexInput(mVertexLayout, 0, VK_VERTEX_INPUT_RATE_VERTEX)
             .SetTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
             .SetPolygonMode(VK_POLYGON_MODE_FILL)
             .SetCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
@@ -88,18 +88,21 @@ void HelloRenderer::OnRender([[maybe_unused]] std::optional<SceneKey> highlighte
 
         mGraphicsPipeline.BindDescriptorSet(cmd, mDynamicDS.DescriptorSet(), 0);
 
-        for (auto &[_, drawable] : mDrawables)
+        for (auto [_, drawable] : mDrawables)
         {
             VkBuffer     vertBuffer = drawable.VertexBuffer.Handle;
             VkDeviceSize vertOffset = 0;
             vkCmdBindVertexBuffers(cmd, 0, 1, &vertBuffer, &vertOffset);
 
             vkCmdBindIndexBuffer(cmd, drawable.IndexBuffer.Handle, 0,
-                                 mGeometryLayout.IndexType);
+                                 drawable.IndexType);
 
-            auto &instances = mInstanceData[drawable.Instances];
+            auto *instances = mInstanceData.Find(drawable.Instances);
 
-            for (auto &instance : instances)
+            if (instances == nullptr)
+                continue;
+
+            for (auto &instance : *instances)
             {
                 mGraphicsPipeline.PushConstants(cmd, instance.Transform);
 
@@ -147,10 +150,13 @@ void HelloRenderer::RecreateSwapchainResources()
 
 void HelloRenderer::LoadScene(const Scene &scene)
 {
-    if (scene.UpdateMeshesRequested())
+    // Loading meshes skips primitives which already have drawables,
+    // so changed meshes only upload their new primitives:
+    if (scene.UpdateMeshesRequested() || scene.MeshesChanged())
         LoadMeshes(scene);
 
-    if (scene.UpdateObjectsRequested())
+    // Instances are cheap to rebuild here, so changed objects reload all of them:
+    if (scene.UpdateObjectsRequested() || scene.ObjectsChanged() || scene.MeshesChanged())
         LoadObjects(scene);
 }
 
@@ -174,30 +180,52 @@ void HelloRenderer::LoadMeshes(const Scene &scene)
         // Create Index buffer:
         drawable.IndexBuffer = MakeBuffer::Index(mCtx, debugName, geo.IndexData);
         drawable.IndexCount  = static_cast<uint32_t>(geo.IndexCount);
+        drawable.IndexType   = geo.Layout.IndexType;
 
         // Update deletion queue:
         mSceneDeletionQueue.push_back(drawable.VertexBuffer);
         mSceneDeletionQueue.push_back(drawable.IndexBuffer);
     };
 
-    for (const auto &[meshKey, mesh] : scene.Meshes)
+    // Prune drawables of erased meshes, their buffers are owned by the deletion queue:
+    mMeshDrawables.EraseIf([&](SceneKey meshKey, const auto &drawableKeys) {
+        if (scene.Meshes.Contains(meshKey))
+            return false;
+
+        for (auto key : drawableKeys)
+        {
+            if (key.has_value())
+                mDrawables.Erase(*key);
+        }
+
+        return true;
+    });
+
+    for (const auto [meshKey, mesh] : scene.Meshes)
     {
+        auto &drawableKeys = mMeshDrawables.FindOrEmplace(meshKey);
+        drawableKeys.resize(mesh.Primitives.size());
+
         for (const auto [primIdx, prim] : enumerate(mesh.Primitives))
         {
-            auto drawableKey = DrawableKey{meshKey, primIdx};
-
             // Already imported:
-            if (mDrawables.count(drawableKey) != 0)
+            if (drawableKeys[primIdx].has_value())
                 continue;
 
-            if (mGeometryLayout == prim.Data.Layout)
+            // Still being loaded:
+            if (prim.Data.VertexCount == 0)
+                continue;
+
+            if (mVertexLayout == prim.Data.Layout.VertexLayout)
             {
-                auto &drawable = mDrawables[drawableKey];
+                auto [drawableKey, drawable] = mDrawables.Emplace();
 
                 const auto primName = mesh.Name + std::to_string(primIdx);
 
                 CreateBuffers(drawable, prim.Data, primName);
                 drawable.Instances = meshKey;
+
+                drawableKeys[primIdx] = drawableKey;
             }
         }
     }
@@ -205,17 +233,16 @@ void HelloRenderer::LoadMeshes(const Scene &scene)
 
 void HelloRenderer::LoadObjects(const Scene &scene)
 {
-    for (auto &[_, instances] : mInstanceData)
-        instances.clear();
+    mInstanceData.Clear();
 
-    for (const auto &[key, obj] : scene.Objects)
+    for (const auto [key, obj] : scene.Objects)
     {
         if (!obj.Mesh.has_value())
             continue;
 
         auto meshKey = *obj.Mesh;
 
-        auto &instances = mInstanceData[meshKey];
+        auto &instances = mInstanceData.FindOrEmplace(meshKey);
         instances.push_back(InstanceData{.Transform = obj.Transform});
     }
 }
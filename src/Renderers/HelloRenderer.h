@@ -3,10 +3,12 @@
 #include "DynamicUniformBuffer.h"
 #include "Pipeline.h"
 #include "Renderer.h"
+#include "SlotMap.h"
 
 #include "volk.h"
 
-#include <map>
+#include <optional>
+#include <vector>
 
 class HelloRenderer final : public IRenderer {
   public:
@@ -39,30 +41,32 @@ class HelloRenderer final : public IRenderer {
 
     Pipeline mGraphicsPipeline;
 
-    GeometryLayout mGeometryLayout{
-        .VertexLayout = Vertex::PushLayout{.HasColor = true},
-        .IndexType    = VK_INDEX_TYPE_UINT16,
-    };
+    // Supported vertex layout, index type is handled per drawable:
+    Vertex::Layout mVertexLayout = Vertex::PushLayout{.HasColor = true};
 
     struct Drawable {
         Buffer   VertexBuffer;
         uint32_t VertexCount;
 
-        Buffer   IndexBuffer;
-        uint32_t IndexCount;
+        Buffer      IndexBuffer;
+        uint32_t    IndexCount;
+        VkIndexType IndexType;
 
         SceneKey Instances;
     };
 
-    using DrawableKey = std::pair<SceneKey, size_t>;
+    using DrawableKey = SlotKey;
+
+    SlotMap<Drawable> mDrawables;
 
-    std::map<DrawableKey, Drawable> mDrawables;
+    // Drawables of each mesh, indexed by primitive id:
+    SecondaryMap<std::vector<std::optional<DrawableKey>>> mMeshDrawables;
 
     struct InstanceData {
         glm::mat4 Transform;
     };
 
-    std::map<SceneKey, std::vector<InstanceData>> mInstanceData;
+    SecondaryMap<std::vector<InstanceData>> mInstanceData;
 
     struct UBOData {
         glm::mat4 CameraViewProjection = glm::mat4(1.0f);
@@ -78,7 +78,7 @@ void Minimal3DRenderer::RebuildPipelines()
         PipelineBuilder("Minimal3DColoredPipeline")
             .SetShaderPathVertex("assets/spirv/Minimal3DColoredVert.spv")
             .SetShaderPathFragment("assets/spirv/Minimal3DColoredFrag.spv")
-            .SetVertexInput(mColoredLayout.VertexLayout, 0, VK_VERTEX_INPUT_RATE_VERTEX)
+            .SetVertexInput(mColoredLayout, 0, VK_VERTEX_INPUT_RATE_VERTEX)
             .SetTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
             .SetPolygonMode(VK_POLYGON_MODE_FILL)
             .SetCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
@@ -93,7 +93,7 @@ void Minimal3DRenderer::RebuildPipelines()
         PipelineBuilder("Minimal3DTexturedPipeline")
             .SetShaderPathVertex("assets/spirv/Minimal3DTexturedVert.spv")
             .SetShaderPathFragment("assets/spirv/Minimal3DTexturedFrag.spv")
-            .SetVertexInput(mTexturedLayout.VertexLayout, 0, VK_VERTEX_INPUT_RATE_VERTEX)
+            .SetVertexInput(mTexturedLayout, 0, VK_VERTEX_INPUT_RATE_VERTEX)
             .SetTopology(VK_PRIMITIVE_TOPOLOGY_TRIANGLE_LIST)
             .SetPolygonMode(VK_POLYGON_MODE_FILL)
             .SetCullMode(VK_CULL_MODE_BACK_BIT, VK_FRONT_FACE_COUNTER_CLOCKWISE)
@@ -140,14 +140,16 @@ void Minimal3DRenderer::OnRender([[maybe_unused]] std::optional<SceneKey> highli
 
         mColoredPipeline.BindDescriptorSet(cmd, mDynamicDS.DescriptorSet(), 0);
 
-        for (auto &[_, drawable] : mColoredDrawables)
+        for (auto key : mColoredDrawableKeys)
         {
+            auto &drawable = mDrawables[key];
+
             VkBuffer     vertBuffer = drawable.VertexBuffer.Handle;
             VkDeviceSize vertOffset = 0;
             vkCmdBindVertexBuffers(cmd, 0, 1, &vertBuffer, &vertOffset);
 
             vkCmdBindIndexBuffer(cmd, drawable.IndexBuffer.Handle, 0,
-                                 mColoredLayout.IndexType);
+                                 drawable.IndexType);
 
             for (auto &transform : drawable.Instances)
             {
@@ -163,16 +165,18 @@ void Minimal3DRenderer::OnRender([[maybe_unused]] std::optional<SceneKey> highli
 
         mTexturedPipeline.BindDescriptorSet(cmd, mDynamicDS.DescriptorSet(), 0);
 
-        for (auto &[_, drawable] : mTexturedDrawables)
+        for (auto key : mTexturedDrawableKeys)
         {
+            auto &drawable = mDrawables[key];
+
             VkBuffer     vertBuffer = drawable.VertexBuffer.Handle;
             VkDeviceSize vertOffset = 0;
             vkCmdBindVertexBuffers(cmd, 0, 1, &vertBuffer, &vertOffset);
 
             vkCmdBindIndexBuffer(cmd, drawable.IndexBuffer.Handle, 0,
-                                 mTexturedLayout.IndexType);
+                                 drawable.IndexType);
 
-            auto &material = mMaterials.at(drawable.Material);
+            auto &material = mMaterials[drawable.Material];
             mTexturedPipeline.BindDescriptorSet(cmd, material.DescriptorSet, 1);
 
             for (auto &transform : drawable.Instances)
@@ -237,7 +241,9 @@ void Minimal3DRenderer::RecreateSwapchainResources()
 
 void Minimal3DRenderer::LoadScene(const Scene &scene)
 {
-    if (scene.UpdateMeshesRequested())
+    // Loading meshes skips primitives which already have drawables,
+    // so changed meshes only upload their new primitives:
+    if (scene.UpdateMeshesRequested() || scene.MeshesChanged())
         LoadMeshes(scene);
 
     if (scene.UpdateImagesRequested())
@@ -246,10 +252,11 @@ void Minimal3DRenderer::LoadScene(const Scene &scene)
     if (scene.UpdateMaterialsRequested())
         LoadMaterials(scene);
 
-    if (scene.UpdateMeshMaterialsRequested())
+    if (scene.UpdateMeshMaterialsRequested() || scene.MeshesChanged())
         LoadMeshMaterials(scene);
 
-    if (scene.UpdateObjectsRequested())
+    // Instances are cheap to rebuild here, so changed objects reload all of them:
+    if (scene.UpdateObjectsRequested() || scene.ObjectsChanged() || scene.MeshesChanged())
         LoadObjects(scene);
 }
 
@@ -273,36 +280,69 @@ void Minimal3DRenderer::LoadMeshes(const Scene &scene)
         // Create Index buffer:
         drawable.IndexBuffer = MakeBuffer::Index(mCtx, debugName, geo.IndexData);
         drawable.IndexCount  = static_cast<uint32_t>(geo.IndexCount);
+        drawable.IndexType   = geo.Layout.IndexType;
 
         mSceneDeletionQueue.push_back(drawable.VertexBuffer);
         mSceneDeletionQueue.push_back(drawable.IndexBuffer);
     };
 
-    for (const auto &[meshKey, mesh] : scene.Meshes)
+    // Prune drawables of erased meshes, their buffers are owned by the deletion queue:
+    const size_t pruned = mMeshDrawables.EraseIf([&](SceneKey meshKey, const auto &keys) {
+        if (scene.Meshes.Contains(meshKey))
+            return false;
+
+        for (auto key : keys)
+        {
+            if (key.has_value())
+                mDrawables.Erase(*key);
+        }
+
+        return true;
+    });
+
+    if (pruned > 0)
     {
+        auto Orphaned = [&](DrawableKey key) { return !mDrawables.Contains(key); };
+
+        std::erase_if(mColoredDrawableKeys, Orphaned);
+        std::erase_if(mTexturedDrawableKeys, Orphaned);
+    }
+
+    for (const auto [meshKey, mesh] : scene.Meshes)
+    {
+        auto &drawableKeys = mMeshDrawables.FindOrEmplace(meshKey);
+        drawableKeys.resize(mesh.Primitives.size());
+
         for (const auto [primIdx, prim] : enumerate(mesh.Primitives))
         {
-            auto drawableKey = DrawableKey{meshKey, primIdx};
-
             // Already imported:
-            if (mTexturedDrawables.count(drawableKey) != 0 ||
-                mTexturedDrawables.count(drawableKey) != 0)
+            if (drawableKeys[primIdx].has_value())
+                continue;
+
+            // Still being loaded:
+            if (prim.Data.VertexCount == 0)
                 continue;
 
             const auto primName = mesh.Name + std::to_string(primIdx);
 
-            if (mColoredLayout == prim.Data.Layout)
+            if (mColoredLayout == prim.Data.Layout.VertexLayout)
             {
-                auto &drawable = mColoredDrawables[drawableKey];
+                auto [drawableKey, drawable] = mDrawables.Emplace();
 
                 CreateBuffers(drawable, prim.Data, primName);
+
+                drawableKeys[primIdx] = drawableKey;
+                mColoredDrawableKeys.push_back(drawableKey);
             }
 
-            if (mTexturedLayout == prim.Data.Layout)
+            if (mTexturedLayout == prim.Data.Layout.VertexLayout)
             {
-                auto &drawable = mTexturedDrawables[drawableKey];
+                auto [drawableKey, drawable] = mDrawables.Emplace();
 
                 CreateBuffers(drawable, prim.Data, primName);
+
+                drawableKeys[primIdx] = drawableKey;
+                mTexturedDrawableKeys.push_back(drawableKey);
             }
         }
     }
@@ -310,12 +350,16 @@ void Minimal3DRenderer::LoadMeshes(const Scene &scene)
 
 void Minimal3DRenderer::LoadImages(const Scene &scene)
 {
-    for (auto &[key, imgData] : scene.Images)
+    for (const auto [key, imgData] : scene.Images)
     {
-        if (mImages.count(key) != 0)
+        if (mImages.Contains(key))
             continue;
 
-        auto &texture = mImages[key];
+        // Still being decoded:
+        if (imgData.Data == nullptr)
+            continue;
+
+        auto &texture = mImages.Emplace(key);
 
         texture = MakeTexture::FromData(mCtx, "MaterialTexture", imgData);
 
@@ -325,10 +369,10 @@ void Minimal3DRenderer::LoadImages(const Scene &scene)
 
 void Minimal3DRenderer::LoadMaterials(const Scene &scene)
 {
-    for (auto &[key, sceneMat] : scene.Materials)
+    for (const auto [key, sceneMat] : scene.Materials)
     {
-        const bool firstLoad = mMaterials.count(key) == 0;
-        auto      &mat       = mMaterials[key];
+        const bool firstLoad = !mMaterials.Contains(key);
+        auto      &mat       = mMaterials.FindOrEmplace(key);
 
         // Allocate descripor set only on first load:
         if (firstLoad)
@@ -345,8 +389,8 @@ void Minimal3DRenderer::LoadMaterials(const Scene &scene)
 
         if (auto albedo = sceneMat.Albedo)
         {
-            if (mImages.count(*albedo) != 0)
-                texture = mImages[*albedo];
+            if (auto *image = mImages.Find(*albedo))
+                texture = *image;
         }
 
         // Update the descriptor set:
@@ -360,15 +404,13 @@ void Minimal3DRenderer::LoadMeshMaterials(const Scene &scene)
 {
     using namespace std::views;
 
-    for (const auto &[meshKey, mesh] : scene.Meshes)
+    for (const auto [meshKey, mesh] : scene.Meshes)
     {
         for (const auto [primIdx, prim] : enumerate(mesh.Primitives))
         {
-            auto drawableKey = DrawableKey{meshKey, primIdx};
-
-            if (mTexturedDrawables.count(drawableKey) != 0)
+            if (auto drawableKey = FindDrawable(meshKey, primIdx))
             {
-                auto &drawable = mTexturedDrawables[drawableKey];
+                auto &drawable = mDrawables[*drawableKey];
 
                 if (prim.Material)
                     drawable.Material = *prim.Material;
@@ -381,32 +423,31 @@ void Minimal3DRenderer::LoadObjects(const Scene &scene)
 {
     using namespace std::views;
 
-    for (auto &[_, drawable] : mColoredDrawables)
-        drawable.Instances.clear();
-
-    for (auto &[_, drawable] : mTexturedDrawables)
+    for (auto [_, drawable] : mDrawables)
         drawable.Instances.clear();
 
-    for (const auto &[key, obj] : scene.Objects)
+    for (const auto [key, obj] : scene.Objects)
     {
         if (!obj.Mesh.has_value())
             continue;
 
         auto meshKey = *obj.Mesh;
 
-        for (const auto [primIdx, _] : enumerate(scene.Meshes.at(meshKey).Primitives))
+        for (const auto [primIdx, _] : enumerate(scene.Meshes[meshKey].Primitives))
         {
-            auto drawableKey = DrawableKey{meshKey, primIdx};
-
-            if (mColoredDrawables.count(drawableKey) != 0)
-            {
-                mColoredDrawables[drawableKey].Instances.push_back(obj.Transform);
-            }
-
-            else if (mTexturedDrawables.count(drawableKey) != 0)
-            {
-                mTexturedDrawables[drawableKey].Instances.push_back(obj.Transform);
-            }
+            if (auto drawableKey = FindDrawable(meshKey, primIdx))
+                mDrawables[*drawableKey].Instances.push_back(obj.Transform);
         }
     }
 }
+
+std::optional<Minimal3DRenderer::DrawableKey> Minimal3DRenderer::FindDrawable(
+    SceneKey meshKey, size_t primIdx) const
+{
+    const auto *drawableKeys = mMeshDrawables.Find(meshKey);
+
+    if (drawableKeys == nullptr || primIdx >= drawableKeys->size())
+        return std::nullopt;
+
+    return (*drawableKeys)[primIdx];
+}
@@ -5,6 +5,7 @@
 #include "Pipeline.h"
 #include "Renderer.h"
 #include "Scene.h"
+#include "SlotMap.h"
 #include "Texture.h"
 #include "VertexLayout.h"
 
@@ -45,35 +46,42 @@ class Minimal3DRenderer final : public IRenderer {
     Pipeline mColoredPipeline;
     Pipeline mTexturedPipeline;
 
-    GeometryLayout mColoredLayout{
-        .VertexLayout = Vertex::PushLayout{.HasNormal = true, .HasColor = true},
-        .IndexType    = VK_INDEX_TYPE_UINT32,
-    };
+    // Supported vertex layouts, index type is handled per drawable:
+    Vertex::Layout mColoredLayout =
+        Vertex::PushLayout{.HasNormal = true, .HasColor = true};
 
-    GeometryLayout mTexturedLayout{
-        .VertexLayout = Vertex::PushLayout{.HasTexCoord = true, .HasNormal = true},
-        .IndexType    = VK_INDEX_TYPE_UINT32,
-    };
+    Vertex::Layout mTexturedLayout =
+        Vertex::PushLayout{.HasTexCoord = true, .HasNormal = true};
 
     struct Drawable {
         Buffer   VertexBuffer;
         uint32_t VertexCount;
 
-        Buffer   IndexBuffer;
-        uint32_t IndexCount;
+        Buffer      IndexBuffer;
+        uint32_t    IndexCount;
+        VkIndexType IndexType;
 
         SceneKey Material;
 
         std::vector<glm::mat4> Instances;
     };
 
-    using DrawableKey = std::pair<SceneKey, size_t>;
+    using DrawableKey = SlotKey;
+
+    SlotMap<Drawable> mDrawables;
+
+    // Drawables split by the pipeline they are drawn with:
+    std::vector<DrawableKey> mColoredDrawableKeys;
+    std::vector<DrawableKey> mTexturedDrawableKeys;
+
+    // Drawables of each mesh, indexed by primitive id:
+    SecondaryMap<std::vector<std::optional<DrawableKey>>> mMeshDrawables;
 
-    std::map<DrawableKey, Drawable> mColoredDrawables;
-    std::map<DrawableKey, Drawable> mTexturedDrawables;
+    [[nodiscard]] std::optional<DrawableKey> FindDrawable(SceneKey meshKey,
+                                                          size_t   primIdx) const;
 
-    Texture                     mDefaultImage;
-    std::map<SceneKey, Texture> mImages;
+    Texture               mDefaultImage;
+    SecondaryMap<Texture> mImages;
 
     VkDescriptorSetLayout       mTextureDescriptorSetLayout;
     GrowableDescriptorAllocator mTextureDescriptorAllocator;
@@ -83,7 +91,7 @@ class Minimal3DRenderer final : public IRenderer {
         VkDescriptorSet DescriptorSet;
     };
 
-    std::map<SceneKey, Material> mMaterials;
+    SecondaryMap<Material> mMaterials;
 
     // For textured pipeline to also upload alpha cutoff:
     struct PushConstantData {
@@ -22,11 +22,20 @@
 
 #include "volk.h"
 
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
+#include <limits>
 #include <optional>
 #include <ranges>
 #include <utility>
 
+// Leaf value of an instance in the instance tree:
+static uint64_t PackInstance(SlotKey drawableKey, size_t instanceIdx)
+{
+    return (static_cast<uint64_t>(drawableKey) << 32) | instanceIdx;
+}
+
 void MinimalPbrRenderer::Drawable::Init(VulkanContext &ctx, const ScenePrimitive &prim,
                                         const std::string &debugName)
 {
@@ -47,10 +56,16 @@ void MinimalPbrRenderer::Drawable::Init(VulkanContext &ctx, const ScenePrimitive
     // Create Index buffer:
     IndexBuffer = MakeBuffer::Index(ctx, debugName, geo.IndexData);
     IndexCount  = static_cast<uint32_t>(geo.IndexCount);
+    IndexType   = geo.Layout.IndexType;
+    Lods        = geo.Lods;
+    Meshlets    = geo.Meshlets;
 
     Bbox            = prim.Data.BBox;
     TexBoundsCenter = prim.TexCoordCenter;
     TexBoundsExtent = prim.TexCoordExtent;
+
+    BaseTransform = glm::translate(glm::mat4(1.0f), prim.BaseOffset) *
+                    glm::scale(glm::mat4(1.0f), prim.BaseScale);
 }
 
 void MinimalPbrRenderer::Drawable::Destroy(VulkanContext &ctx)
@@ -59,35 +74,69 @@ void MinimalPbrRenderer::Drawable::Destroy(VulkanContext &ctx)
     vmaDestroyBuffer(ctx.Allocator, IndexBuffer.Handle, IndexBuffer.Allocation);
 }
 
-bool MinimalPbrRenderer::Drawable::EarlyBail(glm::mat4 viewProj)
+bool MinimalPbrRenderer::Drawable::IsVisible(const Frustum &frustum, size_t instanceIdx)
 {
-    if (Instances.empty())
-        return true;
+    return frustum.Intersects(Instances[instanceIdx].WorldBounds);
+}
+
+size_t MinimalPbrRenderer::Drawable::SelectLod(glm::mat4 viewProj, size_t instanceIdx,
+                                               glm::vec2 resolution, float pixelError)
+{
+    if (Lods.empty())
+        return 0;
 
-    if (Instances.size() == 1)
+    auto mvp = viewProj * Instances[instanceIdx].Transform;
+
+    glm::vec2 ndcMin(std::numeric_limits<float>::max());
+    glm::vec2 ndcMax(std::numeric_limits<float>::lowest());
+
+    for (auto vert : Bbox.GetVertices())
     {
-        if (!Bbox.IsInView(viewProj * Instances[0].Transform))
-        {
-            return true;
-        }
+        auto clip = mvp * glm::vec4(vert, 1.0f);
+
+        // Box reaches behind the camera, it is as close as it gets:
+        if (clip.w <= 0.0f)
+            return 0;
+
+        auto ndc = glm::vec2(clip) / clip.w;
+        ndcMin   = glm::min(ndcMin, ndc);
+        ndcMax   = glm::max(ndcMax, ndc);
     }
 
-    return false;
+    // Lod errors are relative to the bounding box diagonal, which is
+    // approximated by the larger screen extent of the projected box:
+    auto  extent = 0.5f * (ndcMax - ndcMin) * resolution;
+    float size   = std::max(extent.x, extent.y);
+
+    // Errors only grow with each level:
+    size_t lod = 0;
+
+    while (lod < Lods.size() && Lods[lod].Error * size <= pixelError)
+        lod++;
+
+    return lod;
 }
 
-bool MinimalPbrRenderer::Drawable::IsVisible(glm::mat4 viewProj, size_t instanceIdx)
+void MinimalPbrRenderer::Drawable::BindGeometryBuffers(VkCommandBuffer cmd)
 {
-    return Bbox.IsInView(viewProj * Instances[instanceIdx].Transform);
+    vkCmdBindIndexBuffer(cmd, IndexBuffer.Handle, 0, IndexType);
 }
 
-void MinimalPbrRenderer::Drawable::BindGeometryBuffers(VkCommandBuffer cmd)
+void MinimalPbrRenderer::Drawable::Draw(VkCommandBuffer cmd, size_t lod)
 {
-    vkCmdBindIndexBuffer(cmd, IndexBuffer.Handle, 0, MinimalPbrRenderer::IndexType);
+    if (lod == 0)
+    {
+        vkCmdDrawIndexed(cmd, IndexCount, 1, 0, 0, 0);
+        return;
+    }
+
+    const auto &range = Lods[lod - 1];
+    vkCmdDrawIndexed(cmd, range.IndexCount, 1, range.FirstIndex, 0, 0);
 }
 
-void MinimalPbrRenderer::Drawable::Draw(VkCommandBuffer cmd)
+uint32_t MinimalPbrRenderer::Drawable::GetIndexCount(size_t lod) const
 {
-    vkCmdDrawIndexed(cmd, IndexCount, 1, 0, 0, 0);
+    return (lod == 0) ? IndexCount : Lods[lod - 1].IndexCount;
 }
 
 void MinimalPbrRenderer::DestroyTexture(const Texture &texture)
@@ -99,7 +148,8 @@ void MinimalPbrRenderer::DestroyTexture(const Texture &texture)
 MinimalPbrRenderer::MinimalPbrRenderer(VulkanContext &ctx, FrameInfo &info,
                                        Camera &camera)
     : IRenderer(ctx, info, camera), mCamDynamicUBO(ctx, info, sizeof(mCamDynamicUBO)),
-      mDynamicUBO(ctx, info, sizeof(mUBOData)), mDynamicDS(ctx, info),
+      mDynamicUBO(ctx, info, sizeof(mUBOData)),
+      mMeshletDraws(ctx, info, MeshletDrawBufferSize), mDynamicDS(ctx, info),
       mMaterialDescriptorAllocator(ctx), mEnvHandler(ctx), mShadowmapHandler(ctx),
       mAOHandler(ctx, camera), mPostProcessor(ctx), mSceneDeletionQueue(ctx),
       mMaterialDeletionQueue(ctx)
@@ -194,10 +244,10 @@ MinimalPbrRenderer::MinimalPbrRenderer(VulkanContext &ctx, FrameInfo &info,
 
 MinimalPbrRenderer::~MinimalPbrRenderer()
 {
-    for (auto &[_, drawable] : mDrawables)
+    for (auto [_, drawable] : mDrawables)
         drawable.Destroy(mCtx);
 
-    for (auto &[_, tex] : mTextures)
+    for (auto [_, tex] : mTextures)
         DestroyTexture(tex);
 }
 
@@ -209,6 +259,14 @@ VkCompareOp MinimalPbrRenderer::GetMainCompareOp() const
         return VK_COMPARE_OP_LESS;
 }
 
+std::optional<glm::vec2> MinimalPbrRenderer::GetLodResolution(VkExtent2D extent) const
+{
+    if (!mEnableLods)
+        return std::nullopt;
+
+    return glm::vec2(extent.width, extent.height);
+}
+
 void MinimalPbrRenderer::RebuildPipelines()
 {
     mPipelineDeletionQueue.flush();
@@ -342,7 +400,7 @@ void MinimalPbrRenderer::RebuildPipelines()
 
     // Rebuild component pipelines as well:
     ShadowmapHandler::PipelineInfo info{
-        .VertexLayout         = mGeometryLayout.VertexLayout,
+        .VertexLayout         = mVertexLayout,
         .MaterialDSLayout     = mMaterialDescriptorSetLayout,
         .ColorFormat          = RenderTargetFormat,
         .DepthFormat          = DepthStencilFormat,
@@ -517,6 +575,15 @@ void MinimalPbrRenderer::OnImGui()
         }
     }
 
+    ImGui::Checkbox("Enable LODs", &mEnableLods);
+
+    if (mEnableLods)
+        ImGui::SliderFloat("LOD Pixel Error", &mLodPixelError, 0.1f, 8.0f);
+
+    ImGui::Checkbox("Cull Meshlets", &mCullMeshlets);
+    ImGui::Text("Meshlet draws: %.2f KiB",
+                static_cast<double>(mMeshletDraws.UsedSize()) / 1024.0);
+
     ImGui::SliderFloat("Directional Factor", &mUBOData.DirectionalFactor, 0.0f, 6.0f);
     ImGui::SliderFloat("Environment Factor", &mUBOData.EnvironmentFactor, 0.0f, 1.0f);
     ImGui::SliderFloat("Environment Saturation", &mUBOData.EnvSaturation, 0.0f, 2.0f);
@@ -574,6 +641,10 @@ void MinimalPbrRenderer::OnRender([[maybe_unused]] std::optional<SceneKey> highl
     // and as such need to be acquired after new image index is set.
     mCamDynamicUBO.UpdateData(&mCamUBOData, sizeof(mCamUBOData));
     mDynamicUBO.UpdateData(&mUBOData, sizeof(mUBOData));
+    mMeshletDraws.Reset();
+
+    // Views are culled anew each frame:
+    mCulledViews = 0;
 
     DrawStats stats{};
 
@@ -615,99 +686,241 @@ void MinimalPbrRenderer::TargetToTransfer(VkCommandBuffer cmd)
     (void)cmd;
 }
 
+std::optional<MinimalPbrRenderer::MeshletDraws> MinimalPbrRenderer::CompactMeshlets(
+    const Drawable &drawable, glm::mat4 viewProj, size_t instanceIdx, bool cullBackfaces)
+{
+    const auto transform = drawable.Instances[instanceIdx].Transform;
+    const auto mvp       = viewProj * transform;
+
+    // Viewer in the space of the meshlets, a point or a direction
+    // for orthographic projections. Cones don't survive mirroring:
+    const auto eye = glm::inverse(mvp) * glm::vec4(0.0f, 0.0f, 1.0f, 0.0f);
+    cullBackfaces  = cullBackfaces && glm::determinant(glm::mat3(transform)) > 0.0f;
+
+    // Meshlets are consecutive in the index buffer, so visible neighbours
+    // are merged into runs drawn by a single command:
+    mMeshletRuns.clear();
+    uint32_t indexCount   = 0;
+    size_t   visibleCount = 0;
+
+    for (const auto &meshlet : drawable.Meshlets)
+    {
+        if (!meshlet.IsInView(mvp))
+            continue;
+
+        if (cullBackfaces && meshlet.IsBackfacing(eye))
+            continue;
+
+        visibleCount++;
+        indexCount += meshlet.IndexCount;
+
+        if (!mMeshletRuns.empty())
+        {
+            auto &last = mMeshletRuns.back();
+
+            if (last.firstIndex + last.indexCount == meshlet.FirstIndex)
+            {
+                last.indexCount += meshlet.IndexCount;
+                continue;
+            }
+        }
+
+        mMeshletRuns.push_back(VkDrawIndexedIndirectCommand{
+            .indexCount    = meshlet.IndexCount,
+            .instanceCount = 1,
+            .firstIndex    = meshlet.FirstIndex,
+            .vertexOffset  = 0,
+            .firstInstance = 0,
+        });
+    }
+
+    // Nothing was culled, the original range does just as well:
+    if (visibleCount == drawable.Meshlets.size())
+        return std::nullopt;
+
+    if (mMeshletRuns.empty())
+        return MeshletDraws{.Offset = 0, .DrawCount = 0, .IndexCount = 0};
+
+    const auto size  = mMeshletRuns.size() * sizeof(VkDrawIndexedIndirectCommand);
+    const auto align = alignof(VkDrawIndexedIndirectCommand);
+    const auto alloc = mMeshletDraws.Allocate(size, align);
+
+    // Out of space for this frame, draw everything:
+    if (!alloc.has_value())
+        return std::nullopt;
+
+    std::memcpy(alloc->Data, mMeshletRuns.data(), size);
+
+    return MeshletDraws{
+        .Offset     = alloc->Offset,
+        .DrawCount  = static_cast<uint32_t>(mMeshletRuns.size()),
+        .IndexCount = indexCount,
+    };
+}
+
+MinimalPbrRenderer::ViewVisibility &MinimalPbrRenderer::CullView(glm::mat4 viewProj)
+{
+    for (size_t i = 0; i < mCulledViews; i++)
+    {
+        if (mViews[i].ViewProj == viewProj)
+            return mViews[i];
+    }
+
+    if (mCulledViews == mViews.size())
+        mViews.emplace_back();
+
+    auto &view    = mViews[mCulledViews++];
+    view.ViewProj = viewProj;
+
+    // Lists keep their capacity between frames:
+    for (auto [_, list] : view.Instances)
+        list.clear();
+
+    view.Meshlets.clear();
+    view.CullMeshlets = true;
+
+    mVisibleInstances.clear();
+    mInstanceTree.QueryFrustum(Frustum::FromMatrix(viewProj), mVisibleInstances);
+
+    for (const uint64_t packed : mVisibleInstances)
+    {
+        const auto drawableKey = static_cast<DrawableKey>(packed >> 32);
+        const auto instanceIdx = static_cast<uint32_t>(packed);
+
+        view.Instances.FindOrEmplace(drawableKey).push_back(instanceIdx);
+    }
+
+    return view;
+}
+
 template <typename MaterialFn, typename InstanceFn>
-void MinimalPbrRenderer::DrawAllInstancesCulled(VkCommandBuffer cmd, Drawable &drawable,
-                                                glm::mat4  viewProj,
-                                                MaterialFn materialCallback,
-                                                InstanceFn instanceCallback,
-                                                DrawStats &stats)
+void MinimalPbrRenderer::DrawAllInstancesCulled(VkCommandBuffer cmd,
+                                                DrawableKey     drawableKey,
+                                                glm::mat4       viewProj,
+                                                std::optional<glm::vec2> lodResolution,
+                                                MaterialFn               materialCallback,
+                                                InstanceFn               instanceCallback,
+                                                DrawStats               &stats)
 {
-    using namespace std::views;
+    auto       &view    = CullView(viewProj);
+    const auto *visible = view.Instances.Find(drawableKey);
 
     // If there are no instances to draw, bail before binding anything.
-    if (drawable.EarlyBail(viewProj))
+    if (visible == nullptr || visible->empty())
         return;
 
+    auto &drawable = mDrawables[drawableKey];
+
     // Bind drawable geometry buffers:
     drawable.BindGeometryBuffers(cmd);
 
+    const bool cullMeshlets = mCullMeshlets && view.CullMeshlets;
+
     // Bind drawable material descriptor set:
-    auto &material = mMaterials.at(drawable.MaterialKey);
+    auto &material = mMaterials[drawable.MaterialKey];
     materialCallback(cmd, material);
 
+    // Normal cones are only usable if back faces aren't drawn anyway:
+    const bool cullBackfaces = material.UboData.DoubleSided == 0;
+
     // Push per-instance data and issue draw commands:
-    for (auto [idx, instance] : enumerate(drawable.Instances))
+    for (const uint32_t idx : *visible)
     {
-        // Do frustum culling:
-        if (!drawable.IsVisible(viewProj, idx))
+        auto &instance = drawable.Instances[idx];
+
+        size_t lod = 0;
+
+        if (lodResolution.has_value())
+            lod = drawable.SelectLod(viewProj, idx, *lodResolution, mLodPixelError);
+
+        // Full detail geometry is further culled per meshlet:
+        std::optional<MeshletDraws> meshlets;
+
+        if (lod == 0 && cullMeshlets && !drawable.Meshlets.empty())
+        {
+            const auto packed   = PackInstance(drawableKey, idx);
+            auto [it, inserted] = view.Meshlets.try_emplace(packed);
+
+            if (inserted)
+                it->second = CompactMeshlets(drawable, viewProj, idx, cullBackfaces);
+
+            meshlets = it->second;
+        }
+
+        if (meshlets.has_value() && meshlets->DrawCount == 0)
             continue;
 
         // Callback for per-instance binds:
         instanceCallback(cmd, drawable, instance);
 
-        drawable.Draw(cmd);
+        if (meshlets.has_value())
+        {
+            vkCmdDrawIndexedIndirect(cmd, mMeshletDraws.CurrentBuffer(), meshlets->Offset,
+                                     meshlets->DrawCount,
+                                     sizeof(VkDrawIndexedIndirectCommand));
+
+            stats.NumIdx += meshlets->IndexCount;
+        }
+        else
+        {
+            drawable.Draw(cmd, lod);
+            stats.NumIdx += drawable.GetIndexCount(lod);
+        }
 
         stats.NumDraws++;
-        stats.NumIdx += drawable.IndexCount;
     }
 
     stats.NumBinds += 3;
 }
 
 template <typename MaterialFn, typename InstanceFn>
-void MinimalPbrRenderer::DrawSingleSidedFrustumCulled(VkCommandBuffer cmd,
-                                                      glm::mat4       viewProj,
-                                                      MaterialFn      materialCallback,
-                                                      InstanceFn      instanceCallback,
-                                                      DrawStats      &stats)
+void MinimalPbrRenderer::DrawSingleSidedFrustumCulled(
+    VkCommandBuffer cmd, glm::mat4 viewProj, std::optional<glm::vec2> lodResolution,
+    MaterialFn materialCallback, InstanceFn instanceCallback, DrawStats &stats)
 {
     vkCmdSetCullMode(cmd, VK_CULL_MODE_BACK_BIT);
 
     for (auto key : mSingleSidedDrawableKeys)
     {
-        auto &drawable = mDrawables[key];
-
-        DrawAllInstancesCulled(cmd, drawable, viewProj, materialCallback,
+        DrawAllInstancesCulled(cmd, key, viewProj, lodResolution, materialCallback,
                                instanceCallback, stats);
     }
 }
 
 template <typename MaterialFn, typename InstanceFn>
-void MinimalPbrRenderer::DrawDoubleSidedFrustumCulled(VkCommandBuffer cmd,
-                                                      glm::mat4       viewProj,
-                                                      MaterialFn      materialCallback,
-                                                      InstanceFn      instanceCallback,
-                                                      DrawStats      &stats)
+void MinimalPbrRenderer::DrawDoubleSidedFrustumCulled(
+    VkCommandBuffer cmd, glm::mat4 viewProj, std::optional<glm::vec2> lodResolution,
+    MaterialFn materialCallback, InstanceFn instanceCallback, DrawStats &stats)
 {
     vkCmdSetCullMode(cmd, VK_CULL_MODE_NONE);
 
     for (auto key : mDoubleSidedDrawableKeys)
     {
-        auto &drawable = mDrawables[key];
-
-        DrawAllInstancesCulled(cmd, drawable, viewProj, materialCallback,
+        DrawAllInstancesCulled(cmd, key, viewProj, lodResolution, materialCallback,
                                instanceCallback, stats);
     }
 }
 
 template <typename MaterialFn, typename InstanceFn>
-void MinimalPbrRenderer::DrawBlendedFrustumCulled(VkCommandBuffer cmd, glm::mat4 viewProj,
-                                                  MaterialFn materialCallback,
-                                                  InstanceFn instanceCallback,
-                                                  DrawStats &stats)
+void MinimalPbrRenderer::DrawBlendedFrustumCulled(
+    VkCommandBuffer cmd, glm::mat4 viewProj, std::optional<glm::vec2> lodResolution,
+    MaterialFn materialCallback, InstanceFn instanceCallback, DrawStats &stats)
 {
     vkCmdSetCullMode(cmd, VK_CULL_MODE_BACK_BIT);
 
     for (auto key : mBlendedDrawableKeys)
     {
-        auto &drawable = mDrawables[key];
-        DrawAllInstancesCulled(cmd, drawable, viewProj, materialCallback,
+        DrawAllInstancesCulled(cmd, key, viewProj, lodResolution, materialCallback,
                                instanceCallback, stats);
     }
 }
 
 void MinimalPbrRenderer::ShadowPass(VkCommandBuffer cmd, DrawStats &stats)
 {
+    // All cascades share the resolution, each selects lods with its own matrix:
+    constexpr auto shadowRes = ShadowmapHandler::ShadowmapResolution;
+    auto lodResolution       = GetLodResolution({shadowRes, shadowRes});
+
     auto drawOpaque = [&](VkCommandBuffer cmd, glm::mat4 viewProj) {
         auto materialCallback = [](VkCommandBuffer cmd, Material &material) {
             (void)cmd;
@@ -726,8 +939,11 @@ void MinimalPbrRenderer::ShadowPass(VkCommandBuffer cmd, DrawStats &stats)
             mShadowmapHandler.PushConstantOpaque(cmd, data);
         };
 
-        DrawSingleSidedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback,
-                                     stats);
+        // Meshlets are too small to matter at shadowmap resolution:
+        CullView(viewProj).CullMeshlets = false;
+
+        DrawSingleSidedFrustumCulled(cmd, viewProj, lodResolution, materialCallback,
+                                     instanceCallback, stats);
     };
 
     auto drawAlpha = [&](VkCommandBuffer cmd, glm::mat4 viewProj) {
@@ -748,8 +964,11 @@ void MinimalPbrRenderer::ShadowPass(VkCommandBuffer cmd, DrawStats &stats)
             mShadowmapHandler.PushConstantAlpha(cmd, data);
         };
 
-        DrawDoubleSidedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback,
-                                     stats);
+        // Meshlets are too small to matter at shadowmap resolution:
+        CullView(viewProj).CullMeshlets = false;
+
+        DrawDoubleSidedFrustumCulled(cmd, viewProj, lodResolution, materialCallback,
+                                     instanceCallback, stats);
     };
 
     mShadowmapHandler.DrawShadowmaps(cmd, drawOpaque, drawAlpha);
@@ -773,6 +992,9 @@ void MinimalPbrRenderer::Prepass(VkCommandBuffer cmd, DrawStats &stats)
 
     auto viewProj = mCamUBOData.CameraViewProjection;
 
+    // Must match between the prepass and the main pass:
+    auto lodResolution = GetLodResolution(GetTargetSize());
+
     {
         mZPrepassOpaquePipeline.Bind(cmd);
         common::ViewportScissor(cmd, GetTargetSize());
@@ -796,8 +1018,8 @@ void MinimalPbrRenderer::Prepass(VkCommandBuffer cmd, DrawStats &stats)
             mZPrepassOpaquePipeline.PushConstants(cmd, data);
         };
 
-        DrawSingleSidedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback,
-                                     stats);
+        DrawSingleSidedFrustumCulled(cmd, viewProj, lodResolution, materialCallback,
+                                     instanceCallback, stats);
     }
 
     {
@@ -823,8 +1045,8 @@ void MinimalPbrRenderer::Prepass(VkCommandBuffer cmd, DrawStats &stats)
             mZPrepassAlphaPipeline.PushConstants(cmd, data);
         };
 
-        DrawDoubleSidedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback,
-                                     stats);
+        DrawDoubleSidedFrustumCulled(cmd, viewProj, lodResolution, materialCallback,
+                                     instanceCallback, stats);
     }
 
     vkCmdEndRendering(cmd);
@@ -867,6 +1089,9 @@ void MinimalPbrRenderer::MainPass(VkCommandBuffer cmd, DrawStats &stats)
 
     auto viewProj = mCamUBOData.CameraViewProjection;
 
+    // Must match between the prepass and the main pass:
+    auto lodResolution = GetLodResolution(GetTargetSize());
+
     auto materialCallback = [this, &stats](VkCommandBuffer cmd, Material &material) {
         mMainPipeline.BindDescriptorSet(cmd, material.DescriptorSet, 3);
         stats.NumBinds += 1;
@@ -891,10 +1116,10 @@ void MinimalPbrRenderer::MainPass(VkCommandBuffer cmd, DrawStats &stats)
         vkCmdSetDepthCompareOp(cmd, GetMainCompareOp());
     }
 
-    DrawSingleSidedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback,
-                                 stats);
-    DrawDoubleSidedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback,
-                                 stats);
+    DrawSingleSidedFrustumCulled(cmd, viewProj, lodResolution, materialCallback,
+                                 instanceCallback, stats);
+    DrawDoubleSidedFrustumCulled(cmd, viewProj, lodResolution, materialCallback,
+                                 instanceCallback, stats);
 
     {
         // Enable blending, set depth op to less:
@@ -904,7 +1129,8 @@ void MinimalPbrRenderer::MainPass(VkCommandBuffer cmd, DrawStats &stats)
     }
 
     // TODO: Add sorting by depth:
-    DrawBlendedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback, stats);
+    DrawBlendedFrustumCulled(cmd, viewProj, lodResolution, materialCallback,
+                             instanceCallback, stats);
 
     // At this point debug visuals from the shadow map can optionally be drawn:
     // TODO: This is kind of ugly, but debug needs to have acces to the main depth
@@ -926,18 +1152,14 @@ void MinimalPbrRenderer::OutlinePass(VkCommandBuffer cmd, SceneKey highlightedOb
     {
         mSelectedDrawableKeys.clear();
 
-        for (auto &[key, list] : mObjectCache)
-        {
-            if (key == highlightedObj)
-            {
-                for (auto value : list)
-                    mSelectedDrawableKeys.push_back(value);
-            }
-        }
+        if (auto *list = mObjectCache.Find(highlightedObj))
+            mSelectedDrawableKeys = *list;
 
         mLastHighlightedObjKey = highlightedObj;
     }
 
+    const auto frustum = Frustum::FromMatrix(mCamUBOData.CameraViewProjection);
+
     // Draw to stencil:
     // TODO: this does no check to see if the current drawable is double sided
     // and wheter or not the vkCullState is set accordingly.
@@ -967,13 +1189,13 @@ void MinimalPbrRenderer::OutlinePass(VkCommandBuffer cmd, SceneKey highlightedOb
             auto &drawable = mDrawables[drawableKey];
 
             // Do frustum culling:
-            if (!drawable.IsVisible(mCamUBOData.CameraViewProjection, instanceId))
+            if (!drawable.IsVisible(frustum, instanceId))
                 break;
 
             // Bind all per-drawable resources:
             drawable.BindGeometryBuffers(cmd);
 
-            auto &material = mMaterials.at(drawable.MaterialKey);
+            auto &material = mMaterials[drawable.MaterialKey];
             mStencilPipeline.BindDescriptorSet(cmd, material.DescriptorSet, 1);
 
             // Push per-instance data:
@@ -989,7 +1211,7 @@ void MinimalPbrRenderer::OutlinePass(VkCommandBuffer cmd, SceneKey highlightedOb
             mStencilPipeline.PushConstants(cmd, data);
 
             // Draw:
-            drawable.Draw(cmd);
+            drawable.Draw(cmd, 0);
         }
 
         vkCmdEndRendering(cmd);
@@ -1026,13 +1248,13 @@ void MinimalPbrRenderer::OutlinePass(VkCommandBuffer cmd, SceneKey highlightedOb
             auto &drawable = mDrawables[drawableKey];
 
             // Do frustum culling:
-            if (!drawable.IsVisible(mCamUBOData.CameraViewProjection, instanceId))
+            if (!drawable.IsVisible(frustum, instanceId))
                 break;
 
             // Bind all per-drawable resources:
             drawable.BindGeometryBuffers(cmd);
 
-            auto &material = mMaterials.at(drawable.MaterialKey);
+            auto &material = mMaterials[drawable.MaterialKey];
             mOutlinePipeline.BindDescriptorSet(cmd, material.DescriptorSet, 1);
 
             // Push per-instance data:
@@ -1048,7 +1270,7 @@ void MinimalPbrRenderer::OutlinePass(VkCommandBuffer cmd, SceneKey highlightedOb
             mOutlinePipeline.PushConstants(cmd, data);
 
             // Draw:
-            drawable.Draw(cmd);
+            drawable.Draw(cmd, 0);
         }
 
         vkCmdEndRendering(cmd);
@@ -1094,31 +1316,40 @@ void MinimalPbrRenderer::RenderObjectId(VkCommandBuffer cmd, float x, float y)
 
     DrawStats stats;
 
-    DrawSingleSidedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback,
-                                 stats);
-    DrawDoubleSidedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback,
-                                 stats);
-    DrawBlendedFrustumCulled(cmd, viewProj, materialCallback, instanceCallback, stats);
+    // Picking always uses full detail geometry:
+    DrawSingleSidedFrustumCulled(cmd, viewProj, std::nullopt, materialCallback,
+                                 instanceCallback, stats);
+    DrawDoubleSidedFrustumCulled(cmd, viewProj, std::nullopt, materialCallback,
+                                 instanceCallback, stats);
+    DrawBlendedFrustumCulled(cmd, viewProj, std::nullopt, materialCallback,
+                             instanceCallback, stats);
 }
 
 void MinimalPbrRenderer::LoadScene(const Scene &scene)
 {
     if (scene.FullReloadRequested())
     {
-        for (auto &[_, drawable] : mDrawables)
+        for (auto [_, drawable] : mDrawables)
             drawable.Destroy(mCtx);
 
-        for (auto &[_, texture] : mTextures)
+        for (auto [_, texture] : mTextures)
             DestroyTexture(texture);
 
-        mDrawables.clear();
-        mMaterials.clear();
-        mTextures.clear();
+        mDrawables.Clear();
+        mMeshDrawables.Clear();
+        mMaterials.Clear();
+        mTextures.Clear();
 
         mMaterialDescriptorAllocator.DestroyPools();
     }
 
-    if (scene.UpdateMeshesRequested())
+    // Meshes which only got new primitives are patched in place,
+    // requested reloads go through all of them instead:
+    const bool meshesChanged = scene.MeshesChanged();
+    const bool reloadMeshes =
+        scene.UpdateMeshesRequested() || scene.UpdateMeshMaterialsRequested();
+
+    if (scene.UpdateMeshesRequested() || (meshesChanged && reloadMeshes))
         LoadMeshes(scene);
 
     if (scene.UpdateImagesRequested())
@@ -1127,64 +1358,111 @@ void MinimalPbrRenderer::LoadScene(const Scene &scene)
     if (scene.UpdateMaterialsRequested())
         LoadMaterials(scene);
 
-    if (scene.UpdateMeshMaterialsRequested())
+    // New drawables are sorted by material, so they go after materials:
+    if (reloadMeshes)
         LoadMeshMaterials(scene);
+    else if (meshesChanged)
+        UpdateMeshes(scene);
 
     if (scene.UpdateObjectsRequested())
         LoadObjects(scene);
+    else if (scene.ObjectsChanged() || meshesChanged)
+        UpdateObjects(scene);
 
     if (scene.UpdateEnvironmentRequested())
         mEnvHandler.LoadEnvironment(scene);
 }
 
 void MinimalPbrRenderer::LoadMeshes(const Scene &scene)
+{
+    // Prune drawables of erased meshes first, new meshes may reuse their slots:
+    const size_t pruned = mMeshDrawables.EraseIf([&](SceneKey meshKey, auto &keys) {
+        if (scene.Meshes.Contains(meshKey))
+            return false;
+
+        for (auto key : keys)
+        {
+            if (!key.has_value())
+                continue;
+
+            mDrawables[*key].Destroy(mCtx);
+            mDrawables.Erase(*key);
+        }
+
+        return true;
+    });
+
+    if (pruned > 0)
+    {
+        auto Orphaned = [&](DrawableKey key) { return !mDrawables.Contains(key); };
+
+        std::erase_if(mSingleSidedDrawableKeys, Orphaned);
+        std::erase_if(mDoubleSidedDrawableKeys, Orphaned);
+        std::erase_if(mBlendedDrawableKeys, Orphaned);
+    }
+
+    for (const auto [meshKey, mesh] : scene.Meshes)
+        LoadMesh(meshKey, mesh);
+}
+
+std::vector<size_t> MinimalPbrRenderer::LoadMesh(SceneKey meshKey, const SceneMesh &mesh)
 {
     using namespace std::views;
 
-    for (const auto &[meshKey, mesh] : scene.Meshes)
+    std::vector<size_t> loaded;
+
+    auto &drawableKeys = mMeshDrawables.FindOrEmplace(meshKey);
+    drawableKeys.resize(mesh.Primitives.size());
+
+    for (const auto [primIdx, prim] : enumerate(mesh.Primitives))
     {
-        for (const auto [primIdx, prim] : enumerate(mesh.Primitives))
-        {
-            auto drawableKey = DrawableKey{meshKey, primIdx};
+        // Already imported:
+        if (drawableKeys[primIdx].has_value())
+            continue;
 
-            // Already imported:
-            if (mDrawables.count(drawableKey) != 0)
-                continue;
+        // Still being loaded:
+        if (prim.Data.VertexCount == 0)
+            continue;
 
-            if (mGeometryLayout == prim.Data.Layout)
-            {
-                const auto debugName = mesh.Name + std::to_string(primIdx);
+        if (mVertexLayout == prim.Data.Layout.VertexLayout)
+        {
+            const auto debugName = mesh.Name + std::to_string(primIdx);
 
-                auto &drawable = mDrawables[drawableKey];
-                drawable.Init(mCtx, prim, debugName);
-            }
+            auto [drawableKey, drawable] = mDrawables.Emplace();
+            drawable.Init(mCtx, prim, debugName);
+
+            drawableKeys[primIdx] = drawableKey;
+            loaded.push_back(primIdx);
         }
     }
 
-    // Prune orphaned drawables:
-    std::erase_if(mDrawables, [&](auto &item) {
-        auto &drawable = item.second;
+    return loaded;
+}
 
-        auto meshKey = item.first.first;
-        bool erase   = scene.Meshes.count(meshKey) == 0;
+void MinimalPbrRenderer::LoadImages(const Scene &scene)
+{
+    // Prune orphaned textures first, new images may reuse their slots:
+    mTextures.EraseIf([&](SceneKey key, const Texture &img) {
+        bool erase = !scene.Images.Contains(key);
 
         if (erase)
-            drawable.Destroy(mCtx);
+            DestroyTexture(img);
 
         return erase;
     });
-}
 
-void MinimalPbrRenderer::LoadImages(const Scene &scene)
-{
-    for (auto &[key, imgData] : scene.Images)
+    for (const auto [key, imgData] : scene.Images)
     {
-        const bool alreadyLoaded = mTextures.count(key) != 0;
+        // Still being decoded:
+        if (imgData.Data == nullptr)
+            continue;
+
+        const bool alreadyLoaded = mTextures.Contains(key);
 
         if (alreadyLoaded && imgData.IsUpToDate)
             continue;
 
-        auto &texture = mTextures[key];
+        auto &texture = mTextures.FindOrEmplace(key);
 
         if (alreadyLoaded)
         {
@@ -1194,27 +1472,14 @@ void MinimalPbrRenderer::LoadImages(const Scene &scene)
         texture            = MakeTexture::FromData(mCtx, "MaterialTexture", imgData);
         imgData.IsUpToDate = true;
     }
-
-    // Prune orphaned textures:
-    std::erase_if(mTextures, [&](const auto &item) {
-        auto &key = item.first;
-        auto &img = item.second;
-
-        bool erase = scene.Images.count(key) == 0;
-
-        if (erase)
-            DestroyTexture(img);
-
-        return erase;
-    });
 }
 
 void MinimalPbrRenderer::LoadMaterials(const Scene &scene)
 {
-    for (auto &[key, sceneMat] : scene.Materials)
+    for (const auto [key, sceneMat] : scene.Materials)
     {
-        const bool firstLoad = mMaterials.count(key) == 0;
-        auto      &mat       = mMaterials[key];
+        const bool firstLoad = !mMaterials.Contains(key);
+        auto      &mat       = mMaterials.FindOrEmplace(key);
 
         // Only allocate new descriptor set on first load:
         if (firstLoad)
@@ -1242,8 +1507,8 @@ void MinimalPbrRenderer::LoadMaterials(const Scene &scene)
         auto GetTexture = [&](std::optional<SceneKey> opt, Texture &def) -> Texture & {
             if (opt.has_value())
             {
-                if (mTextures.count(*opt) != 0)
-                    return mTextures[*opt];
+                if (auto *texture = mTextures.Find(*opt))
+                    return *texture;
             }
 
             return def;
@@ -1271,36 +1536,53 @@ void MinimalPbrRenderer::LoadMeshMaterials(const Scene &scene)
     mDoubleSidedDrawableKeys.clear();
     mBlendedDrawableKeys.clear();
 
-    for (const auto &[meshKey, mesh] : scene.Meshes)
+    for (const auto [meshKey, mesh] : scene.Meshes)
     {
         for (const auto [primIdx, prim] : enumerate(mesh.Primitives))
         {
-            auto drawableKey = DrawableKey{meshKey, primIdx};
-
-            if (mDrawables.count(drawableKey) != 0)
-            {
-                auto  matKey = *prim.Material;
-                auto &mat    = mMaterials[matKey];
-
-                auto &drawable = mDrawables[drawableKey];
-
-                if (prim.Material)
-                    drawable.MaterialKey = matKey;
-
-                if (mat.UboData.AlphaMode == MaterialAlphaMode::Blend)
-                    mBlendedDrawableKeys.push_back(drawableKey);
-                else
-                {
-                    if (mat.UboData.DoubleSided)
-                        mDoubleSidedDrawableKeys.push_back(drawableKey);
-                    else
-                        mSingleSidedDrawableKeys.push_back(drawableKey);
-                }
-            }
+            if (auto drawableKey = FindDrawable(meshKey, primIdx))
+                AssignMaterial(*drawableKey, prim);
         }
     }
 }
 
+void MinimalPbrRenderer::AssignMaterial(DrawableKey           drawableKey,
+                                        const ScenePrimitive &prim)
+{
+    auto  matKey = *prim.Material;
+    auto &mat    = mMaterials[matKey];
+
+    auto &drawable = mDrawables[drawableKey];
+
+    if (prim.Material)
+        drawable.MaterialKey = matKey;
+
+    if (mat.UboData.AlphaMode == MaterialAlphaMode::Blend)
+        mBlendedDrawableKeys.push_back(drawableKey);
+    else
+    {
+        if (mat.UboData.DoubleSided)
+            mDoubleSidedDrawableKeys.push_back(drawableKey);
+        else
+            mSingleSidedDrawableKeys.push_back(drawableKey);
+    }
+}
+
+void MinimalPbrRenderer::UpdateMeshes(const Scene &scene)
+{
+    for (auto meshKey : scene.GetMeshChanges())
+    {
+        const auto *mesh = scene.Meshes.Find(meshKey);
+
+        // Erased since, pruned by the next full reload:
+        if (mesh == nullptr)
+            continue;
+
+        for (auto primIdx : LoadMesh(meshKey, *mesh))
+            AssignMaterial(*FindDrawable(meshKey, primIdx), mesh->Primitives[primIdx]);
+    }
+}
+
 void MinimalPbrRenderer::LoadObjects(const Scene &scene)
 {
     using namespace std::views;
@@ -1309,38 +1591,198 @@ void MinimalPbrRenderer::LoadObjects(const Scene &scene)
     mSceneAABB = scene.TotalAABB;
 
     // Load all object transforms and build object index cache:
-    mObjectCache.clear();
+    mObjectCache.Clear();
+
+    // Instance ids of the selected drawables change as well:
+    mLastHighlightedObjKey = std::nullopt;
 
-    for (auto &[_, drawable] : mDrawables)
+    for (auto [_, drawable] : mDrawables)
         drawable.Instances.clear();
 
-    for (const auto &[objKey, obj] : scene.Objects)
+    for (const auto [objKey, obj] : scene.Objects)
+        AddInstances(scene, objKey, obj);
+
+    // Building the tree at once is much faster than inserting each instance:
+    std::vector<DynamicBvh::Item>   items;
+    std::vector<DynamicBvh::NodeId> leaves;
+
+    for (const auto [drawableKey, drawable] : mDrawables)
+    {
+        for (const auto [idx, instance] : enumerate(drawable.Instances))
+        {
+            items.push_back(DynamicBvh::Item{
+                .Box   = instance.WorldBounds,
+                .Value = PackInstance(drawableKey, idx),
+            });
+        }
+    }
+
+    leaves.resize(items.size());
+    mInstanceTree.Build(items, leaves);
+
+    auto leaf = leaves.begin();
+
+    for (auto [_, drawable] : mDrawables)
+    {
+        for (auto &instance : drawable.Instances)
+            instance.TreeLeaf = *leaf++;
+    }
+
+    mCulledViews = 0;
+}
+
+void MinimalPbrRenderer::UpdateObjects(const Scene &scene)
+{
+    mSceneAABB = scene.TotalAABB;
+
+    // Instance ids may change, earlier culling results are stale:
+    mCulledViews = 0;
+
+    for (const auto &[objKey, event] : scene.GetObjectChanges())
+    {
+        switch (event)
+        {
+        case Scene::ObjectEvent::Added:
+            AddInstances(scene, objKey, scene.Objects[objKey]);
+            InsertInstanceLeaves(objKey);
+            break;
+        case Scene::ObjectEvent::Removed:
+            RemoveInstances(objKey);
+            break;
+        case Scene::ObjectEvent::Modified:
+            UpdateInstances(objKey, scene.Objects[objKey]);
+            break;
+        }
+    }
+
+    // Objects of meshes with new primitives need instances of these as well:
+    for (auto meshKey : scene.GetMeshChanges())
     {
-        if (!obj.Mesh.has_value())
+        for (auto objKey : scene.GetMeshObjects(meshKey))
+        {
+            RemoveInstances(objKey);
+            AddInstances(scene, objKey, scene.Objects[objKey]);
+            InsertInstanceLeaves(objKey);
+        }
+    }
+}
+
+void MinimalPbrRenderer::AddInstances(const Scene &scene, SceneKey objKey,
+                                      const SceneObject &obj)
+{
+    using namespace std::views;
+
+    if (!obj.Mesh.has_value())
+        return;
+
+    auto meshKey = *obj.Mesh;
+
+    for (const auto [primIdx, _] : enumerate(scene.Meshes[meshKey].Primitives))
+    {
+        auto drawableKey = FindDrawable(meshKey, primIdx);
+
+        if (!drawableKey.has_value())
+        {
             continue;
+        }
+
+        auto &drawable = mDrawables[*drawableKey];
+
+        auto &list = mObjectCache.FindOrEmplace(objKey);
+        list.emplace_back(*drawableKey, drawable.Instances.size());
+
+        glm::mat4 transform = obj.Transform;
+
+        drawable.Instances.emplace_back(
+            objKey, transform, transform * drawable.BaseTransform,
+            drawable.Bbox.GetConservativeTransformedAABB(transform));
+    }
+}
+
+void MinimalPbrRenderer::RemoveInstances(SceneKey objKey)
+{
+    auto *list = mObjectCache.Find(objKey);
+
+    if (list == nullptr)
+        return;
 
-        auto meshKey = *obj.Mesh;
+    for (const auto &[drawableKey, instanceIdx] : *list)
+    {
+        auto &instances = mDrawables[drawableKey].Instances;
+
+        mInstanceTree.Remove(instances[instanceIdx].TreeLeaf);
 
-        for (const auto [primIdx, prim] : enumerate(scene.Meshes.at(meshKey).Primitives))
+        const size_t lastIdx = instances.size() - 1;
+
+        // Last instance takes the place of the removed one,
+        // so its cached index has to follow:
+        if (instanceIdx != lastIdx)
         {
-            auto drawableKey = DrawableKey{meshKey, primIdx};
+            instances[instanceIdx] = instances[lastIdx];
+
+            mInstanceTree.SetValue(instances[instanceIdx].TreeLeaf,
+                                   PackInstance(drawableKey, instanceIdx));
 
-            if (mDrawables.count(drawableKey) == 0)
+            for (auto &[key, idx] : mObjectCache[instances[instanceIdx].ObjectId])
             {
-                continue;
+                if (key == drawableKey && idx == lastIdx)
+                    idx = instanceIdx;
             }
+        }
 
-            auto &drawable = mDrawables[drawableKey];
+        instances.pop_back();
+    }
 
-            auto &list = mObjectCache[objKey];
-            list.emplace_back(drawableKey, drawable.Instances.size());
+    mObjectCache.Erase(objKey);
 
-            glm::mat4 transform = obj.Transform;
+    // Instance ids of the selected drawables may have moved:
+    mLastHighlightedObjKey = std::nullopt;
+}
 
-            glm::mat4 base = glm::translate(glm::mat4(1.0f), prim.BaseOffset) *
-                             glm::scale(glm::mat4(1.0f), prim.BaseScale);
+void MinimalPbrRenderer::UpdateInstances(SceneKey objKey, const SceneObject &obj)
+{
+    auto *list = mObjectCache.Find(objKey);
 
-            drawable.Instances.emplace_back(objKey, transform, transform * base);
-        }
+    if (list == nullptr)
+        return;
+
+    for (const auto &[drawableKey, instanceIdx] : *list)
+    {
+        auto &drawable = mDrawables[drawableKey];
+        auto &instance = drawable.Instances[instanceIdx];
+
+        instance.Transform    = obj.Transform;
+        instance.TransformRaw = obj.Transform * drawable.BaseTransform;
+        instance.WorldBounds =
+            drawable.Bbox.GetConservativeTransformedAABB(obj.Transform);
+
+        mInstanceTree.Update(instance.TreeLeaf, instance.WorldBounds);
     }
-}
\ No newline at end of file
+}
+
+void MinimalPbrRenderer::InsertInstanceLeaves(SceneKey objKey)
+{
+    auto *list = mObjectCache.Find(objKey);
+
+    if (list == nullptr)
+        return;
+
+    for (const auto &[drawableKey, instanceIdx] : *list)
+    {
+        auto &instance = mDrawables[drawableKey].Instances[instanceIdx];
+
+        instance.TreeLeaf = mInstanceTree.Insert(instance.WorldBounds,
+                                                 PackInstance(drawableKey, instanceIdx));
+    }
+}
+
+std::optional<MinimalPbrRenderer::DrawableKey> MinimalPbrRenderer::FindDrawable(
+    SceneKey meshKey, size_t primIdx) const
+{
+    const auto *drawableKeys = mMeshDrawables.Find(meshKey);
+
+    if (drawableKeys == nullptr || primIdx >= drawableKeys->size())
+        return std::nullopt;
+
+    return (*drawableKeys)[primIdx];
+}
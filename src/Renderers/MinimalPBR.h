@@ -3,6 +3,7 @@
 #include "AOHandler.h"
 #include "DeletionQueue.h"
 #include "Descriptor.h"
+#include "DynamicBvh.h"
 #include "DynamicUniformBuffer.h"
 #include "EnvironmentHandler.h"
 #include "GeometryData.h"
@@ -11,10 +12,13 @@
 #include "Renderer.h"
 #include "Scene.h"
 #include "ShadowmapHandler.h"
+#include "SlotMap.h"
 #include "Texture.h"
 #include "VertexLayout.h"
 #include "VulkanContext.h"
 
+#include <unordered_map>
+
 class MinimalPbrRenderer final : public IRenderer {
   public:
     MinimalPbrRenderer(VulkanContext &ctx, FrameInfo &info, Camera &camera);
@@ -64,6 +68,10 @@ class MinimalPbrRenderer final : public IRenderer {
         // dependent on used vertex compression, and is
         // only supplied to final drawing shaders:
         glm::mat4 TransformRaw;
+        // World space bounds of the primitive, cached for culling:
+        AABB WorldBounds;
+        // Leaf of the bounds in the instance tree:
+        DynamicBvh::NodeId TreeLeaf = DynamicBvh::Null;
     };
 
     // TODO: This will be remade in RAII fashion when VulkanContext is reworked as a
@@ -75,30 +83,62 @@ class MinimalPbrRenderer final : public IRenderer {
                   const std::string &debugName);
         void Destroy(VulkanContext &ctx);
 
-        bool EarlyBail(glm::mat4 viewProj);
-        bool IsVisible(glm::mat4 viewProj, size_t instanceIdx);
+        bool IsVisible(const Frustum &frustum, size_t instanceIdx);
+        // Coarsest level whose simplification error, projected onto
+        // a target of given resolution, stays under pixelError:
+        size_t SelectLod(glm::mat4 viewProj, size_t instanceIdx, glm::vec2 resolution,
+                         float pixelError);
         void BindGeometryBuffers(VkCommandBuffer cmd);
-        void Draw(VkCommandBuffer cmd);
+        void Draw(VkCommandBuffer cmd, size_t lod);
+
+        [[nodiscard]] uint32_t GetIndexCount(size_t lod) const;
 
         Buffer   VertexBuffer;
         uint32_t VertexCount;
 
-        Buffer   IndexBuffer;
-        uint32_t IndexCount;
+        Buffer      IndexBuffer;
+        uint32_t    IndexCount;
+        VkIndexType IndexType;
+
+        // Coarser index ranges, Lods[i] is level i + 1 of the geometry:
+        std::vector<GeometryLod> Lods;
+
+        // Clusters of the full detail geometry, each a contiguous
+        // range of the index buffer:
+        std::vector<Meshlet> Meshlets;
 
         VkDeviceAddress VertexAddress;
 
         AABB      Bbox;
         glm::vec2 TexBoundsCenter = glm::vec2(0.5f);
         glm::vec2 TexBoundsExtent = glm::vec2(0.5f);
+        // Position range remapping of compressed vertex formats:
+        glm::mat4 BaseTransform   = glm::mat4(1.0f);
 
         SceneKey              MaterialKey = 0;
         std::vector<Instance> Instances;
     };
 
-    // Drawables correspond to mesh primitives
-    // so DrawableKey is the pair (MeshKey, PrimitiveId)
-    using DrawableKey = std::pair<SceneKey, size_t>;
+    // Drawables correspond to mesh primitives, see mMeshDrawables:
+    using DrawableKey = SlotKey;
+
+    // Indirect draws of the visible meshlets of an instance:
+    struct MeshletDraws {
+        VkDeviceSize Offset;
+        uint32_t     DrawCount;
+        uint32_t     IndexCount;
+    };
+
+    // Instances inside the frustum of a view, grouped by drawable:
+    struct ViewVisibility {
+        glm::mat4                           ViewProj;
+        SecondaryMap<std::vector<uint32_t>> Instances;
+        // Cleared by passes drawing full index ranges in this view:
+        bool CullMeshlets = true;
+        // Meshlet draws by packed instance id, none if the whole range is
+        // drawn. Passes sharing the view compact each instance only once:
+        std::unordered_map<uint64_t, std::optional<MeshletDraws>> Meshlets;
+    };
 
   private:
     void LoadMeshes(const Scene &scene);
@@ -106,8 +146,35 @@ class MinimalPbrRenderer final : public IRenderer {
     void LoadMaterials(const Scene &scene);
     void LoadMeshMaterials(const Scene &scene);
     void LoadObjects(const Scene &scene);
+    // Uploads new primitives of the changed meshes only:
+    void UpdateMeshes(const Scene &scene);
+    // Patches instances of the changed objects only:
+    void UpdateObjects(const Scene &scene);
+
+    // Creates drawables of loaded primitives which don't have
+    // one yet, returns indices of these primitives:
+    std::vector<size_t> LoadMesh(SceneKey meshKey, const SceneMesh &mesh);
+    // Sets the material of the drawable and adds it to the matching draw list:
+    void AssignMaterial(DrawableKey drawableKey, const ScenePrimitive &prim);
+
+    // Leaves of new instances are inserted separately, full
+    // reloads build the instance tree at once instead:
+    void AddInstances(const Scene &scene, SceneKey objKey, const SceneObject &obj);
+    void InsertInstanceLeaves(SceneKey objKey);
+    void RemoveInstances(SceneKey objKey);
+    void UpdateInstances(SceneKey objKey, const SceneObject &obj);
+
+    // Culls the instance tree once per view and frame, passes
+    // sharing the view matrix reuse the visible lists:
+    ViewVisibility &CullView(glm::mat4 viewProj);
+
+    // Drawable of a mesh primitive, none if it isn't loaded:
+    [[nodiscard]] std::optional<DrawableKey> FindDrawable(SceneKey meshKey,
+                                                          size_t   primIdx) const;
 
     [[nodiscard]] VkCompareOp GetMainCompareOp() const;
+    // Resolution used for LOD selection, none if LODs are disabled:
+    [[nodiscard]] std::optional<glm::vec2> GetLodResolution(VkExtent2D extent) const;
 
     void ShadowPass(VkCommandBuffer cmd, DrawStats &stats);
     void Prepass(VkCommandBuffer cmd, DrawStats &stats);
@@ -116,23 +183,35 @@ class MinimalPbrRenderer final : public IRenderer {
 
     void DestroyTexture(const Texture &texture);
 
+    // Writes a draw command for each run of consecutive meshlets visible in
+    // given instance. Returns nullopt if the whole index range should be drawn:
+    std::optional<MeshletDraws> CompactMeshlets(const Drawable &drawable,
+                                                glm::mat4       viewProj,
+                                                size_t          instanceIdx,
+                                                bool            cullBackfaces);
+
     template <typename MaterialFn, typename InstanceFn>
-    void DrawAllInstancesCulled(VkCommandBuffer cmd, Drawable &drawable,
-                                glm::mat4 viewProj, MaterialFn materialCallback,
+    void DrawAllInstancesCulled(VkCommandBuffer cmd, DrawableKey drawableKey,
+                                glm::mat4                viewProj,
+                                std::optional<glm::vec2> lodResolution,
+                                MaterialFn               materialCallback,
                                 InstanceFn instanceCallback, DrawStats &stats);
 
     template <typename MaterialFn, typename InstanceFn>
     void DrawSingleSidedFrustumCulled(VkCommandBuffer cmd, glm::mat4 viewProj,
+                                      std::optional<glm::vec2> lodResolution,
                                       MaterialFn materialCallback,
                                       InstanceFn instanceCallback, DrawStats &stats);
 
     template <typename MaterialFn, typename InstanceFn>
     void DrawDoubleSidedFrustumCulled(VkCommandBuffer cmd, glm::mat4 viewProj,
+                                      std::optional<glm::vec2> lodResolution,
                                       MaterialFn materialCallback,
                                       InstanceFn instanceCallback, DrawStats &stats);
 
     template <typename MaterialFn, typename InstanceFn>
     void DrawBlendedFrustumCulled(VkCommandBuffer cmd, glm::mat4 viewProj,
+                                  std::optional<glm::vec2> lodResolution,
                                   MaterialFn materialCallback,
                                   InstanceFn instanceCallback, DrawStats &stats);
 
@@ -149,19 +228,17 @@ class MinimalPbrRenderer final : public IRenderer {
     Texture     mDepthStencilBuffer;
     VkImageView mDepthOnlyView;
 
-    // Supported geometry specification:
-    static constexpr VkIndexType IndexType = VK_INDEX_TYPE_UINT32;
-
-    GeometryLayout mGeometryLayout{
-        //.VertexLayout = Vertex::PullLayout::Naive,
-        .VertexLayout = Vertex::PullLayout::Compressed,
-        .IndexType    = IndexType,
-    };
+    // Supported vertex layout, index type is handled per drawable:
+    // Vertex::Layout mVertexLayout = Vertex::PullLayout::Naive;
+    Vertex::Layout mVertexLayout = Vertex::PullLayout::Compressed;
 
     // Some renderer settings:
     bool                  mEnablePrepass           = true;
     bool                  mEnableAO                = false;
     float                 mInternalResolutionScale = 1.0f;
+    bool                  mEnableLods              = true;
+    bool                  mCullMeshlets            = true;
+    float                 mLodPixelError           = 1.0f;
     VkSampleCountFlagBits mMultisample             = VK_SAMPLE_COUNT_1_BIT;
 
     // Graphics pipelines:
@@ -225,6 +302,12 @@ class MinimalPbrRenderer final : public IRenderer {
     DynamicUniformBuffer mCamDynamicUBO;
     DynamicUniformBuffer mDynamicUBO;
 
+    // Draw commands of visible meshlet runs, written anew each frame:
+    static constexpr VkDeviceSize MeshletDrawBufferSize = 4 * 1024 * 1024;
+
+    DynamicIndirectBuffer                     mMeshletDraws;
+    std::vector<VkDrawIndexedIndirectCommand> mMeshletRuns;
+
     DynamicDescriptorSet mDynamicDS;
 
     // Auxiliary descriptor sets for other textures (ao, shadows):
@@ -246,9 +329,13 @@ class MinimalPbrRenderer final : public IRenderer {
     Texture mDefaultNormal;
 
     // Containers into which scene resources are loaded:
-    std::map<SceneKey, Texture>     mTextures;
-    std::map<SceneKey, Material>    mMaterials;
-    std::map<DrawableKey, Drawable> mDrawables;
+    SecondaryMap<Texture>  mTextures;
+    SecondaryMap<Material> mMaterials;
+    SlotMap<Drawable>      mDrawables;
+
+    // Drawables of each mesh, indexed by primitive id. Primitives
+    // which are still being loaded don't have one yet:
+    SecondaryMap<std::vector<std::optional<DrawableKey>>> mMeshDrawables;
 
     // More granular drawable subset for various tasks:
 
@@ -269,7 +356,17 @@ class MinimalPbrRenderer final : public IRenderer {
     std::vector<std::pair<DrawableKey, size_t>> mSelectedDrawableKeys;
 
     // Index cache for retrieving drawables and transform ids based on object id:
-    std::map<SceneKey, std::vector<std::pair<DrawableKey, size_t>>> mObjectCache;
+    SecondaryMap<std::vector<std::pair<DrawableKey, size_t>>> mObjectCache;
+
+    // World bounds of all instances, leaf values pack drawable key and instance id.
+    // Only used for culling, other subsystems query the scene's object tree:
+    DynamicBvh mInstanceTree;
+
+    // Views culled this frame are the first mCulledViews, the rest
+    // only keep memory of their lists for the next frame:
+    std::vector<ViewVisibility> mViews;
+    size_t                      mCulledViews = 0;
+    std::vector<uint64_t>       mVisibleInstances;
 
     // Submodules for specific tasks:
 
@@ -0,0 +1,286 @@
+#include "Pch.h"
+
+#include "AssetManager.h"
+#include "CookedModel.h"
+#include "ModelConfig.h"
+#include "Scene.h"
+#include "SceneGraph.h"
+#include "Timer.h"
+#include "VertexLayout.h"
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <ranges>
+#include <span>
+#include <string_view>
+#include <thread>
+
+// Headless cooking of all gltf models in a directory tree. Models go through
+// the same asset manager pipeline as in the application, which stores cooked
+// models (and compressed textures) in the cache directories relative to the
+// working directory. Import options are a part of the cache keys, so they
+// have to match the ones the application loads the models with.
+
+struct CookerOptions {
+    std::filesystem::path Root;
+    ModelConfig           Config;
+    // Models loaded together. Each batch gets a fresh scene,
+    // so that memory use doesn't grow with the size of the tree:
+    size_t BatchSize = 8;
+};
+
+struct CookJob {
+    SceneGraphNode                    Root;
+    bool                              IsReady = false;
+    std::vector<PrimitiveDiagnostics> Diagnostics;
+    AssetManager::ModelJobId          Id = 0;
+};
+
+static void PrintUsage()
+{
+    std::cout << "Usage: AssetCooker <directory> [options]\n"
+                 "  --layout <push|naive|compressed>  vertex layout (compressed)\n"
+                 "  --attributes <list>               push layout attributes, any of\n"
+                 "                                    texcoord,normal,tangent,color\n"
+                 "  --tangents <fast|mikktspace>      tangent generator (mikktspace)\n"
+                 "  --no-roughness                    skip roughness/metallic textures\n"
+                 "  --no-normal                       skip normal textures\n"
+                 "  --compress-textures               block-compress textures\n"
+                 "  --optimize                        optimize meshes\n"
+                 "  --lods                            generate levels of detail\n"
+                 "  --meshlets                        build meshlets\n"
+                 "  --batch <n>                       models loaded together (8)\n";
+}
+
+static bool ParseAttributes(std::string_view list, Vertex::PushLayout &layout)
+{
+    for (const auto part : std::views::split(list, ','))
+    {
+        const std::string_view name(part.begin(), part.end());
+
+        if (name == "texcoord")
+            layout.HasTexCoord = true;
+        else if (name == "normal")
+            layout.HasNormal = true;
+        else if (name == "tangent")
+            layout.HasTangent = true;
+        else if (name == "color")
+            layout.HasColor = true;
+        else
+            return false;
+    }
+
+    return true;
+}
+
+static std::optional<CookerOptions> ParseOptions(int argc, char *argv[])
+{
+    CookerOptions res{};
+
+    // Cooker waits for whole models, and never loads the cooked ones:
+    res.Config.Progressive       = false;
+    res.Config.UseCache          = true;
+    res.Config.BenchmarkTangents = false;
+
+    std::optional<Vertex::PushLayout> pushLayout;
+
+    auto Fail = [](std::string_view message) {
+        std::cerr << message << '\n';
+        PrintUsage();
+        return std::nullopt;
+    };
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string_view arg = argv[i];
+
+        // Options with a value:
+        auto NextValue = [&]() -> std::optional<std::string_view> {
+            if (i + 1 >= argc)
+                return std::nullopt;
+
+            return argv[++i];
+        };
+
+        if (arg == "--layout")
+        {
+            const auto value = NextValue();
+
+            if (value == "push")
+                pushLayout = Vertex::PushLayout{};
+            else if (value == "naive")
+                res.Config.VertexLayout = Vertex::PullLayout::Naive;
+            else if (value == "compressed")
+                res.Config.VertexLayout = Vertex::PullLayout::Compressed;
+            else
+                return Fail("Invalid vertex layout!");
+        }
+        else if (arg == "--attributes")
+        {
+            const auto value = NextValue();
+
+            if (!pushLayout || !value || !ParseAttributes(*value, *pushLayout))
+                return Fail("Invalid push layout attributes!");
+        }
+        else if (arg == "--tangents")
+        {
+            const auto value = NextValue();
+
+            if (value == "fast")
+                res.Config.Tangents = TangentMethod::Fast;
+            else if (value == "mikktspace")
+                res.Config.Tangents = TangentMethod::MikkTSpace;
+            else
+                return Fail("Invalid tangent generator!");
+        }
+        else if (arg == "--batch")
+        {
+            const auto value = NextValue().value_or("");
+
+            auto [_, ec] =
+                std::from_chars(value.data(), value.data() + value.size(), res.BatchSize);
+
+            if (ec != std::errc{} || res.BatchSize == 0)
+                return Fail("Invalid batch size!");
+        }
+        else if (arg == "--no-roughness")
+            res.Config.FetchRoughness = false;
+        else if (arg == "--no-normal")
+            res.Config.FetchNormal = false;
+        else if (arg == "--compress-textures")
+            res.Config.CompressTextures = true;
+        else if (arg == "--optimize")
+            res.Config.OptimizeMeshes = true;
+        else if (arg == "--lods")
+            res.Config.GenerateLods = true;
+        else if (arg == "--meshlets")
+            res.Config.BuildMeshlets = true;
+        else if (arg.starts_with("--"))
+            return Fail(std::format("Unknown option: {}", arg));
+        else if (res.Root.empty())
+            res.Root = arg;
+        else
+            return Fail("Only one directory can be cooked at a time!");
+    }
+
+    if (pushLayout)
+        res.Config.VertexLayout = *pushLayout;
+
+    if (res.Root.empty() || !std::filesystem::is_directory(res.Root))
+        return Fail("Missing or invalid directory!");
+
+    return res;
+}
+
+static std::vector<std::filesystem::path> FindModels(const std::filesystem::path &root)
+{
+    std::vector<std::filesystem::path> res;
+
+    for (const auto &entry : std::filesystem::recursive_directory_iterator(root))
+    {
+        if (!entry.is_regular_file())
+            continue;
+
+        const auto ext = entry.path().extension();
+
+        if (ext == ".gltf" || ext == ".glb")
+            res.push_back(entry.path());
+    }
+
+    // Iteration order is unspecified:
+    std::ranges::sort(res);
+
+    return res;
+}
+
+// Loads the models concurrently on the asset manager thread pool,
+// cooked files are written as each of them finishes.
+// Returns number of primitives with import issues:
+static size_t CookBatch(std::span<const std::filesystem::path> paths,
+                        const CookerOptions                   &options)
+{
+    Scene        scene;
+    AssetManager assets(scene);
+
+    std::vector<CookJob> jobs(paths.size());
+
+    for (size_t i = 0; i < paths.size(); i++)
+    {
+        auto &job = jobs[i];
+
+        auto config     = options.Config;
+        config.Filepath = paths[i];
+
+        job.Id = assets.LoadModel(config, job.Root, job.IsReady, job.Diagnostics);
+    }
+
+    auto IsActive = [&](const CookJob &job) { return assets.IsModelActive(job.Id); };
+
+    while (std::ranges::any_of(jobs, IsActive))
+    {
+        assets.OnUpdate();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    size_t issues = 0;
+
+    for (const auto &job : jobs)
+        issues += job.Diagnostics.size();
+
+    return issues;
+}
+
+int main(int argc, char *argv[])
+{
+    try
+    {
+        const auto options = ParseOptions(argc, argv);
+
+        if (!options)
+            return 1;
+
+        auto models = FindModels(options->Root);
+
+        const size_t found = models.size();
+
+        // Cooked files are content addressed, so existing ones are up to date:
+        std::erase_if(models, [&](const auto &path) {
+            auto config     = options->Config;
+            config.Filepath = path;
+
+            const auto key = CookedModel::MakeKey(config);
+
+            return key.has_value() && std::filesystem::exists(key->Path);
+        });
+
+        std::cout << std::format("Found {} models, {} already cooked\n", found,
+                                 found - models.size());
+
+        const auto start = Timer::Now();
+
+        size_t issues = 0;
+
+        for (size_t first = 0; first < models.size(); first += options->BatchSize)
+        {
+            const size_t count = std::min(options->BatchSize, models.size() - first);
+
+            issues += CookBatch(std::span(models).subspan(first, count), *options);
+        }
+
+        const auto time = Timer::GetDiffSeconds(Timer::Now(), start);
+
+        std::cout << std::format("Cooked {} models in {:.2f} [s], {} primitives with "
+                                 "import issues\n",
+                                 models.size(), time, issues);
+    }
+    catch (std::exception &e)
+    {
+        std::cerr << e.what() << '\n';
+        return 1;
+    }
+}
@@ -0,0 +1,247 @@
+#include "Pch.h"
+
+#include "DynamicBvh.h"
+#include "GeometryData.h"
+#include "Timer.h"
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Checks frustum, box and ray queries of the dynamic bvh against brute force
+// over the same boxes, after random inserts, moves and removals. Also times
+// the queries against a linear scan. Exits with 1 if any query differs.
+
+static constexpr uint32_t BoxCount    = 200'000;
+static constexpr size_t   ChurnCount  = 50'000;
+static constexpr size_t   ViewCount   = 20;
+static constexpr size_t   QueryCount  = 200;
+static constexpr float    WorldExtent = 500.0f;
+
+struct BenchBox {
+    AABB               Box;
+    DynamicBvh::NodeId Leaf  = DynamicBvh::Null;
+    bool               Alive = false;
+};
+
+// Flat scene, like a city or a terrain with props:
+static AABB RandomBox(std::mt19937 &rng)
+{
+    std::uniform_real_distribution<float> pos(-WorldExtent, WorldExtent);
+    std::uniform_real_distribution<float> size(0.2f, 3.0f);
+
+    return AABB{
+        .Center = glm::vec3(pos(rng), 0.05f * pos(rng), pos(rng)),
+        .Extent = glm::vec3(size(rng)),
+    };
+}
+
+static bool Overlaps(const AABB &a, const AABB &b)
+{
+    const auto aMin = a.Center - a.Extent, aMax = a.Center + a.Extent;
+    const auto bMin = b.Center - b.Extent, bMax = b.Center + b.Extent;
+
+    return glm::all(glm::lessThanEqual(aMin, bMax)) &&
+           glm::all(glm::lessThanEqual(bMin, aMax));
+}
+
+// Same slab test as the tree, so that results match exactly:
+static std::optional<float> IntersectRay(const AABB &box, glm::vec3 origin,
+                                         glm::vec3 direction, float maxDistance)
+{
+    const auto boxMin = box.Center - box.Extent;
+    const auto boxMax = box.Center + box.Extent;
+
+    float entry = 0.0f;
+    float exit  = maxDistance;
+
+    for (int axis = 0; axis < 3; axis++)
+    {
+        if (direction[axis] == 0.0f)
+        {
+            if (origin[axis] < boxMin[axis] || origin[axis] > boxMax[axis])
+                return std::nullopt;
+
+            continue;
+        }
+
+        const float inv = 1.0f / direction[axis];
+        const float t0  = (boxMin[axis] - origin[axis]) * inv;
+        const float t1  = (boxMax[axis] - origin[axis]) * inv;
+
+        entry = std::max(entry, std::min(t0, t1));
+        exit  = std::min(exit, std::max(t0, t1));
+
+        if (entry > exit)
+            return std::nullopt;
+    }
+
+    return entry;
+}
+
+// Removes, moves slightly or teleports random boxes, revives removed ones:
+static void Churn(DynamicBvh &bvh, std::vector<BenchBox> &boxes, std::mt19937 &rng)
+{
+    for (size_t i = 0; i < ChurnCount; i++)
+    {
+        const auto id  = static_cast<uint32_t>(rng() % boxes.size());
+        auto      &box = boxes[id];
+
+        if (!box.Alive)
+        {
+            box.Box   = RandomBox(rng);
+            box.Leaf  = bvh.Insert(box.Box, id);
+            box.Alive = true;
+            continue;
+        }
+
+        const auto op = rng() % 10;
+
+        if (op == 0)
+        {
+            bvh.Remove(box.Leaf);
+            box.Alive = false;
+            continue;
+        }
+
+        if (op < 5)
+            box.Box.Center += glm::vec3(0.1f);
+        else
+            box.Box.Center = RandomBox(rng).Center;
+
+        bvh.Update(box.Leaf, box.Box);
+    }
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+
+    std::vector<BenchBox>         boxes(BoxCount);
+    std::vector<DynamicBvh::Item> items;
+
+    for (uint32_t id = 0; id < BoxCount; id++)
+    {
+        boxes[id].Box   = RandomBox(rng);
+        boxes[id].Alive = true;
+        items.push_back(DynamicBvh::Item{.Box = boxes[id].Box, .Value = id});
+    }
+
+    DynamicBvh                      bvh;
+    std::vector<DynamicBvh::NodeId> leaves(BoxCount);
+
+    auto start = Timer::Now();
+    bvh.Build(items, leaves);
+    const float buildTime = Timer::GetDiffMili(Timer::Now(), start);
+
+    for (uint32_t id = 0; id < BoxCount; id++)
+        boxes[id].Leaf = leaves[id];
+
+    Churn(bvh, boxes, rng);
+
+    std::cout << std::format("Build of {} boxes: {:.1f} ms, height after churn {}\n",
+                             BoxCount, buildTime, bvh.GetHeight());
+
+    std::uniform_real_distribution<float> pos(-WorldExtent, WorldExtent);
+
+    size_t mismatches = 0;
+
+    // Frustum queries, timed against testing every box:
+    const auto proj = glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 300.0f);
+
+    float treeTime = 0.0f, scanTime = 0.0f;
+
+    std::vector<uint64_t> found, expected;
+
+    for (size_t v = 0; v < ViewCount; v++)
+    {
+        const auto eye    = glm::vec3(0.5f * pos(rng), 10.0f, 0.5f * pos(rng));
+        const auto target = glm::vec3(pos(rng), 0.0f, pos(rng));
+        const auto view   = glm::lookAt(eye, target, glm::vec3(0.0f, 1.0f, 0.0f));
+
+        const auto frustum = Frustum::FromMatrix(proj * view);
+
+        found.clear();
+        expected.clear();
+
+        start = Timer::Now();
+        bvh.QueryFrustum(frustum, found);
+        treeTime += Timer::GetDiffMili(Timer::Now(), start);
+
+        start = Timer::Now();
+
+        for (uint32_t id = 0; id < BoxCount; id++)
+        {
+            if (boxes[id].Alive && frustum.Intersects(boxes[id].Box))
+                expected.push_back(id);
+        }
+
+        scanTime += Timer::GetDiffMili(Timer::Now(), start);
+
+        std::ranges::sort(found);
+        mismatches += found != expected;
+    }
+
+    std::cout << std::format("Frustum query: {:.2f} ms, linear scan {:.2f} ms\n",
+                             treeTime / ViewCount, scanTime / ViewCount);
+
+    // Box and ray queries, only checked:
+    std::vector<DynamicBvh::RayHit> hits;
+
+    for (size_t q = 0; q < QueryCount; q++)
+    {
+        const auto query = AABB{
+            .Center = glm::vec3(pos(rng), 0.0f, pos(rng)),
+            .Extent = glm::vec3(20.0f),
+        };
+
+        found.clear();
+        expected.clear();
+
+        bvh.QueryBox(query, found);
+
+        for (uint32_t id = 0; id < BoxCount; id++)
+        {
+            if (boxes[id].Alive && Overlaps(boxes[id].Box, query))
+                expected.push_back(id);
+        }
+
+        std::ranges::sort(found);
+        mismatches += found != expected;
+
+        const auto origin = glm::vec3(pos(rng), 5.0f, pos(rng));
+        const auto dir    = glm::normalize(glm::vec3(pos(rng), -WorldExtent, pos(rng)));
+
+        hits.clear();
+        bvh.QueryRay(origin, dir, 1000.0f, hits);
+
+        // Nearest first:
+        mismatches += !std::ranges::is_sorted(hits, {}, &DynamicBvh::RayHit::Distance);
+
+        found.clear();
+        expected.clear();
+
+        for (const auto &hit : hits)
+            found.push_back(hit.Value);
+
+        for (uint32_t id = 0; id < BoxCount; id++)
+        {
+            if (boxes[id].Alive && IntersectRay(boxes[id].Box, origin, dir, 1000.0f))
+                expected.push_back(id);
+        }
+
+        std::ranges::sort(found);
+        mismatches += found != expected;
+    }
+
+    std::cout << std::format("Queries differing from brute force: {}\n", mismatches);
+
+    return mismatches == 0 ? 0 : 1;
+}
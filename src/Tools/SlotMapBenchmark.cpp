@@ -0,0 +1,189 @@
+#include "Pch.h"
+
+#include "SlotMap.h"
+#include "Timer.h"
+
+#include <glm/glm.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <format>
+#include <iostream>
+#include <map>
+#include <optional>
+#include <random>
+#include <vector>
+
+// Compares the scene's slot maps with the std::map storage they replaced,
+// on a scene of 100k objects. Each operation is timed separately and
+// the median of a few runs is printed. Build with optimizations.
+
+// Same size as a scene object, 72 bytes:
+struct BenchObject {
+    std::optional<uint32_t> Mesh;
+    glm::mat4               Transform = glm::mat4(1.0f);
+};
+
+struct BenchTimes {
+    float Emplace = 0.0f;
+    float Lookup  = 0.0f;
+    float Iterate = 0.0f;
+    float Erase   = 0.0f;
+};
+
+static constexpr uint32_t ObjectCount = 100'000;
+static constexpr size_t   Runs        = 3;
+
+// Lookups and iteration are repeated, as single passes are too short:
+static constexpr size_t LookupRepeats  = 10;
+static constexpr size_t IterateRepeats = 100;
+
+// Accumulated, so that reads aren't optimized out:
+static float gSink = 0.0f;
+
+static BenchTimes BenchStdMap(std::mt19937 &rng)
+{
+    BenchTimes res;
+
+    std::map<uint32_t, BenchObject> map;
+    std::vector<uint32_t>           keys;
+
+    auto start = Timer::Now();
+
+    for (uint32_t i = 1; i <= ObjectCount; i++)
+    {
+        map[i] = BenchObject{.Mesh = i};
+        keys.push_back(i);
+    }
+
+    res.Emplace = Timer::GetDiffMili(Timer::Now(), start);
+
+    std::ranges::shuffle(keys, rng);
+
+    start = Timer::Now();
+
+    for (size_t r = 0; r < LookupRepeats; r++)
+    {
+        for (auto key : keys)
+            gSink += map.at(key).Transform[0][0];
+    }
+
+    res.Lookup = Timer::GetDiffMili(Timer::Now(), start) / LookupRepeats;
+
+    start = Timer::Now();
+
+    for (size_t r = 0; r < IterateRepeats; r++)
+    {
+        for (auto &[key, obj] : map)
+            gSink += obj.Transform[3][0];
+    }
+
+    res.Iterate = Timer::GetDiffMili(Timer::Now(), start) / IterateRepeats;
+
+    start = Timer::Now();
+
+    for (size_t i = 0; i < keys.size() / 2; i++)
+        map.erase(keys[i]);
+
+    res.Erase = Timer::GetDiffMili(Timer::Now(), start);
+
+    return res;
+}
+
+static BenchTimes BenchSlotMap(std::mt19937 &rng)
+{
+    BenchTimes res;
+
+    SlotMap<BenchObject> map;
+    std::vector<SlotKey> keys;
+
+    auto start = Timer::Now();
+
+    for (uint32_t i = 1; i <= ObjectCount; i++)
+        keys.push_back(map.Emplace(BenchObject{.Mesh = i}).first);
+
+    res.Emplace = Timer::GetDiffMili(Timer::Now(), start);
+
+    std::ranges::shuffle(keys, rng);
+
+    start = Timer::Now();
+
+    for (size_t r = 0; r < LookupRepeats; r++)
+    {
+        for (auto key : keys)
+            gSink += map[key].Transform[0][0];
+    }
+
+    res.Lookup = Timer::GetDiffMili(Timer::Now(), start) / LookupRepeats;
+
+    start = Timer::Now();
+
+    for (size_t r = 0; r < IterateRepeats; r++)
+    {
+        for (auto [key, obj] : map)
+            gSink += obj.Transform[3][0];
+    }
+
+    res.Iterate = Timer::GetDiffMili(Timer::Now(), start) / IterateRepeats;
+
+    start = Timer::Now();
+
+    for (size_t i = 0; i < keys.size() / 2; i++)
+        map.Erase(keys[i]);
+
+    res.Erase = Timer::GetDiffMili(Timer::Now(), start);
+
+    return res;
+}
+
+static BenchTimes Median(std::vector<BenchTimes> runs)
+{
+    auto MedianOf = [&](float BenchTimes::*field) {
+        std::vector<float> values;
+
+        for (const auto &run : runs)
+            values.push_back(run.*field);
+
+        std::ranges::nth_element(values, values.begin() + values.size() / 2);
+        return values[values.size() / 2];
+    };
+
+    return BenchTimes{
+        .Emplace = MedianOf(&BenchTimes::Emplace),
+        .Lookup  = MedianOf(&BenchTimes::Lookup),
+        .Iterate = MedianOf(&BenchTimes::Iterate),
+        .Erase   = MedianOf(&BenchTimes::Erase),
+    };
+}
+
+int main()
+{
+    std::mt19937 rng(1);
+
+    std::vector<BenchTimes> mapRuns, slotRuns;
+
+    for (size_t i = 0; i < Runs; i++)
+    {
+        mapRuns.push_back(BenchStdMap(rng));
+        slotRuns.push_back(BenchSlotMap(rng));
+    }
+
+    const auto map  = Median(mapRuns);
+    const auto slot = Median(slotRuns);
+
+    std::cout << std::format("{:<20}{:>12}{:>12}\n", "", "std::map", "SlotMap");
+    std::cout << std::format("{:<20}{:>9.2f} ms{:>9.2f} ms\n", "emplace 100k", map.Emplace,
+                             slot.Emplace);
+    std::cout << std::format("{:<20}{:>9.2f} ms{:>9.2f} ms\n", "100k random reads",
+                             map.Lookup, slot.Lookup);
+    std::cout << std::format("{:<20}{:>9.2f} ms{:>9.2f} ms\n", "full iteration",
+                             map.Iterate, slot.Iterate);
+    std::cout << std::format("{:<20}{:>9.2f} ms{:>9.2f} ms\n", "erase 50k", map.Erase,
+                             slot.Erase);
+
+    // Keeps the reads alive:
+    if (gSink == 42.0f)
+        std::cout << '\n';
+
+    return 0;
+}
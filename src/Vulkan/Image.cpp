@@ -9,6 +9,7 @@
 
 #include "volk.h"
 
+#include <algorithm>
 #include <cmath>
 
 Image Image::Create(VulkanContext &ctx, const std::string &debugName,
@@ -89,8 +90,9 @@ void Image::UploadToImage(VulkanContext &ctx, Image &img, Image::UploadInfo info
                 region.imageSubresource.mipLevel = lvl;
                 region.bufferOffset              = currentOffset;
 
-                auto width  = img.Info.extent.width >> lvl;
-                auto height = img.Info.extent.height >> lvl;
+                // Levels of non-square images get clamped to a single texel:
+                auto width  = std::max(img.Info.extent.width >> lvl, 1u);
+                auto height = std::max(img.Info.extent.height >> lvl, 1u);
 
                 region.imageExtent.width  = width;
                 region.imageExtent.height = height;
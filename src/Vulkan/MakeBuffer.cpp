@@ -21,6 +21,16 @@ Buffer MakeBuffer::MappedUniform(VulkanContext &ctx, const std::string &debugNam
     return Buffer::Create(ctx, debugName, size, usage, flags);
 }
 
+Buffer MakeBuffer::MappedIndirect(VulkanContext &ctx, const std::string &debugName,
+                                  VkDeviceSize size)
+{
+    auto usage = VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT;
+    auto flags = VMA_ALLOCATION_CREATE_HOST_ACCESS_SEQUENTIAL_WRITE_BIT |
+                 VMA_ALLOCATION_CREATE_MAPPED_BIT;
+
+    return Buffer::Create(ctx, debugName, size, usage, flags);
+}
+
 Buffer MakeBuffer::TransferDST(VulkanContext &ctx, const std::string &debugName,
                                TransferDSTInfo info)
 {
@@ -18,6 +18,8 @@ struct TransferDSTInfo {
 Buffer Staging(VulkanContext &ctx, const std::string &debugName, VkDeviceSize size);
 
 Buffer MappedUniform(VulkanContext &ctx, const std::string &debugName, VkDeviceSize size);
+Buffer MappedIndirect(VulkanContext &ctx, const std::string &debugName,
+                      VkDeviceSize size);
 
 Buffer TransferDST(VulkanContext &ctx, const std::string &debugName,
                    TransferDSTInfo info);
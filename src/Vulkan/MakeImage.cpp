@@ -150,6 +150,7 @@ static VkImageViewCreateInfo GetVkCreateImageViewInfo(View2DInfo info)
     ret.image            = info.Img.Handle;
     ret.format           = info.Img.Info.format;
     ret.subresourceRange = Image::GetDefaultRange(info.Img);
+    ret.components       = info.Swizzle;
 
     if (info.SelectLevel.has_value())
     {
@@ -241,7 +242,8 @@ Texture MakeTexture::FromData(VulkanContext &ctx, const std::string &debugName,
 {
     Texture res{};
     res.Img  = MakeImage::FromData(ctx, debugName, data);
-    res.View = MakeView::View2D(ctx, debugName, {.Img = res.Img});
+    res.View =
+        MakeView::View2D(ctx, debugName, {.Img = res.Img, .Swizzle = data.Swizzle});
 
     return res;
 }
@@ -45,6 +45,7 @@ struct View2DInfo {
     std::optional<uint32_t>           SelectLayer    = std::nullopt;
     std::optional<VkFormat>           FormatOverride = std::nullopt;
     std::optional<VkImageAspectFlags> AspectOverride = std::nullopt;
+    VkComponentMapping                Swizzle        = {};
 };
 
 namespace MakeView